@@ -58,6 +58,10 @@ int main(int argc, char *argv[])
       {
         params.merge = false;
       }
+      if (strcmp(argv[i], "-mm") == 0 || strcmp(argv[i], "--merge-mode") == 0)
+      {
+        params.merge_mode = argv[i + 1];
+      }
       if (strcmp(argv[i], "-d") == 0 || strcmp(argv[i], "--decimate") == 0)
       {
         params.decimate = true;
@@ -66,6 +70,10 @@ int main(int argc, char *argv[])
       {
         sscanf(argv[i + 1], "%d", &params.max_ch_vertex);
       }
+      if (strcmp(argv[i], "-dm") == 0 || strcmp(argv[i], "--decimate-mode") == 0)
+      {
+        params.decimate_mode = argv[i + 1];
+      }
       if (strcmp(argv[i], "-ex") == 0 || strcmp(argv[i], "--extrude") == 0)
       {
         params.extrude = true;
@@ -86,6 +94,14 @@ int main(int argc, char *argv[])
       {
         params.apx_mode = argv[i + 1];
       }
+      if (strcmp(argv[i], "-hm") == 0 || strcmp(argv[i], "--hausdorff-mode") == 0)
+      {
+        params.hb_mode = argv[i + 1];
+      }
+      if (strcmp(argv[i], "-di") == 0 || strcmp(argv[i], "--distance-mode") == 0)
+      {
+        params.dist_mode = argv[i + 1];
+      }
       if (strcmp(argv[i], "-pr") == 0 || strcmp(argv[i], "--prep-resolution") == 0)
       {
         sscanf(argv[i + 1], "%d", &params.prep_resolution);
@@ -117,9 +133,10 @@ int main(int argc, char *argv[])
   if (params.input_model.length() > 4)
   {
     ext = params.input_model.substr(params.input_model.length() - 4);
-    if (ext != ".obj")
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    if (ext != ".obj" && ext != ".stl" && ext != ".ply")
     {
-      logger::critical("Input must be OBJ format!");
+      logger::critical("Input must be OBJ, STL or PLY format!");
       exit(0);
     }
   }
@@ -153,13 +170,18 @@ int main(int argc, char *argv[])
 
   SaveConfig(params);
 
-  m.LoadOBJ(params.input_model);
+  if (!LoadMesh(params.input_model, m))
+  {
+    logger::critical("Failed to load the input mesh!");
+    exit(0);
+  }
   vector<double> bbox = m.Normalize();
   // m.SaveOBJ("normalized.obj");
 
   #if WITH_3RD_PARTY_LIBS
     if (params.preprocess_mode == "auto")
     {
+      WeldVertices(m); // duplicated vertices would otherwise fail the manifold check and force a remesh
       bool is_manifold = IsManifold(m);
       logger::info("Mesh Manifoldness: {}", is_manifold);
       if (!is_manifold)
@@ -168,6 +190,8 @@ int main(int argc, char *argv[])
     else if (params.preprocess_mode == "on")
       ManifoldPreprocess(params, m);
   #else
+    if (params.preprocess_mode == "auto")
+      WeldVertices(m);
     bool is_manifold = IsManifold(m);
     logger::info("Mesh Manifoldness: {}", is_manifold);
     if (!is_manifold)
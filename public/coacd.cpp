@@ -89,6 +89,7 @@ namespace coacd
 
     if (params.preprocess_mode == std::string("auto"))
     {
+      WeldVertices(m);
       bool is_manifold = IsManifold(m);
       logger::info("Mesh Manifoldness: {}", is_manifold);
       if (!is_manifold)
@@ -204,6 +205,7 @@ namespace coacd
 
     if (params.preprocess_mode == std::string("auto"))
     {
+      WeldVertices(m);
       bool is_manifold = IsManifold(m);
       logger::info("Mesh Manifoldness: {}", is_manifold);
       if (!is_manifold)
@@ -287,6 +289,7 @@ namespace coacd
 
     if (params.preprocess_mode == std::string("auto"))
     {
+      WeldVertices(m);
       bool is_manifold = IsManifold(m);
       logger::info("Mesh Manifoldness: {}", is_manifold);
       if (!is_manifold)
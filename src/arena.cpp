@@ -0,0 +1,122 @@
+#include "arena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace coacd
+{
+    // Size of the first chunk of an arena; later chunks double
+    static const size_t ARENA_CHUNK_BYTES = 64 << 10;
+
+    // set and arena of the ArenaBinding in effect on this thread, if any
+    static thread_local ArenaSet *bound_set = nullptr;
+    static thread_local ScratchArena *bound_arena = nullptr;
+
+    static ScratchArena &ThreadArena()
+    {
+        if (bound_arena)
+            return *bound_arena;
+        static thread_local ScratchArena arena;
+        return arena;
+    }
+
+    ScratchArena::~ScratchArena()
+    {
+        for (Chunk &c : chunks)
+            ::operator delete(c.data);
+    }
+
+    void *ScratchArena::do_allocate(size_t bytes, size_t alignment)
+    {
+        allocations++;
+        while (true)
+        {
+            if (current < chunks.size())
+            {
+                Chunk &c = chunks[current];
+                size_t start = (offset + alignment - 1) & ~(alignment - 1);
+                if (start + bytes <= c.size)
+                {
+                    offset = start + bytes;
+                    peak = std::max(peak, passed + offset);
+                    return c.data + start;
+                }
+                if (current + 1 < chunks.size() && chunks[current + 1].size >= bytes + alignment)
+                {
+                    passed += c.size;
+                    current++;
+                    offset = 0;
+                    continue;
+                }
+            }
+
+            // a chunk big enough for the request, placed right after the current one
+            size_t size = std::max(chunks.empty() ? ARENA_CHUNK_BYTES : 2 * chunks.back().size, bytes + alignment);
+            Chunk c = {static_cast<char *>(::operator new(size)), size};
+            chunk_allocations++;
+            if (current < chunks.size())
+            {
+                passed += chunks[current].size;
+                current++;
+            }
+            chunks.insert(chunks.begin() + current, c);
+            offset = 0;
+        }
+    }
+
+    ScratchArena &ArenaSet::Local()
+    {
+        std::thread::id self = std::this_thread::get_id();
+        std::lock_guard<std::mutex> guard(lock);
+        for (auto &entry : arenas)
+            if (entry.first == self)
+                return *entry.second;
+        arenas.emplace_back(self, std::make_unique<ScratchArena>());
+        return *arenas.back().second;
+    }
+
+    ArenaStats ArenaSet::Stats()
+    {
+        ArenaStats stats;
+        std::lock_guard<std::mutex> guard(lock);
+        for (auto &entry : arenas)
+        {
+            stats.allocations += entry.second->allocations;
+            stats.chunks += entry.second->chunk_allocations;
+            stats.peak_bytes = std::max(stats.peak_bytes, entry.second->peak);
+        }
+        return stats;
+    }
+
+    ArenaSet *ArenaSet::Current()
+    {
+        return bound_set;
+    }
+
+    ArenaBinding::ArenaBinding(ArenaSet *set) : previous_set(bound_set), previous(bound_arena)
+    {
+        if (!set)
+            return;
+        bound_set = set;
+        bound_arena = &set->Local();
+    }
+
+    ArenaBinding::~ArenaBinding()
+    {
+        bound_set = previous_set;
+        bound_arena = previous;
+    }
+
+    ArenaScope::ArenaScope() : arena(ThreadArena())
+    {
+        mark = {arena.current, arena.offset, arena.passed};
+    }
+
+    ArenaScope::~ArenaScope()
+    {
+        arena.current = mark.chunk;
+        arena.offset = mark.offset;
+        arena.passed = mark.passed;
+    }
+}
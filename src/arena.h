@@ -0,0 +1,107 @@
+#pragma once
+
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace coacd
+{
+    template <class T>
+    using ScratchVector = std::pmr::vector<T>;
+
+    // Scratch allocations served and chunks taken from the heap by the arenas of an ArenaSet, and the most scratch
+    // memory one thread held at a time
+    struct ArenaStats
+    {
+        size_t allocations = 0, chunks = 0, peak_bytes = 0;
+    };
+
+    // Bump allocator of one thread for the short-lived temporaries of a decomposition. Allocation is a pointer bump
+    // in the current chunk; nothing is freed until the enclosing ArenaScope ends, which rewinds the arena to
+    // where the scope began. The chunks stay for the next scope until the arena is destroyed.
+    class ScratchArena : public std::pmr::memory_resource
+    {
+    public:
+        ScratchArena() {}
+        ~ScratchArena();
+
+    private:
+        friend class ArenaScope;
+        friend class ArenaSet;
+
+        struct Chunk
+        {
+            char *data;
+            size_t size;
+        };
+        struct Mark
+        {
+            size_t chunk, offset, passed;
+        };
+
+        void *do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void *, size_t, size_t) override {}
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+        std::vector<Chunk> chunks;
+        size_t current = 0, offset = 0, passed = 0; // passed: bytes of the chunks before the current one
+        size_t allocations = 0, chunk_allocations = 0, peak = 0;
+    };
+
+    // The arenas of one job, such as a Compute call: every thread that binds the set gets its own arena in it, and
+    // all of them are freed with the set, so concurrent jobs neither share chunks nor mix their statistics
+    class ArenaSet
+    {
+    public:
+        ArenaSet() {}
+        ArenaSet(const ArenaSet &) = delete;
+        ArenaSet &operator=(const ArenaSet &) = delete;
+
+        // Totals over the set's arenas; only call it while no thread is working in the set
+        ArenaStats Stats();
+        // The set bound on the calling thread, or nullptr, to bind the workers of a parallel loop to it
+        static ArenaSet *Current();
+
+    private:
+        friend class ArenaBinding;
+        ScratchArena &Local();
+
+        std::mutex lock;
+        std::vector<std::pair<std::thread::id, std::unique_ptr<ScratchArena>>> arenas;
+    };
+
+    // Makes the calling thread's ArenaScopes take their memory from its arena in set until the binding ends (by
+    // default they use an arena of the thread's own; a null set keeps whatever is bound). Bind at the top of every
+    // parallel loop body of the job, as random_engine is seeded there.
+    class ArenaBinding
+    {
+    public:
+        explicit ArenaBinding(ArenaSet *set);
+        ~ArenaBinding();
+        ArenaBinding(const ArenaBinding &) = delete;
+        ArenaBinding &operator=(const ArenaBinding &) = delete;
+
+    private:
+        ArenaSet *previous_set;
+        ScratchArena *previous;
+    };
+
+    // Opens a scratch scope on the calling thread's arena. Vectors built on resource() must not outlive the scope,
+    // and vectors of an enclosing scope must not grow inside a nested one.
+    class ArenaScope
+    {
+    public:
+        ArenaScope();
+        ~ArenaScope();
+        ArenaScope(const ArenaScope &) = delete;
+        ArenaScope &operator=(const ArenaScope &) = delete;
+
+        std::pmr::memory_resource *resource() { return &arena; }
+
+    private:
+        ScratchArena &arena;
+        ScratchArena::Mark mark;
+    };
+}
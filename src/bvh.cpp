@@ -1,230 +1,543 @@
 #include "bvh.h"
 #include "logger.h"
 
+#include <atomic>
+#include <cfloat>
+
 namespace coacd
 {
-    BVH::BVH(const Model _model)
+    static const int BVH_BINS = 16;
+    static const int BVH_MAX_LEAF = 8;
+    // subtrees with at least this many triangles are built as separate tasks
+    static const int PARALLEL_BVH_CUTOFF = 20000;
+
+    // float bounds are rounded outwards so that they still enclose the double geometry
+    static inline float RoundDown(double v)
     {
-        this->model = _model;
-        BuildBVH();
+        float f = (float)v;
+        return (double)f > v ? nextafterf(f, -FLT_MAX) : f;
     }
 
-    void BVH::BuildBVH()
+    static inline float RoundUp(double v)
     {
-        const int N = model.triangles.size();
-        bvhNode.resize(N * 2 - 1);
-        rootNodeIdx = 0;
-        nodesUsed = 1;
+        float f = (float)v;
+        return (double)f < v ? nextafterf(f, FLT_MAX) : f;
+    }
 
-        // compute triangle centroids
-        centroids.resize(N);
-        for (int i = 0; i < N; i++)
+    static inline float HalfArea(const float lo[3], const float hi[3])
+    {
+        float dx = hi[0] - lo[0], dy = hi[1] - lo[1], dz = hi[2] - lo[2];
+        return dx * dy + dy * dz + dz * dx;
+    }
+
+    // Triangle bounds and centroid, partitioned in place while building so the builder reads memory in order
+    struct BuildRef
+    {
+        float lo[3], hi[3], c[3];
+        int tri;
+    };
+
+    // Appends a subtree built on its own, moving its right-child links to where it lands
+    static void AppendSubtree(vector<BVHNode> &nodes, const vector<BVHNode> &subtree)
+    {
+        const int offset = (int)nodes.size();
+        for (BVHNode node : subtree)
         {
-            const vec3i tri = model.triangles[i];
-            for (int j = 0; j < 3; j++)
-                centroids[i][j] = (model.points[tri[0]][j] + model.points[tri[1]][j] + model.points[tri[2]][j]) / 3.0f;
+            if (!node.isLeaf())
+                node.leftFirst += offset;
+            nodes.push_back(node);
         }
-        // assign all triangles to root node
-        BVHNode &root = bvhNode[rootNodeIdx];
-        root.left = root.right = 0;
-        root.firstTri = 0, root.numTri = N;
-        UpdateNodeBounds(rootNodeIdx);
-        // subdivide recursively
-        Subdivide(rootNodeIdx);
     }
 
-    void BVH::UpdateNodeBounds(int nodeIdx)
+    static void Build(vector<BuildRef> &refs, int first, int count, vector<BVHNode> &nodes)
     {
-        BVHNode &node = bvhNode[nodeIdx];
-        node.aabbMin[0] = node.aabbMin[1] = node.aabbMin[2] = 1e10;
-        node.aabbMax[0] = node.aabbMax[1] = node.aabbMax[2] = -1e10;
-        for (int first = node.firstTri, i = 0; i < node.numTri; i++)
+        float lo[3] = {FLT_MAX, FLT_MAX, FLT_MAX}, hi[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+        float c_lo[3] = {FLT_MAX, FLT_MAX, FLT_MAX}, c_hi[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+        for (int i = first; i < first + count; i++)
+        {
+            const BuildRef &r = refs[i];
+            for (int j = 0; j < 3; j++)
+            {
+                lo[j] = min(lo[j], r.lo[j]);
+                hi[j] = max(hi[j], r.hi[j]);
+                c_lo[j] = min(c_lo[j], r.c[j]);
+                c_hi[j] = max(c_hi[j], r.c[j]);
+            }
+        }
+
+        const int nodeIdx = (int)nodes.size();
+        nodes.push_back({{lo[0], lo[1], lo[2]}, first, {hi[0], hi[1], hi[2]}, count});
+        if (count <= 2)
+            return;
+
+        // binned surface area heuristic along the widest axis of the centroid bounds
+        int axis = 0;
+        for (int j = 1; j < 3; j++)
+            if (c_hi[j] - c_lo[j] > c_hi[axis] - c_lo[axis])
+                axis = j;
+        int bestSplit = -1;
+        float bestCost = FLT_MAX;
+        const float c_min = c_lo[axis], scale = c_hi[axis] > c_min ? BVH_BINS / (c_hi[axis] - c_min) : 0;
+        auto bin = [&](const BuildRef &r)
+        { return min(BVH_BINS - 1, (int)((r.c[axis] - c_min) * scale)); };
+        if (scale > 0)
         {
-            const vec3i tri = model.triangles[first + i];
+            int binCount[BVH_BINS] = {};
+            float binLo[BVH_BINS][3], binHi[BVH_BINS][3];
+            for (int b = 0; b < BVH_BINS; b++)
+                for (int j = 0; j < 3; j++)
+                {
+                    binLo[b][j] = FLT_MAX;
+                    binHi[b][j] = -FLT_MAX;
+                }
+            for (int i = first; i < first + count; i++)
+            {
+                const BuildRef &r = refs[i];
+                const int b = bin(r);
+                binCount[b]++;
+                for (int j = 0; j < 3; j++)
+                {
+                    binLo[b][j] = min(binLo[b][j], r.lo[j]);
+                    binHi[b][j] = max(binHi[b][j], r.hi[j]);
+                }
+            }
+
+            // leftCost[b]: the bins before split plane b, swept from the left
+            float leftCost[BVH_BINS];
+            float accLo[3] = {FLT_MAX, FLT_MAX, FLT_MAX}, accHi[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+            for (int b = 1, n = 0; b < BVH_BINS; b++)
+            {
+                n += binCount[b - 1];
+                for (int j = 0; j < 3; j++)
+                {
+                    accLo[j] = min(accLo[j], binLo[b - 1][j]);
+                    accHi[j] = max(accHi[j], binHi[b - 1][j]);
+                }
+                leftCost[b] = n == 0 ? -1 : n * HalfArea(accLo, accHi);
+            }
             for (int j = 0; j < 3; j++)
             {
-                for (int k = 0; k < 3; k++)
+                accLo[j] = FLT_MAX;
+                accHi[j] = -FLT_MAX;
+            }
+            for (int b = BVH_BINS - 1, n = 0; b > 0; b--)
+            {
+                n += binCount[b];
+                for (int j = 0; j < 3; j++)
                 {
-                    node.aabbMin[j] = min(node.aabbMin[j], model.points[tri[k]][j]);
-                    node.aabbMax[j] = max(node.aabbMax[j], model.points[tri[k]][j]);
+                    accLo[j] = min(accLo[j], binLo[b][j]);
+                    accHi[j] = max(accHi[j], binHi[b][j]);
+                }
+                if (n == 0 || leftCost[b] < 0)
+                    continue;
+                const float cost = leftCost[b] + n * HalfArea(accLo, accHi);
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestSplit = b;
                 }
             }
         }
+
+        // a leaf costs one test per triangle, a split one traversal step plus the area-weighted children
+        if (bestSplit == -1 || (count <= BVH_MAX_LEAF && bestCost >= (count - 1) * HalfArea(lo, hi)))
+            return;
+
+        BuildRef *mid = std::partition(refs.data() + first, refs.data() + first + count, [&](const BuildRef &r)
+                                       { return bin(r) < bestSplit; });
+        const int leftCount = (int)(mid - (refs.data() + first));
+        if (leftCount == 0 || leftCount == count)
+            return;
+
+        nodes[nodeIdx].numTri = 0;
+        if (count >= PARALLEL_BVH_CUTOFF)
+        {
+            vector<BVHNode> left, right;
+#ifdef _OPENMP
+#pragma omp task default(shared)
+#endif
+            Build(refs, first, leftCount, left);
+            Build(refs, first + leftCount, count - leftCount, right);
+#ifdef _OPENMP
+#pragma omp taskwait
+#endif
+            AppendSubtree(nodes, left);
+            nodes[nodeIdx].leftFirst = (int)nodes.size();
+            AppendSubtree(nodes, right);
+        }
+        else
+        {
+            Build(refs, first, leftCount, nodes);
+            nodes[nodeIdx].leftFirst = (int)nodes.size();
+            Build(refs, first + leftCount, count - leftCount, nodes);
+        }
     }
 
-    void BVH::Subdivide(int nodeIdx)
+    BVH::BVH(const Model &_model) : model(_model)
     {
-        // terminate recursion
-        BVHNode &node = bvhNode[nodeIdx];
-        if (node.numTri <= 2)
-        {
+        const int N = (int)model.triangles.size();
+        if (N == 0)
             return;
+
+        vector<BuildRef> refs(N);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if (N >= PARALLEL_BVH_CUTOFF)
+#endif
+        for (int i = 0; i < N; i++)
+        {
+            const vec3i &tri = model.triangles[i];
+            const vec3d &p0 = model.points[tri[0]], &p1 = model.points[tri[1]], &p2 = model.points[tri[2]];
+            BuildRef &r = refs[i];
+            for (int j = 0; j < 3; j++)
+            {
+                r.lo[j] = RoundDown(min(p0[j], min(p1[j], p2[j])));
+                r.hi[j] = RoundUp(max(p0[j], max(p1[j], p2[j])));
+                r.c[j] = (float)((p0[j] + p1[j] + p2[j]) / 3.0);
+            }
+            r.tri = i;
         }
-        // determine split axis and position
-        double extent[3] = {node.aabbMax[0] - node.aabbMin[0], node.aabbMax[1] - node.aabbMin[1], node.aabbMax[2] - node.aabbMin[2]};
-        int axes[3];
-        if (extent[1] > extent[0])
+
+        bvhNode.reserve(2 * N - 1);
+#ifdef _OPENMP
+#pragma omp parallel if (N >= PARALLEL_BVH_CUTOFF)
+#pragma omp single
+#endif
+        Build(refs, 0, N, bvhNode);
+
+        triIdx.resize(N);
+        for (int i = 0; i < N; i++)
+            triIdx[i] = refs[i].tri;
+    }
+
+    struct TriangleQuery
+    {
+        vec3i tri;
+        vec3d p0, p1, p2;
+        IntersectVector3 v0, v1, v2;
+        double lo[3], hi[3];
+    };
+
+    // Triangles meeting at a shared or coincident vertex are neighbours, not intersections
+    static bool Adjacent(const Model &model, const vec3i &t0, const vec3i &t1)
+    {
+        for (int a = 0; a < 3; a++)
+            for (int b = 0; b < 3; b++)
+                if (t0[a] == t1[b])
+                    return true;
+        for (int a = 0; a < 3; a++)
+            for (int b = 0; b < 3; b++)
+                if (SamePointDetect(model.points[t0[a]], model.points[t1[b]]))
+                    return true;
+        return false;
+    }
+
+    static bool IntersectNode(const BVH &bvh, const TriangleQuery &q, int nodeIdx)
+    {
+        const BVHNode &node = bvh.bvhNode[nodeIdx];
+        for (int j = 0; j < 3; j++)
+            if (q.lo[j] > node.aabbMax[j] || q.hi[j] < node.aabbMin[j])
+                return false;
+        if (!node.isLeaf())
+            return IntersectNode(bvh, q, nodeIdx + 1) || IntersectNode(bvh, q, node.leftFirst);
+
+        const vec3i &t0 = q.tri;
+        for (int i = 0; i < node.numTri; i++)
         {
-            axes[0] = 1;
-            axes[1] = 0;
+            const vec3i &t1 = bvh.model.triangles[bvh.triIdx[node.leftFirst + i]];
+            if (Adjacent(bvh.model, t0, t1))
+                continue;
+            const vec3d &p1_0 = bvh.model.points[t1[0]];
+            const vec3d &p1_1 = bvh.model.points[t1[1]];
+            const vec3d &p1_2 = bvh.model.points[t1[2]];
+
+            IntersectVector3 u0 = {float(p1_0[0]), float(p1_0[1]), float(p1_0[2])};
+            IntersectVector3 u1 = {float(p1_1[0]), float(p1_1[1]), float(p1_1[2])};
+            IntersectVector3 u2 = {float(p1_2[0]), float(p1_2[1]), float(p1_2[2])};
+            if (threeyd::moeller::TriangleIntersects<IntersectVector3>::triangle(q.v0, q.v1, q.v2, u0, u1, u2))
+                return true;
         }
-        else
+        return false;
+    }
+
+    bool BVH::IntersectBVH(vec3i triangleIdx, const int nodeIdx) const
+    {
+        if (bvhNode.empty())
+            return false;
+
+        TriangleQuery q;
+        q.tri = triangleIdx;
+        q.p0 = model.points[triangleIdx[0]];
+        q.p1 = model.points[triangleIdx[1]];
+        q.p2 = model.points[triangleIdx[2]];
+        q.v0 = {float(q.p0[0]), float(q.p0[1]), float(q.p0[2])};
+        q.v1 = {float(q.p1[0]), float(q.p1[1]), float(q.p1[2])};
+        q.v2 = {float(q.p2[0]), float(q.p2[1]), float(q.p2[2])};
+        for (int j = 0; j < 3; j++)
         {
-            axes[0] = 0;
-            axes[1] = 1;
+            q.lo[j] = min(q.p0[j], min(q.p1[j], q.p2[j]));
+            q.hi[j] = max(q.p0[j], max(q.p1[j], q.p2[j]));
         }
-        if (extent[2] > extent[axes[1]])
+        return IntersectNode(*this, q, nodeIdx);
+    }
+
+    // Up to BVH_MAX_LEAF triangles of a leaf with their float vertices, so a leaf pair converts each vertex once
+    struct LeafBatch
+    {
+        int n;
+        int tri[BVH_MAX_LEAF];
+        IntersectVector3 v[BVH_MAX_LEAF][3];
+    };
+
+    struct SelfIntersectJob
+    {
+        const BVH &bvh;
+        bool first_only;
+        vector<pair<int, int>> &pairs;
+        std::atomic<bool> found{false};
+
+        bool Done() const { return first_only && found.load(std::memory_order_relaxed); }
+    };
+
+    static void LoadBatch(const BVH &bvh, int first, int n, LeafBatch &batch)
+    {
+        batch.n = n;
+        for (int i = 0; i < n; i++)
         {
-            axes[2] = axes[1];
-            if (extent[2] > extent[axes[0]])
+            batch.tri[i] = bvh.triIdx[first + i];
+            const vec3i &tri = bvh.model.triangles[batch.tri[i]];
+            for (int k = 0; k < 3; k++)
             {
-                axes[1] = axes[0];
-                axes[0] = 2;
+                const vec3d &p = bvh.model.points[tri[k]];
+                batch.v[i][k] = {float(p[0]), float(p[1]), float(p[2])};
             }
-            else
-                axes[1] = 2;
         }
-        else
-            axes[2] = 2;
+    }
 
-        // travers all the axes from widest to narrowest, in case long thin triangles problem
-        for (int ax = 0; ax < 3; ax++)
-        {
-            int axis = axes[ax];
-            double splitPos = node.aabbMin[axis] + extent[axis] * 0.5;
-            // in-place partition
-            int i = node.firstTri;
-            int j = i + node.numTri - 1;
-            while (i <= j)
+    static void CollideBatches(SelfIntersectJob &job, const LeafBatch &a, const LeafBatch &b, bool same)
+    {
+        const Model &model = job.bvh.model;
+        for (int i = 0; i < a.n; i++)
+            for (int j = same ? i + 1 : 0; j < b.n; j++)
             {
-                if (centroids[i][axis] < splitPos)
-                    i++;
-                else
+                if (job.Done())
+                    return;
+                const int t0 = a.tri[i], t1 = b.tri[j];
+                if (Adjacent(model, model.triangles[t0], model.triangles[t1]))
+                    continue;
+                if (threeyd::moeller::TriangleIntersects<IntersectVector3>::triangle(a.v[i][0], a.v[i][1], a.v[i][2], b.v[j][0], b.v[j][1], b.v[j][2]))
                 {
-                    std::swap(model.triangles[i], model.triangles[j]);
-                    std::swap(centroids[i], centroids[j--]);
+#ifdef _OPENMP
+#pragma omp critical(bvh_self_intersections)
+#endif
+                    job.pairs.push_back({min(t0, t1), max(t0, t1)});
+                    job.found.store(true, std::memory_order_relaxed);
                 }
             }
+    }
 
-            // abort split if one of the sides is empty
-            int leftCount = i - node.firstTri;
-            if ((leftCount == 0 || leftCount == node.numTri) && ax != 2)
+    // All triangle pairs between two leaves, or within one leaf when same
+    static void CollideLeaves(SelfIntersectJob &job, const BVHNode &a, const BVHNode &b, bool same)
+    {
+        LeafBatch batch_a, batch_b;
+        for (int i = 0; i < a.numTri; i += BVH_MAX_LEAF)
+        {
+            LoadBatch(job.bvh, a.leftFirst + i, min(BVH_MAX_LEAF, a.numTri - i), batch_a);
+            for (int j = same ? i : 0; j < b.numTri; j += BVH_MAX_LEAF)
             {
-                continue;
+                if (same && j == i)
+                {
+                    CollideBatches(job, batch_a, batch_a, true);
+                    continue;
+                }
+                LoadBatch(job.bvh, b.leftFirst + j, min(BVH_MAX_LEAF, b.numTri - j), batch_b);
+                CollideBatches(job, batch_a, batch_b, false);
             }
-            else if ((leftCount == 0 || leftCount == node.numTri) && ax == 2)
-            {
+        }
+    }
+
+    static inline float NodeArea(const BVHNode &node)
+    {
+        return HalfArea(node.aabbMin, node.aabbMax);
+    }
+
+    // the top levels of the traversal run as tasks, the rest as plain calls
+    static const int BVH_TASK_DEPTH = 6;
+
+    template <typename F>
+    static void Spawn(int depth, F f)
+    {
+        if (depth < BVH_TASK_DEPTH)
+        {
+#ifdef _OPENMP
+#pragma omp task firstprivate(f)
+#endif
+            f();
+        }
+        else
+            f();
+    }
+
+    static void CollideNodes(SelfIntersectJob *job, int a, int b, int depth)
+    {
+        const BVHNode &A = job->bvh.bvhNode[a], &B = job->bvh.bvhNode[b];
+        if (job->Done())
+            return;
+        for (int j = 0; j < 3; j++)
+            if (A.aabbMin[j] > B.aabbMax[j] || B.aabbMin[j] > A.aabbMax[j])
                 return;
-            }
+        if (A.isLeaf() && B.isLeaf())
+        {
+            CollideLeaves(*job, A, B, false);
+            return;
+        }
 
-            // create child nodes
-            int leftChildIdx = nodesUsed++;
-            int rightChildIdx = nodesUsed++;
-            bvhNode[leftChildIdx].firstTri = node.firstTri;
-            bvhNode[leftChildIdx].numTri = leftCount;
-            bvhNode[rightChildIdx].firstTri = i;
-            bvhNode[rightChildIdx].numTri = node.numTri - leftCount;
-            node.left = leftChildIdx;
-            node.right = rightChildIdx;
-            node.numTri = 0;
-            // update bounds
-            UpdateNodeBounds(leftChildIdx);
-            UpdateNodeBounds(rightChildIdx);
-            // recurse
-            Subdivide(leftChildIdx);
-            Subdivide(rightChildIdx);
-            break;
+        // descend into the larger of the two boxes
+        if (B.isLeaf() || (!A.isLeaf() && NodeArea(A) >= NodeArea(B)))
+        {
+            const int left = a + 1, right = A.leftFirst;
+            Spawn(depth, [=]
+                  { CollideNodes(job, left, b, depth + 1); });
+            CollideNodes(job, right, b, depth + 1);
+        }
+        else
+        {
+            const int left = b + 1, right = B.leftFirst;
+            Spawn(depth, [=]
+                  { CollideNodes(job, a, left, depth + 1); });
+            CollideNodes(job, a, right, depth + 1);
         }
     }
 
-    bool isOverlap1D(double xmin1, double xmin2, double xmax1, double xmax2)
+    static void CollideSelf(SelfIntersectJob *job, int n, int depth)
     {
-        assert(xmin1 <= xmax1 && xmin2 <= xmax2);
-        return (xmin1 <= xmax2 && xmax1 >= xmin2);
+        const BVHNode &node = job->bvh.bvhNode[n];
+        if (job->Done())
+            return;
+        if (node.isLeaf())
+        {
+            CollideLeaves(*job, node, node, true);
+            return;
+        }
+        // tasks copy the child indices and the job pointer, since no one waits for them here
+        const int left = n + 1, right = node.leftFirst;
+        Spawn(depth, [=]
+              { CollideSelf(job, left, depth + 1); });
+        Spawn(depth, [=]
+              { CollideSelf(job, right, depth + 1); });
+        CollideNodes(job, left, right, depth + 1);
     }
-    bool isOverlap3D(vec3d aabbMin1, vec3d aabbMin2, vec3d aabbMax1, vec3d aabbMax2)
+
+    void BVH::SelfIntersections(vector<pair<int, int>> &pairs, bool first_only) const
     {
-        assert(aabbMin1[0] <= aabbMax1[0] && aabbMin1[1] <= aabbMax1[1] && aabbMin1[2] <= aabbMax1[2] && aabbMin2[0] <= aabbMax2[0] && aabbMin2[1] <= aabbMax2[1] && aabbMin2[2] <= aabbMax2[2]);
-        return (isOverlap1D(aabbMin1[0], aabbMin2[0], aabbMax1[0], aabbMax2[0]) &&
-                isOverlap1D(aabbMin1[1], aabbMin2[1], aabbMax1[1], aabbMax2[1]) &&
-                isOverlap1D(aabbMin1[2], aabbMin2[2], aabbMax1[2], aabbMax2[2]));
+        pairs.clear();
+        if (bvhNode.empty())
+            return;
+
+        // the tree is walked against itself, so each pair of overlapping leaves is visited once
+        SelfIntersectJob job{*this, first_only, pairs};
+#ifdef _OPENMP
+#pragma omp parallel if ((int)triIdx.size() >= PARALLEL_BVH_CUTOFF)
+#pragma omp single
+#endif
+        CollideSelf(&job, 0, 0);
+
+        std::sort(pairs.begin(), pairs.end());
+        if (first_only && pairs.size() > 1)
+            pairs.resize(1);
     }
 
-    bool BVH::IntersectAABB(vec3i triangleIdx, const vec3d &aabbMin, const vec3d &aabbMax)
+    // Squared distance from p to triangle abc (Ericson, Real-Time Collision Detection, 5.1.5)
+    static double PointTriangleDist2(const vec3d &p, const vec3d &a, const vec3d &b, const vec3d &c)
     {
-        vec3d tri_aabbMin = {1e10, 1e10, 1e10};
-        vec3d tri_aabbMax = {-1e10, -1e10, -1e10};
-        for (int i = 0; i < 3; i++)
+        vec3d ab = {b[0] - a[0], b[1] - a[1], b[2] - a[2]}, ac = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+        vec3d ap = {p[0] - a[0], p[1] - a[1], p[2] - a[2]};
+        auto dot = [](const vec3d &u, const vec3d &v)
+        { return u[0] * v[0] + u[1] * v[1] + u[2] * v[2]; };
+        auto dist2 = [&](const vec3d &q)
+        { return (p[0] - q[0]) * (p[0] - q[0]) + (p[1] - q[1]) * (p[1] - q[1]) + (p[2] - q[2]) * (p[2] - q[2]); };
+        auto along = [&](const vec3d &o, const vec3d &d, double t) -> vec3d
+        { return {o[0] + t * d[0], o[1] + t * d[1], o[2] + t * d[2]}; };
+
+        double d1 = dot(ab, ap), d2 = dot(ac, ap);
+        if (d1 <= 0 && d2 <= 0)
+            return dist2(a);
+        vec3d bp = {p[0] - b[0], p[1] - b[1], p[2] - b[2]};
+        double d3 = dot(ab, bp), d4 = dot(ac, bp);
+        if (d3 >= 0 && d4 <= d3)
+            return dist2(b);
+        double vc = d1 * d4 - d3 * d2;
+        if (vc <= 0 && d1 >= 0 && d3 <= 0)
+            return dist2(along(a, ab, d1 / (d1 - d3)));
+        vec3d cp = {p[0] - c[0], p[1] - c[1], p[2] - c[2]};
+        double d5 = dot(ab, cp), d6 = dot(ac, cp);
+        if (d6 >= 0 && d5 <= d6)
+            return dist2(c);
+        double vb = d5 * d2 - d1 * d6;
+        if (vb <= 0 && d2 >= 0 && d6 <= 0)
+            return dist2(along(a, ac, d2 / (d2 - d6)));
+        double va = d3 * d6 - d5 * d4;
+        if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
         {
-            tri_aabbMin[i] = min(tri_aabbMin[i], model.points[triangleIdx[i]][i]);
-            tri_aabbMax[i] = max(tri_aabbMax[i], model.points[triangleIdx[i]][i]);
+            vec3d bc = {c[0] - b[0], c[1] - b[1], c[2] - b[2]};
+            return dist2(along(b, bc, (d4 - d3) / ((d4 - d3) + (d5 - d6))));
         }
-        return isOverlap3D(tri_aabbMin, aabbMin, tri_aabbMax, aabbMax);
+        double denom = va + vb + vc;
+        if (denom == 0)
+            return min(dist2(a), min(dist2(b), dist2(c)));
+        double v = vb / denom, w = vc / denom;
+        return dist2({a[0] + ab[0] * v + ac[0] * w, a[1] + ab[1] * v + ac[1] * w, a[2] + ab[2] * v + ac[2] * w});
     }
 
-    bool BVH::IntersectBVH(vec3i triangleIdx, const int nodeIdx)
+    static double BoxDist2(const BVHNode &node, const vec3d &p)
     {
-        BVHNode &node = bvhNode[nodeIdx];
-        if (!IntersectAABB(triangleIdx, node.aabbMin, node.aabbMax))
-            return false;
+        double d2 = 0;
+        for (int j = 0; j < 3; j++)
+        {
+            double d = max(0.0, max(node.aabbMin[j] - p[j], p[j] - node.aabbMax[j]));
+            d2 += d * d;
+        }
+        return d2;
+    }
+
+    static void ClosestNode(const BVH &bvh, const vec3d &p, int nodeIdx, double &best, int &bestTri)
+    {
+        const BVHNode &node = bvh.bvhNode[nodeIdx];
         if (node.isLeaf())
         {
             for (int i = 0; i < node.numTri; i++)
             {
-                IntersectVector3 v0, v1, v2, u0, u1, u2;
-                const vec3i t0 = triangleIdx;
-                const vec3i t1 = model.triangles[node.firstTri + i];
-                const vec3d p0_0 = model.points[t0[0]];
-                const vec3d p0_1 = model.points[t0[1]];
-                const vec3d p0_2 = model.points[t0[2]];
-                const vec3d p1_0 = model.points[t1[0]];
-                const vec3d p1_1 = model.points[t1[1]];
-                const vec3d p1_2 = model.points[t1[2]];
-
-                v0 = {float(p0_0[0]), float(p0_0[1]), float(p0_0[2])};
-                v1 = {float(p0_1[0]), float(p0_1[1]), float(p0_1[2])};
-                v2 = {float(p0_2[0]), float(p0_2[1]), float(p0_2[2])};
-                u0 = {float(p1_0[0]), float(p1_0[1]), float(p1_0[2])};
-                u1 = {float(p1_1[0]), float(p1_1[1]), float(p1_1[2])};
-                u2 = {float(p1_2[0]), float(p1_2[1]), float(p1_2[2])};
-
-                if (t0[0] != t1[0] && t0[0] != t1[1] && t0[0] != t1[2] &&
-                    t0[1] != t1[0] && t0[1] != t1[1] && t0[1] != t1[2] &&
-                    t0[2] != t1[0] && t0[2] != t1[1] && t0[2] != t1[2] &&
-                    !SamePointDetect(p0_0, p1_0) && !SamePointDetect(p0_0, p1_1) && !SamePointDetect(p0_0, p1_2) &&
-                    !SamePointDetect(p0_1, p1_0) && !SamePointDetect(p0_1, p1_1) && !SamePointDetect(p0_1, p1_2) &&
-                    !SamePointDetect(p0_2, p1_0) && !SamePointDetect(p0_2, p1_1) && !SamePointDetect(p0_2, p1_2))
+                const int t = bvh.triIdx[node.leftFirst + i];
+                const vec3i &tri = bvh.model.triangles[t];
+                double d2 = PointTriangleDist2(p, bvh.model.points[tri[0]], bvh.model.points[tri[1]], bvh.model.points[tri[2]]);
+                if (d2 < best)
                 {
-                    bool flag = threeyd::moeller::TriangleIntersects<IntersectVector3>::triangle(v0, v1, v2, u0, u1, u2);
-                    if (flag)
-                    {
-                        // std::cout << "v " << v0[0] << ' ' << v0[1] << ' ' << v0[2] << std::endl;
-                        // std::cout << "v " << v1[0] << ' ' << v1[1] << ' ' << v1[2] << std::endl;
-                        // std::cout << "v " << v2[0] << ' ' << v2[1] << ' ' << v2[2] << std::endl;
-                        // std::cout << "v " << u0[0] << ' ' << u0[1] << ' ' << u0[2] << std::endl;
-                        // std::cout << "v " << u1[0] << ' ' << u1[1] << ' ' << u1[2] << std::endl;
-                        // std::cout << "v " << u2[0] << ' ' << u2[1] << ' ' << u2[2] << std::endl;
-                        // std::cout << "f 1 2 3" << std::endl;
-                        // std::cout << "f 4 5 6" << std::endl;
-                        return true;
-                    }
+                    best = d2;
+                    bestTri = t;
                 }
             }
-            return false;
+            return;
         }
-        else
+        // nearer child first, so that the farther one is more often pruned
+        int near = nodeIdx + 1, far = node.leftFirst;
+        double d_near = BoxDist2(bvh.bvhNode[near], p), d_far = BoxDist2(bvh.bvhNode[far], p);
+        if (d_far < d_near)
         {
-            if (node.left != -1)
-            {
-                bool left_intersect = IntersectBVH(triangleIdx, node.left);
-                if (left_intersect)
-                    return true;
-            }
-            if (node.right != -1)
-            {
-                bool right_intersect = IntersectBVH(triangleIdx, node.right);
-                return right_intersect;
-            }
+            std::swap(near, far);
+            std::swap(d_near, d_far);
         }
+        if (d_near < best)
+            ClosestNode(bvh, p, near, best, bestTri);
+        if (d_far < best)
+            ClosestNode(bvh, p, far, best, bestTri);
+    }
+
+    // Index of the triangle nearest to p and its squared distance, or -1 for an empty model
+    int BVH::ClosestTriangle(const vec3d &p, double &dist2) const
+    {
+        dist2 = INF;
+        int tri = -1;
+        if (!bvhNode.empty())
+            ClosestNode(*this, p, 0, dist2, tri);
+        return tri;
     }
 }
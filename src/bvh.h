@@ -34,28 +34,31 @@ namespace coacd
         const float &operator[](size_t i) const noexcept { return *(&x + i); }
     };
 
-    class BVHNode
+    // 32-byte node with conservative float bounds, stored in depth-first order: an interior node's left child
+    // directly follows it and leftFirst holds its right child, a leaf covers triIdx[leftFirst, leftFirst + numTri)
+    struct BVHNode
     {
-    public:
-        vec3d aabbMin, aabbMax;
-        int left, right, firstTri, numTri;
-        bool isLeaf() { return numTri > 0; };
+        float aabbMin[3];
+        int leftFirst;
+        float aabbMax[3];
+        int numTri;
+        bool isLeaf() const { return numTri > 0; };
     };
+    static_assert(sizeof(BVHNode) == 32, "BVHNode should fill half a cache line");
 
+    // Binned-SAH bounding volume hierarchy over the triangles of a model, which must outlive it
     class BVH
     {
     public:
-        Model model;
+        const Model &model;
         vector<BVHNode> bvhNode;
-        vector<vec3d> centroids;
-        int rootNodeIdx, nodesUsed;
+        vector<int> triIdx; // leaf order of the model's triangles
 
-        BVH(const Model _model);
-        void BuildBVH();
-        void UpdateNodeBounds(int nodeIdx);
-        void Subdivide(int nodeIdx);
+        BVH(const Model &_model);
 
-        bool IntersectAABB(vec3i triangleIdx, const vec3d &aabbMin, const vec3d &aabbMax);
-        bool IntersectBVH(vec3i triangleIdx, const int nodeIdx);
+        bool IntersectBVH(vec3i triangleIdx, const int nodeIdx = 0) const;
+        // Pairs (i < j) of triangles that cross without sharing a vertex, sorted; first_only stops at one pair
+        void SelfIntersections(vector<pair<int, int>> &pairs, bool first_only = false) const;
+        int ClosestTriangle(const vec3d &p, double &dist2) const;
     };
 }
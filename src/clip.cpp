@@ -1,5 +1,10 @@
 #include "clip.h"
 #include "process.h"
+#include "arena.h"
+
+#include <atomic>
+#include <numeric>
+#include <span>
 
 #include "include/CDTUtils.h"
 #include "include/CDT.h"
@@ -27,7 +32,7 @@ namespace coacd
         of.close();
     }
 
-    bool CreatePlaneRotationMatrix(vector<vec3d> &border, vector<pair<int, int>> border_edges, vec3d &T, double R[3][3], Plane &plane)
+    bool CreatePlaneRotationMatrix(vector<vec3d> &border, const vector<pair<int, int>> &border_edges, vec3d &T, double R[3][3], Plane &plane)
     {
         int idx0 = 0;
         int idx1;
@@ -116,35 +121,36 @@ namespace coacd
         return true;
     }
 
-    short Triangulation(vector<vec3d> &border, vector<pair<int, int>> border_edges, vector<vec3i> &border_triangles, Plane &plane)
-    {
-        double R[3][3];
-        vec3d T;
+    // Cap triangulation temporaries live in the scratch arena of the clip that needs the cap
+    using Points2d = ScratchVector<array<double, 2>>;
+    using Loop = ScratchVector<int>;
 
-        bool flag = CreatePlaneRotationMatrix(border, border_edges, T, R, plane);
-        if (!flag)
-            return 1;
-
-        vector<array<double, 2>> points, nodes;
-
-        double x_min = INF, x_max = -INF, y_min = INF, y_max = -INF;
+    // Coordinates of the border points in the plane frame of CreatePlaneRotationMatrix
+    static void ProjectBorder(const vector<vec3d> &border, const vec3d &T, double R[3][3], Points2d &points)
+    {
+        points.clear();
         for (int i = 0; i < (int)border.size(); i++)
         {
-            double x, y, z, px, py;
+            double x, y, z;
             x = border[i][0] - T[0];
             y = border[i][1] - T[1];
             z = border[i][2] - T[2];
 
-            px = R[0][0] * x + R[0][1] * y + R[0][2] * z;
-            py = R[1][0] * x + R[1][1] * y + R[1][2] * z;
+            points.push_back({R[0][0] * x + R[0][1] * y + R[0][2] * z, R[1][0] * x + R[1][1] * y + R[1][2] * z});
+        }
+    }
+
+    short Triangulation(vector<vec3d> &border, const vector<pair<int, int>> &border_edges, ScratchVector<vec3i> &border_triangles, Plane &plane)
+    {
+        double R[3][3];
+        vec3d T;
 
-            points.push_back({px, py});
+        bool flag = CreatePlaneRotationMatrix(border, border_edges, T, R, plane);
+        if (!flag)
+            return 1;
 
-            x_min = min(x_min, px);
-            x_max = max(x_max, px);
-            y_min = min(y_min, py);
-            y_max = max(y_max, py);
-        }
+        Points2d points(border_triangles.get_allocator().resource());
+        ProjectBorder(border, T, R, points);
 
         int borderN = (int)points.size();
 
@@ -192,78 +198,452 @@ namespace coacd
         return 0;
     }
 
-    void RemoveOutlierTriangles(vector<vec3d> border, vector<vec3d> overlap, vector<pair<int, int>> border_edges, vector<vec3i> border_triangles, int oriN,
-                                map<int, int> &vertex_map, vector<vec3d> &final_border, vector<vec3i> &final_triangles)
+    // Caps with more points or loops than this are left to the constrained Delaunay path
+    static const int EAR_CLIP_MAX_VERTICES = 256;
+    static const int EAR_CLIP_MAX_LOOPS = 8;
+
+    static std::atomic<size_t> cap_fan_count(0), cap_ear_count(0), cap_cdt_count(0);
+
+    CapStats GetCapStats()
     {
-        deque<pair<int, int>> BFS_edges(border_edges.begin(), border_edges.end());
-        map<pair<int, int>, pair<int, int>> edge_map;
-        map<pair<int, int>, bool> border_map;
-        map<pair<int, int>, bool> same_edge_map;
-        map<int, bool> overlap_map;
-        const int v_lenth = (int)border.size();
-        const int f_lenth = (int)border_triangles.size();
-        bool *add_vertex = new bool[v_lenth]();
-        bool *remove_map = new bool[f_lenth]();
+        CapStats stats;
+        stats.fan = cap_fan_count.load(std::memory_order_relaxed);
+        stats.ear = cap_ear_count.load(std::memory_order_relaxed);
+        stats.cdt = cap_cdt_count.load(std::memory_order_relaxed);
+        return stats;
+    }
 
-        for (int i = 0; i < (int)overlap.size(); i++)
-            for (int j = 0; j < (int)border.size(); j++)
-                if (SamePointDetect(overlap[i], border[j]))
-                    overlap_map[j + 1] = true;
+    void ResetCapStats()
+    {
+        cap_fan_count.store(0, std::memory_order_relaxed);
+        cap_ear_count.store(0, std::memory_order_relaxed);
+        cap_cdt_count.store(0, std::memory_order_relaxed);
+    }
 
-        for (int i = 0; i < (int)border_edges.size(); i++)
+    static inline double Orient2d(const array<double, 2> &a, const array<double, 2> &b, const array<double, 2> &c)
+    {
+        return (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+    }
+
+    // Side of q relative to the line uv, 0 when q is within rounding of it (cut borders are full of collinear runs)
+    static inline int Side2d(const array<double, 2> &u, const array<double, 2> &v, const array<double, 2> &q)
+    {
+        double d = Orient2d(u, v, q);
+        double scale = 1e-9 * sqrt(((v[0] - u[0]) * (v[0] - u[0]) + (v[1] - u[1]) * (v[1] - u[1])) *
+                                   ((q[0] - u[0]) * (q[0] - u[0]) + (q[1] - u[1]) * (q[1] - u[1])));
+        return d > scale ? 1 : (d < -scale ? -1 : 0);
+    }
+
+    // p inside triangle abc or on its boundary, for either orientation of abc
+    static bool InTriangle(const array<double, 2> &a, const array<double, 2> &b, const array<double, 2> &c, const array<double, 2> &p)
+    {
+        int d0 = Side2d(a, b, p), d1 = Side2d(b, c, p), d2 = Side2d(c, a, p);
+        return !((d0 < 0 || d1 < 0 || d2 < 0) && (d0 > 0 || d1 > 0 || d2 > 0));
+    }
+
+    // Segments ab and cd share at least one point
+    static bool SegmentsTouch(const array<double, 2> &a, const array<double, 2> &b, const array<double, 2> &c, const array<double, 2> &d)
+    {
+        double d0 = Orient2d(c, d, a), d1 = Orient2d(c, d, b), d2 = Orient2d(a, b, c), d3 = Orient2d(a, b, d);
+        if (((d0 > 0 && d1 < 0) || (d0 < 0 && d1 > 0)) && ((d2 > 0 && d3 < 0) || (d2 < 0 && d3 > 0)))
+            return true;
+        auto within = [](const array<double, 2> &u, const array<double, 2> &v, const array<double, 2> &q)
+        {
+            return min(u[0], v[0]) <= q[0] && q[0] <= max(u[0], v[0]) && min(u[1], v[1]) <= q[1] && q[1] <= max(u[1], v[1]);
+        };
+        return (d0 == 0 && within(c, d, a)) || (d1 == 0 && within(c, d, b)) || (d2 == 0 && within(a, b, c)) || (d3 == 0 && within(a, b, d));
+    }
+
+    static bool InLoop(const Points2d &points, const Loop &loop, const array<double, 2> &p)
+    {
+        bool inside = false;
+        for (int i = 0, j = (int)loop.size() - 1; i < (int)loop.size(); j = i++)
         {
-            int v0 = border_edges[i].first, v1 = border_edges[i].second;
-            same_edge_map[std::pair<int, int>(v0, v1)] = true;
+            const array<double, 2> &a = points[loop[i]], &b = points[loop[j]];
+            if ((a[1] > p[1]) != (b[1] > p[1]) && p[0] < a[0] + (p[1] - a[1]) * (b[0] - a[0]) / (b[1] - a[1]))
+                inside = !inside;
         }
-        for (int i = 0; i < (int)border_edges.size(); i++)
+        return inside;
+    }
+
+    static double LoopArea(const Points2d &points, const Loop &loop)
+    {
+        double area = 0;
+        for (int i = 0, j = (int)loop.size() - 1; i < (int)loop.size(); j = i++)
+            area += points[loop[j]][0] * points[loop[i]][1] - points[loop[i]][0] * points[loop[j]][1];
+        return area / 2;
+    }
+
+    // Splits the border edges (1-based) into vertex-disjoint closed loops of 0-based border points, following
+    // the edge direction. Fails on branching points, open chains and edges recorded in both directions.
+    static bool BorderLoops(int n, const vector<pair<int, int>> &border_edges, ScratchVector<Loop> &loops)
+    {
+        Loop next(n, -1, loops.get_allocator()), indeg(n, 0, loops.get_allocator());
+        for (const pair<int, int> &edge : border_edges)
         {
-            int v0 = border_edges[i].first, v1 = border_edges[i].second;
-            if (same_edge_map.find(std::pair<int, int>(v1, v0)) == same_edge_map.end())
+            int u = edge.first - 1, v = edge.second - 1;
+            if (next[u] == v) // a mesh edge lying in the plane is recorded by the triangles on both sides
+                continue;
+            if (next[u] != -1 || indeg[v] > 0)
+                return false;
+            next[u] = v;
+            indeg[v]++;
+        }
+
+        ScratchVector<char> visited(n, 0, loops.get_allocator());
+        for (int s = 0; s < n; s++)
+        {
+            if (next[s] == -1)
+            {
+                if (indeg[s] > 0)
+                    return false;
+                continue; // a border point no edge runs through
+            }
+            if (next[next[s]] == s)
+                return false;
+            if (visited[s])
+                continue;
+            loops.emplace_back();
+            for (int v = s; !visited[v]; v = next[v])
             {
-                border_map[std::pair<int, int>(v0, v1)] = true;
-                border_map[std::pair<int, int>(v1, v0)] = true;
+                if (next[v] == -1)
+                    return false;
+                visited[v] = 1;
+                loops.back().push_back(v);
             }
+            if (loops.back().size() < 3)
+                return false;
         }
+        return !loops.empty();
+    }
 
-        int borderN = border.size();
-        for (int i = 0; i < (int)border_triangles.size(); i++)
+    // 1 if the clockwise loop is strictly convex, 2 if it is convex with straight runs, 0 otherwise
+    static int ConvexLoop(const Points2d &points, const Loop &loop)
+    {
+        const int n = (int)loop.size();
+        int x_dir = 0, y_dir = 0, x_flips = 0, y_flips = 0;
+        bool straight = false;
+        for (int i = 0; i < n; i++)
         {
-            int v0, v1, v2;
-            v0 = border_triangles[i][0];
-            v1 = border_triangles[i][1];
-            v2 = border_triangles[i][2];
+            const array<double, 2> &a = points[loop[i]], &b = points[loop[(i + 1) % n]], &c = points[loop[(i + 2) % n]];
+            double ux = b[0] - a[0], uy = b[1] - a[1], vx = c[0] - b[0], vy = c[1] - b[1];
+            double scale = sqrt((ux * ux + uy * uy) * (vx * vx + vy * vy));
+            if (scale == 0)
+                return 0;
+            double cross = ux * vy - uy * vx;
+            if (cross > 1e-9 * scale)
+                return 0;
+            if (cross >= -1e-9 * scale)
+            {
+                if (ux * vx + uy * vy <= 0)
+                    return 0; // the loop doubles back on itself
+                straight = true;
+            }
+            // a loop turning one way winds once only if each coordinate changes direction at most twice
+            int dx = (ux > 0) - (ux < 0), dy = (uy > 0) - (uy < 0);
+            if (dx != 0)
+            {
+                x_flips += x_dir != 0 && dx != x_dir;
+                x_dir = dx;
+            }
+            if (dy != 0)
+            {
+                y_flips += y_dir != 0 && dy != y_dir;
+                y_dir = dy;
+            }
+        }
+        if (x_flips > 2 || y_flips > 2)
+            return 0;
+        return straight ? 2 : 1;
+    }
 
-            if (!(v0 >= 1 && v0 <= borderN && v1 >= 1 && v1 <= borderN && v2 >= 1 && v2 <= borderN)) // ignore points added by triangle
+    // Connects a clockwise hole to the counter-clockwise polygon by a bridge from the hole's rightmost point,
+    // so that the polygon runs around the hole and back along the bridge.
+    static bool BridgeHole(const Points2d &points, Loop &poly, const Loop &hole)
+    {
+        int m = 0;
+        for (int i = 1; i < (int)hole.size(); i++)
+            if (points[hole[i]][0] > points[hole[m]][0])
+                m = i;
+        const array<double, 2> M = points[hole[m]];
+
+        // nearest polygon edge hit by the ray from M towards +x; its endpoint further along the ray is visible
+        // unless a reflex point lies in the triangle between M, the hit and that endpoint
+        const int n = (int)poly.size();
+        double hit_x = INF;
+        int best = -1;
+        for (int i = 0; i < n; i++)
+        {
+            const array<double, 2> &a = points[poly[i]], &b = points[poly[(i + 1) % n]];
+            if ((a[1] > M[1]) == (b[1] > M[1]))
+                continue;
+            double x = a[0] + (M[1] - a[1]) * (b[0] - a[0]) / (b[1] - a[1]);
+            if (x < M[0] || x >= hit_x)
                 continue;
+            hit_x = x;
+            best = a[0] > b[0] ? i : (i + 1) % n;
+        }
+        if (best == -1)
+            return false;
 
-            pair<int, int> edge01 = std::pair<int, int>(v0, v1), edge10 = std::pair<int, int>(v1, v0);
-            pair<int, int> edge12 = std::pair<int, int>(v1, v2), edge21 = std::pair<int, int>(v2, v1);
-            pair<int, int> edge20 = std::pair<int, int>(v2, v0), edge02 = std::pair<int, int>(v0, v2);
+        const int visible = poly[best];
+        const array<double, 2> I = {hit_x, M[1]}, P = points[visible];
+        double best_angle = INF, best_dist = INF;
+        for (int i = 0; i < n; i++)
+        {
+            const array<double, 2> &v = points[poly[i]];
+            if (poly[i] == visible || Orient2d(points[poly[(i + n - 1) % n]], v, points[poly[(i + 1) % n]]) > 0 || !InTriangle(M, I, P, v))
+                continue;
+            double angle = atan2(fabs(v[1] - M[1]), v[0] - M[0]), dist = (v[0] - M[0]) * (v[0] - M[0]) + (v[1] - M[1]) * (v[1] - M[1]);
+            if (angle < best_angle || (angle == best_angle && dist < best_dist))
+            {
+                best_angle = angle;
+                best_dist = dist;
+                best = i;
+            }
+        }
+
+        Loop bridged(poly.begin(), poly.begin() + best + 1, poly.get_allocator());
+        for (int i = 0; i <= (int)hole.size(); i++)
+            bridged.push_back(hole[(m + i) % hole.size()]);
+        bridged.insert(bridged.end(), poly.begin() + best, poly.end());
+        poly.swap(bridged);
+        return true;
+    }
 
-            if (!(same_edge_map.find(edge10) != same_edge_map.end() && same_edge_map.find(edge01) != same_edge_map.end()))
+    // Ear clipping of a counter-clockwise polygon whose bridges may repeat points; triangles are 1-based
+    static bool EarClip(const Points2d &points, const Loop &poly, ScratchVector<vec3i> &triangles)
+    {
+        const int n = (int)poly.size();
+        Loop prev(n, 0, triangles.get_allocator()), next(n, 0, triangles.get_allocator());
+        for (int i = 0; i < n; i++)
+        {
+            prev[i] = (i + n - 1) % n;
+            next[i] = (i + 1) % n;
+        }
+
+        auto is_ear = [&](int i)
+        {
+            const int p = prev[i], q = next[i];
+            const array<double, 2> &a = points[poly[p]], &b = points[poly[i]], &c = points[poly[q]];
+            double ux = b[0] - a[0], uy = b[1] - a[1], vx = c[0] - b[0], vy = c[1] - b[1];
+            if (ux * vy - uy * vx <= 1e-9 * sqrt((ux * ux + uy * uy) * (vx * vx + vy * vy)))
+                return false;
+            // any point on the ear, even on its diagonal, would be cut off the cap
+            for (int k = next[q]; k != p; k = next[k])
+                if (poly[k] != poly[p] && poly[k] != poly[i] && poly[k] != poly[q] && InTriangle(a, b, c, points[poly[k]]))
+                    return false;
+            return true;
+        };
+
+        int remaining = n, i = 0, misses = 0;
+        while (remaining > 3)
+        {
+            if (is_ear(i))
             {
-                if (edge_map.find(edge10) == edge_map.end())
-                    edge_map[edge01] = std::pair<int, int>(i, -1);
-                else
-                    edge_map[edge10] = std::pair<int, int>(edge_map[edge10].first, i);
+                triangles.push_back({poly[prev[i]] + 1, poly[i] + 1, poly[next[i]] + 1});
+                next[prev[i]] = next[i];
+                prev[next[i]] = prev[i];
+                remaining--;
+                misses = 0;
+                i = prev[i];
+            }
+            else if (++misses > remaining)
+                return false;
+            else
+                i = next[i];
+        }
+        if (Orient2d(points[poly[prev[i]]], points[poly[i]], points[poly[next[i]]]) <= 0)
+            return false;
+        triangles.push_back({poly[prev[i]] + 1, poly[i] + 1, poly[next[i]] + 1});
+        return true;
+    }
+
+    // Cap triangulation for the common cuts whose border is a few simple loops: a fan for a single convex loop,
+    // ear clipping for simple loops with holes. Border loops run clockwise around the cap in the plane frame, and
+    // every cap triangle runs along its border edges in reverse, as RemoveOutlierTriangles keeps them. Returns
+    // false if the border needs the constrained Delaunay path. May append a fan centre to border. The temporaries
+    // come from cap_triangles' memory resource.
+    static bool SimpleCapTriangulation(vector<vec3d> &border, const vector<pair<int, int>> &border_edges, Plane &plane, ScratchVector<vec3i> &cap_triangles)
+    {
+        const int n = (int)border.size();
+        std::pmr::memory_resource *resource = cap_triangles.get_allocator().resource();
+        ScratchVector<Loop> loops(resource);
+        if (!BorderLoops(n, border_edges, loops) || (int)loops.size() > EAR_CLIP_MAX_LOOPS)
+            return false;
+
+        double R[3][3];
+        vec3d T;
+        if (!CreatePlaneRotationMatrix(border, border_edges, T, R, plane))
+            return false;
+        Points2d points(resource);
+        ProjectBorder(border, T, R, points);
+
+        Loop outers(resource), holes(resource);
+        int total = 0;
+        for (int i = 0; i < (int)loops.size(); i++)
+        {
+            double area = LoopArea(points, loops[i]);
+            if (area == 0)
+                return false;
+            (area < 0 ? outers : holes).push_back(i);
+            total += (int)loops[i].size();
+        }
+        if (outers.empty())
+            return false;
+
+        if (loops.size() == 1)
+        {
+            const Loop &loop = loops[0];
+            int convex = ConvexLoop(points, loop);
+            if (convex == 1)
+            {
+                for (int j = 1; j + 1 < (int)loop.size(); j++)
+                    cap_triangles.push_back({loop[0] + 1, loop[j + 1] + 1, loop[j] + 1});
+                cap_fan_count.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            if (convex == 2)
+            {
+                // straight runs would leave slivers in a fan from a corner, so fan from the centre instead
+                vec3d centre = {0, 0, 0};
+                for (int v : loop)
+                    for (int k = 0; k < 3; k++)
+                        centre[k] += border[v][k] / loop.size();
+                border.push_back(centre);
+                for (int j = 0; j < (int)loop.size(); j++)
+                    cap_triangles.push_back({n + 1, loop[(j + 1) % loop.size()] + 1, loop[j] + 1});
+                cap_fan_count.fetch_add(1, std::memory_order_relaxed);
+                return true;
             }
+        }
+        if (total > EAR_CLIP_MAX_VERTICES)
+            return false;
 
-            if (!(same_edge_map.find(edge12) != same_edge_map.end() && same_edge_map.find(edge21) != same_edge_map.end()))
+        // the loops must neither cross nor touch one another or themselves
+        ScratchVector<pair<int, int>> edges(resource);
+        for (const Loop &loop : loops)
+            for (int j = 0; j < (int)loop.size(); j++)
+                edges.push_back({loop[j], loop[(j + 1) % loop.size()]});
+        for (int i = 0; i < (int)edges.size(); i++)
+            for (int j = i + 1; j < (int)edges.size(); j++)
             {
-                if (edge_map.find(edge21) == edge_map.end())
-                    edge_map[edge12] = std::pair<int, int>(i, -1);
-                else
-                    edge_map[edge21] = std::pair<int, int>(edge_map[edge21].first, i);
+                const pair<int, int> &e = edges[i], &f = edges[j];
+                if (e.first == f.second || e.second == f.first)
+                    continue; // consecutive edges of a loop
+                if (SegmentsTouch(points[e.first], points[e.second], points[f.first], points[f.second]))
+                    return false;
             }
 
-            if (!(same_edge_map.find(edge02) != same_edge_map.end() && same_edge_map.find(edge20) != same_edge_map.end()))
+        // every hole in exactly one outer loop and no loop nested deeper; islands in holes go to CDT
+        ScratchVector<Loop> outer_holes(outers.size(), resource);
+        for (int o : outers)
+            for (int i = 0; i < (int)loops.size(); i++)
+                if (i != o && InLoop(points, loops[i], points[loops[o][0]]))
+                    return false;
+        for (int h : holes)
+        {
+            int owner = -1;
+            for (int k = 0; k < (int)outers.size(); k++)
+                if (InLoop(points, loops[outers[k]], points[loops[h][0]]))
+                {
+                    if (owner != -1)
+                        return false;
+                    owner = k;
+                }
+            for (int other : holes)
+                if (other != h && InLoop(points, loops[other], points[loops[h][0]]))
+                    return false;
+            if (owner == -1)
+                return false;
+            outer_holes[owner].push_back(h);
+        }
+
+        ScratchVector<vec3i> triangles(resource);
+        for (int k = 0; k < (int)outers.size(); k++)
+        {
+            Loop poly(loops[outers[k]].rbegin(), loops[outers[k]].rend(), resource);
+            Loop &inner = outer_holes[k];
+            // bridging from the rightmost hole first keeps later bridges clear of holes not yet joined
+            auto max_x = [&](int h)
             {
-                if (edge_map.find(edge02) == edge_map.end())
-                    edge_map[edge20] = std::pair<int, int>(i, -1);
-                else
-                    edge_map[edge02] = std::pair<int, int>(edge_map[edge02].first, i);
+                double x = -INF;
+                for (int v : loops[h])
+                    x = max(x, points[v][0]);
+                return x;
+            };
+            std::sort(inner.begin(), inner.end(), [&](int a, int b) { return max_x(a) > max_x(b); });
+            for (int h : inner)
+            {
+                Loop hole(loops[h].rbegin(), loops[h].rend(), resource);
+                if (!BridgeHole(points, poly, hole))
+                    return false;
+            }
+            if (!EarClip(points, poly, triangles))
+                return false;
+        }
+        cap_triangles.insert(cap_triangles.end(), triangles.begin(), triangles.end());
+        cap_ear_count.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void RemoveOutlierTriangles(const vector<vec3d> &border, const vector<vec3d> &overlap, const vector<pair<int, int>> &border_edges,
+                                const ScratchVector<vec3i> &border_triangles, int oriN, ScratchVector<int> &vertex_map, ScratchVector<vec3d> &final_border,
+                                ScratchVector<vec3i> &final_triangles)
+    {
+        deque<pair<int, int>> BFS_edges(border_edges.begin(), border_edges.end());
+        vector<char> overlap_map(border.size() + 1, 0);
+        const int v_lenth = (int)border.size();
+        const int f_lenth = (int)border_triangles.size();
+        bool *add_vertex = new bool[v_lenth]();
+        bool *remove_map = new bool[f_lenth]();
+
+        for (int i = 0; i < (int)overlap.size(); i++)
+            for (int j = 0; j < (int)border.size(); j++)
+                if (SamePointDetect(overlap[i], border[j]))
+                    overlap_map[j + 1] = true;
+
+        // an edge recorded in both directions is not part of the border
+        vector<uint64_t> border_keys(border_edges.size());
+        for (int i = 0; i < (int)border_edges.size(); i++)
+            border_keys[i] = HalfEdges::Key(border_edges[i].first, border_edges[i].second);
+        std::sort(border_keys.begin(), border_keys.end());
+        auto recorded = [&](int v0, int v1)
+        { return std::binary_search(border_keys.begin(), border_keys.end(), HalfEdges::Key(v0, v1)); };
+        auto on_border = [&](int v0, int v1)
+        { return recorded(v0, v1) != recorded(v1, v0); };
+
+        // adjacency of the triangles between border points (the triangulation may add points of its own)
+        int borderN = border.size();
+        vector<vec3i> inner_triangles;
+        vector<int> inner_ids;
+        for (int i = 0; i < (int)border_triangles.size(); i++)
+        {
+            int v0 = border_triangles[i][0], v1 = border_triangles[i][1], v2 = border_triangles[i][2];
+            if (v0 >= 1 && v0 <= borderN && v1 >= 1 && v1 <= borderN && v2 >= 1 && v2 <= borderN)
+            {
+                inner_triangles.push_back(border_triangles[i]);
+                inner_ids.push_back(i);
             }
         }
+        const HalfEdges edges(inner_triangles);
+
+        // The triangles on edge v0 -> v1, if the edge is seen in that direction: by the first triangle along it, with
+        // the second (or -1) on the reverse edge.
+        auto faces = [&](int v0, int v1, int &first, int &second)
+        {
+            if (recorded(v0, v1) && recorded(v1, v0))
+                return false;
+            int h = edges.Find(v0, v1);
+            if (h == -1)
+                return false;
+            int t = edges.twin[h];
+            if (t != -1 && HalfEdges::Face(t) < HalfEdges::Face(h))
+                return false;
+            first = inner_ids[HalfEdges::Face(h)];
+            second = t == -1 ? -1 : inner_ids[HalfEdges::Face(t)];
+            return true;
+        };
 
         int i = 0;
         while (!BFS_edges.empty())
@@ -272,13 +652,14 @@ namespace coacd
             BFS_edges.pop_front();
             int v0 = item.first, v1 = item.second;
             int idx;
-            pair<int, int> edge01 = std::pair<int, int>(v0, v1), edge10 = std::pair<int, int>(v1, v0);
-            if (i < (int)border_edges.size() && edge_map.find(edge10) != edge_map.end())
+            int first01, second01, first10, second10;
+            const bool has01 = faces(v0, v1, first01, second01), has10 = faces(v1, v0, first10, second10);
+            if (i < (int)border_edges.size() && has10)
             {
-                idx = edge_map[edge10].second;
+                idx = second10;
                 if (idx != -1)
                     remove_map[idx] = true;
-                idx = edge_map[edge10].first;
+                idx = first10;
                 if (idx != -1 && !remove_map[idx] && !FaceOverlap(overlap_map, border_triangles[idx]))
                 {
                     remove_map[idx] = true;
@@ -289,36 +670,33 @@ namespace coacd
                     int p0 = border_triangles[idx][0], p1 = border_triangles[idx][1], p2 = border_triangles[idx][2];
                     if (p2 != v0 && p2 != v1)
                     {
-                        pair<int, int> pt12 = std::pair<int, int>(p1, p2), pt20 = std::pair<int, int>(p2, p0);
-                        if (border_map.find(pt12) == border_map.end())
-                            BFS_edges.push_back(pt12);
-                        if (border_map.find(pt20) == border_map.end())
-                            BFS_edges.push_back(pt20);
+                        if (!on_border(p1, p2))
+                            BFS_edges.push_back(std::pair<int, int>(p1, p2));
+                        if (!on_border(p2, p0))
+                            BFS_edges.push_back(std::pair<int, int>(p2, p0));
                     }
                     else if (p1 != v0 && p1 != v1)
                     {
-                        pair<int, int> pt12 = std::pair<int, int>(p1, p2), pt01 = std::pair<int, int>(p0, p1);
-                        if (border_map.find(pt12) == border_map.end())
-                            BFS_edges.push_back(pt12);
-                        if (border_map.find(pt01) == border_map.end())
-                            BFS_edges.push_back(pt01);
+                        if (!on_border(p1, p2))
+                            BFS_edges.push_back(std::pair<int, int>(p1, p2));
+                        if (!on_border(p0, p1))
+                            BFS_edges.push_back(std::pair<int, int>(p0, p1));
                     }
                     else if (p0 != v0 && p0 != v1)
                     {
-                        pair<int, int> pt01 = std::pair<int, int>(p0, p1), pt20 = std::pair<int, int>(p2, p0);
-                        if (border_map.find(pt01) == border_map.end())
-                            BFS_edges.push_back(pt01);
-                        if (border_map.find(pt20) == border_map.end())
-                            BFS_edges.push_back(pt20);
+                        if (!on_border(p0, p1))
+                            BFS_edges.push_back(std::pair<int, int>(p0, p1));
+                        if (!on_border(p2, p0))
+                            BFS_edges.push_back(std::pair<int, int>(p2, p0));
                     }
                 }
             }
-            else if (i < (int)border_edges.size() && edge_map.find(edge01) != edge_map.end())
+            else if (i < (int)border_edges.size() && has01)
             {
-                idx = edge_map[edge01].first;
+                idx = first01;
                 if (idx != -1)
                     remove_map[idx] = true;
-                idx = edge_map[edge01].second;
+                idx = second01;
                 if (idx != -1 && !remove_map[idx] && !FaceOverlap(overlap_map, border_triangles[idx]))
                 {
                     remove_map[idx] = true;
@@ -329,44 +707,35 @@ namespace coacd
                     int p0 = border_triangles[idx][0], p1 = border_triangles[idx][1], p2 = border_triangles[idx][2];
                     if (p2 != v0 && p2 != v1)
                     {
-                        pair<int, int> pt21 = std::pair<int, int>(p2, p1), pt02 = std::pair<int, int>(p0, p2);
-                        if (border_map.find(pt21) == border_map.end())
-                            BFS_edges.push_back(pt21);
-                        if (border_map.find(pt02) == border_map.end())
-                            BFS_edges.push_back(pt02);
+                        if (!on_border(p2, p1))
+                            BFS_edges.push_back(std::pair<int, int>(p2, p1));
+                        if (!on_border(p0, p2))
+                            BFS_edges.push_back(std::pair<int, int>(p0, p2));
                     }
                     else if (p1 != v0 && p1 != v1)
                     {
-                        pair<int, int> pt21 = std::pair<int, int>(p2, p1), pt10 = std::pair<int, int>(p1, p0);
-                        if (border_map.find(pt21) == border_map.end())
-                            BFS_edges.push_back(pt21);
-                        if (border_map.find(pt10) == border_map.end())
-                            BFS_edges.push_back(pt10);
+                        if (!on_border(p2, p1))
+                            BFS_edges.push_back(std::pair<int, int>(p2, p1));
+                        if (!on_border(p1, p0))
+                            BFS_edges.push_back(std::pair<int, int>(p1, p0));
                     }
                     else if (p0 != v0 && p0 != v1)
                     {
-                        pair<int, int> pt10 = std::pair<int, int>(p1, p0), pt02 = std::pair<int, int>(p0, p2);
-                        if (border_map.find(pt10) == border_map.end())
-                            BFS_edges.push_back(pt10);
-                        if (border_map.find(pt02) == border_map.end())
-                            BFS_edges.push_back(pt02);
+                        if (!on_border(p1, p0))
+                            BFS_edges.push_back(std::pair<int, int>(p1, p0));
+                        if (!on_border(p0, p2))
+                            BFS_edges.push_back(std::pair<int, int>(p0, p2));
                     }
                 }
             }
-            else if (i >= (int)border_edges.size() && (edge_map.find(edge01) != edge_map.end() ||
-                                                       edge_map.find(edge10) != edge_map.end()))
+            else if (i >= (int)border_edges.size() && (has01 || has10))
             {
                 for (int j = 0; j < 2; j++)
                 {
                     if (j == 0)
-                        if (edge_map.find(edge01) != edge_map.end())
-                            idx = edge_map[edge01].first;
-                        else
-                            idx = edge_map[edge10].first;
-                    else if (edge_map.find(edge01) != edge_map.end())
-                        idx = edge_map[edge01].second;
+                        idx = has01 ? first01 : first10;
                     else
-                        idx = edge_map[edge10].second;
+                        idx = has01 ? second01 : second10;
                     if (idx != -1 && !remove_map[idx])
                     {
                         remove_map[idx] = true;
@@ -397,6 +766,7 @@ namespace coacd
         }
 
         int index = 0;
+        vertex_map.assign(border.size() + 1, 0);
         for (int i = 0; i < (int)border.size(); i++)
         {
             if (i < oriN || add_vertex[i] == true)
@@ -409,390 +779,612 @@ namespace coacd
         delete[] remove_map;
     }
 
-    bool Clip(const Model &mesh, Model &pos, Model &neg, Plane &plane, double &cut_area, bool foo)
+    // Where the plane crosses the three edges of a triangle
+    struct TriangleCut
+    {
+        bool f0, f1, f2;
+        vec3d pi0, pi1, pi2;
+    };
+
+    // Meshes with at least this many triangles are clipped by the data-parallel path
+    static const int PARALLEL_CLIP_CUTOFF = 100000;
+
+    // Bookkeeping of Clip, kept per thread so repeated clips reuse the storage
+    struct ClipScratch
     {
-        Model t = mesh;
-        vector<vec3d> border;
-        vector<vec3d> overlap;
-        vector<vec3i> border_triangles, final_triangles;
+        vector<char> pos_map, neg_map;
+        vector<int> pos_proj, neg_proj;
+        vector<int> vertex_map;  // mesh vertex on the plane -> border point
+        FlatIndexMap edge_map;   // mesh edge crossing the plane -> border point
+        BorderWelder welder;
+        vector<vec3d> border, overlap;
         vector<pair<int, int>> border_edges;
-        map<int, int> border_map;
-        vector<vec3d> final_border;
+        int idx;                 // next border point index
 
-        const int N = (int)mesh.points.size();
-        int idx = 0;
-        bool *pos_map = new bool[N]();
-        bool *neg_map = new bool[N]();
-
-        map<pair<int, int>, int> edge_map;
-        map<int, int> vertex_map;
-
-        for (int i = 0; i < (int)mesh.triangles.size(); i++)
-        {
-            int id0, id1, id2;
-            id0 = mesh.triangles[i][0];
-            id1 = mesh.triangles[i][1];
-            id2 = mesh.triangles[i][2];
-            vec3d p0, p1, p2;
-            p0 = mesh.points[id0];
-            p1 = mesh.points[id1];
-            p2 = mesh.points[id2];
-            short s0 = plane.Side(p0), s1 = plane.Side(p1), s2 = plane.Side(p2);
-            short sum = s0 + s1 + s2;
-            if (s0 == 0 && s1 == 0 && s2 == 0)
-            {
-                s0 = s1 = s2 = plane.CutSide(p0, p1, p2, plane);
-                sum = s0 + s1 + s2;
-                overlap.push_back(p0);
-                overlap.push_back(p1);
-                overlap.push_back(p2);
-            }
-
-            if (sum == 3 || sum == 2 || (sum == 1 && ((s0 == 1 && s1 == 0 && s2 == 0) || (s0 == 0 && s1 == 1 && s2 == 0) || (s0 == 0 && s1 == 0 && s2 == 1)))) // pos side
-            {
-                pos_map[id0] = true;
-                pos_map[id1] = true;
-                pos_map[id2] = true;
-                pos.triangles.push_back(mesh.triangles[i]);
-                // the plane cross the triangle edge
-                if (sum == 1)
+        // data-parallel path
+        vector<signed char> side;
+        vector<int> tri_class;   // PURE_POS, PURE_NEG, or the index of a triangle touching the plane
+        vector<int> specials, pos_offsets, neg_offsets, special_pos, special_neg;
+        vector<TriangleCut> cuts;
+        vector<vec3i> special_pos_tris, special_neg_tris;
+    };
+
+    static thread_local ClipScratch clip_scratch;
+
+    static void CutTriangle(Plane &plane, const vec3d &p0, const vec3d &p1, const vec3d &p2, TriangleCut &cut)
+    {
+        cut.f0 = plane.IntersectSegment(p0, p1, cut.pi0);
+        cut.f1 = plane.IntersectSegment(p1, p2, cut.pi1);
+        cut.f2 = plane.IntersectSegment(p2, p0, cut.pi2);
+    }
+
+    // Sorts triangle i into pos_tris/neg_tris from the sides of its vertices, splitting it and recording the
+    // border where the plane runs through it. cut holds its edge intersections if they are already known.
+    static void ClipTriangle(const Model &mesh, Plane &plane, int i, short s0, short s1, short s2, const TriangleCut *cut,
+                             ClipScratch &scratch, vector<vec3i> &pos_tris, vector<vec3i> &neg_tris)
+    {
+        vector<char> &pos_map = scratch.pos_map, &neg_map = scratch.neg_map;
+        vector<int> &vertex_map = scratch.vertex_map;
+        FlatIndexMap &edge_map = scratch.edge_map;
+        BorderWelder &welder = scratch.welder;
+        vector<vec3d> &border = scratch.border, &overlap = scratch.overlap;
+        vector<pair<int, int>> &border_edges = scratch.border_edges;
+        int &idx = scratch.idx;
+
+        int id0, id1, id2;
+        id0 = mesh.triangles[i][0];
+        id1 = mesh.triangles[i][1];
+        id2 = mesh.triangles[i][2];
+        vec3d p0, p1, p2;
+        p0 = mesh.points[id0];
+        p1 = mesh.points[id1];
+        p2 = mesh.points[id2];
+        short sum = s0 + s1 + s2;
+        if (s0 == 0 && s1 == 0 && s2 == 0)
+        {
+            s0 = s1 = s2 = plane.CutSide(p0, p1, p2, plane);
+            sum = s0 + s1 + s2;
+            overlap.push_back(p0);
+            overlap.push_back(p1);
+            overlap.push_back(p2);
+        }
+
+        if (sum == 3 || sum == 2 || (sum == 1 && ((s0 == 1 && s1 == 0 && s2 == 0) || (s0 == 0 && s1 == 1 && s2 == 0) || (s0 == 0 && s1 == 0 && s2 == 1)))) // pos side
+        {
+            pos_map[id0] = true;
+            pos_map[id1] = true;
+            pos_map[id2] = true;
+            pos_tris.push_back(mesh.triangles[i]);
+            // the plane cross the triangle edge
+            if (sum == 1)
+            {
+                if (s0 == 1 && s1 == 0 && s2 == 0)
+                {
+                    addPoint(vertex_map, welder, border, p1, id1, idx);
+                    addPoint(vertex_map, welder, border, p2, id2, idx);
+                    if (vertex_map[id1] != vertex_map[id2])
+                        border_edges.push_back(std::pair<int, int>(vertex_map[id1] + 1, vertex_map[id2] + 1));
+                }
+                else if (s0 == 0 && s1 == 1 && s2 == 0)
+                {
+                    addPoint(vertex_map, welder, border, p2, id2, idx);
+                    addPoint(vertex_map, welder, border, p0, id0, idx);
+                    if (vertex_map[id2] != vertex_map[id0])
+                        border_edges.push_back(std::pair<int, int>(vertex_map[id2] + 1, vertex_map[id0] + 1));
+                }
+                else if (s0 == 0 && s1 == 0 && s2 == 1)
+                {
+                    addPoint(vertex_map, welder, border, p0, id0, idx);
+                    addPoint(vertex_map, welder, border, p1, id1, idx);
+                    if (vertex_map[id0] != vertex_map[id1])
+                        border_edges.push_back(std::pair<int, int>(vertex_map[id0] + 1, vertex_map[id1] + 1));
+                }
+            }
+        }
+        else if (sum == -3 || sum == -2 || (sum == -1 && ((s0 == -1 && s1 == 0 && s2 == 0) || (s0 == 0 && s1 == -1 && s2 == 0) || (s0 == 0 && s1 == 0 && s2 == -1)))) // neg side
+        {
+            neg_map[id0] = true;
+            neg_map[id1] = true;
+            neg_map[id2] = true;
+            neg_tris.push_back(mesh.triangles[i]);
+            // the plane cross the triangle edge
+            if (sum == -1)
+            {
+                if (s0 == -1 && s1 == 0 && s2 == 0)
+                {
+                    addPoint(vertex_map, welder, border, p2, id2, idx);
+                    addPoint(vertex_map, welder, border, p1, id1, idx);
+                    if (vertex_map[id2] != vertex_map[id1])
+                        border_edges.push_back(std::pair<int, int>(vertex_map[id2] + 1, vertex_map[id1] + 1));
+                }
+                else if (s0 == 0 && s1 == -1 && s2 == 0)
+                {
+                    addPoint(vertex_map, welder, border, p0, id0, idx);
+                    addPoint(vertex_map, welder, border, p2, id2, idx);
+                    if (vertex_map[id0] != vertex_map[id2])
+                        border_edges.push_back(std::pair<int, int>(vertex_map[id0] + 1, vertex_map[id2] + 1));
+                }
+                else if (s0 == 0 && s1 == 0 && s2 == -1)
+                {
+                    addPoint(vertex_map, welder, border, p1, id1, idx);
+                    addPoint(vertex_map, welder, border, p0, id0, idx);
+                    if (vertex_map[id1] != vertex_map[id0])
+                        border_edges.push_back(std::pair<int, int>(vertex_map[id1] + 1, vertex_map[id0] + 1));
+                }
+            }
+        }
+        else // different side
+        {
+            TriangleCut local;
+            if (!cut)
+            {
+                CutTriangle(plane, p0, p1, p2, local);
+                cut = &local;
+            }
+            const bool f0 = cut->f0, f1 = cut->f1, f2 = cut->f2;
+            const vec3d &pi0 = cut->pi0, &pi1 = cut->pi1, &pi2 = cut->pi2;
+
+            if (f0 && f1 && !f2)
+            {
+                // record the points
+                // f0
+                addEdgePoint(edge_map, welder, border, pi0, id0, id1, idx);
+                // f1
+                addEdgePoint(edge_map, welder, border, pi1, id1, id2, idx);
+
+                // record the edges
+                int f0_idx = *edge_map.Find(EdgeKey(id0, id1));
+                int f1_idx = *edge_map.Find(EdgeKey(id1, id2));
+                if (s1 == 1)
+                {
+                    if (f1_idx != f0_idx)
+                    {
+                        border_edges.push_back(std::pair<int, int>(f1_idx + 1, f0_idx + 1)); // border
+                        pos_map[id1] = true;
+                        neg_map[id0] = true;
+                        neg_map[id2] = true;
+                        pos_tris.push_back({id1, -1 * f1_idx - 1, -1 * f0_idx - 1}); // make sure it is not zero
+                        neg_tris.push_back({id0, -1 * f0_idx - 1, -1 * f1_idx - 1});
+                        neg_tris.push_back({-1 * f1_idx - 1, id2, id0});
+                    }
+                    else
+                    {
+                        neg_map[id0] = true;
+                        neg_map[id2] = true;
+                        neg_tris.push_back({-1 * f1_idx - 1, id2, id0});
+                    }
+                }
+                else
+                {
+                    if (f0_idx != f1_idx)
+                    {
+                        border_edges.push_back(std::pair<int, int>(f0_idx + 1, f1_idx + 1)); // border
+                        neg_map[id1] = true;
+                        pos_map[id0] = true;
+                        pos_map[id2] = true;
+                        neg_tris.push_back({id1, -1 * f1_idx - 1, -1 * f0_idx - 1});
+                        pos_tris.push_back({id0, -1 * f0_idx - 1, -1 * f1_idx - 1});
+                        pos_tris.push_back({-1 * f1_idx - 1, id2, id0});
+                    }
+                    else
+                    {
+                        pos_map[id0] = true;
+                        pos_map[id2] = true;
+                        pos_tris.push_back({-1 * f1_idx - 1, id2, id0});
+                    }
+                }
+            }
+            else if (f1 && f2 && !f0)
+            {
+                // f1
+                addEdgePoint(edge_map, welder, border, pi1, id1, id2, idx);
+                // f2
+                addEdgePoint(edge_map, welder, border, pi2, id2, id0, idx);
+
+                // record the edges
+                int f1_idx = *edge_map.Find(EdgeKey(id1, id2));
+                int f2_idx = *edge_map.Find(EdgeKey(id2, id0));
+                if (s2 == 1)
                 {
-                    if (s0 == 1 && s1 == 0 && s2 == 0)
+                    if (f2_idx != f1_idx)
                     {
-                        addPoint(vertex_map, border, p1, id1, idx);
-                        addPoint(vertex_map, border, p2, id2, idx);
-                        if (vertex_map[id1] != vertex_map[id2])
-                            border_edges.push_back(std::pair<int, int>(vertex_map[id1] + 1, vertex_map[id2] + 1));
+                        border_edges.push_back(std::pair<int, int>(f2_idx + 1, f1_idx + 1));
+                        pos_map[id2] = true;
+                        neg_map[id0] = true;
+                        neg_map[id1] = true;
+                        pos_tris.push_back({id2, -1 * f2_idx - 1, -1 * f1_idx - 1});
+                        neg_tris.push_back({id0, -1 * f1_idx - 1, -1 * f2_idx - 1});
+                        neg_tris.push_back({-1 * f1_idx - 1, id0, id1});
                     }
-                    else if (s0 == 0 && s1 == 1 && s2 == 0)
+                    else
                     {
-                        addPoint(vertex_map, border, p2, id2, idx);
-                        addPoint(vertex_map, border, p0, id0, idx);
-                        if (vertex_map[id2] != vertex_map[id0])
-                            border_edges.push_back(std::pair<int, int>(vertex_map[id2] + 1, vertex_map[id0] + 1));
+                        neg_map[id0] = true;
+                        neg_map[id1] = true;
+                        neg_tris.push_back({-1 * f1_idx - 1, id0, id1});
                     }
-                    else if (s0 == 0 && s1 == 0 && s2 == 1)
+                }
+                else
+                {
+                    if (f1_idx != f2_idx)
+                    {
+                        border_edges.push_back(std::pair<int, int>(f1_idx + 1, f2_idx + 1));
+                        neg_map[id2] = true;
+                        pos_map[id0] = true;
+                        pos_map[id1] = true;
+                        neg_tris.push_back({id2, -1 * f2_idx - 1, -1 * f1_idx - 1});
+                        pos_tris.push_back({id0, -1 * f1_idx - 1, -1 * f2_idx - 1});
+                        pos_tris.push_back({-1 * f1_idx - 1, id0, id1});
+                    }
+                    else
                     {
-                        addPoint(vertex_map, border, p0, id0, idx);
-                        addPoint(vertex_map, border, p1, id1, idx);
-                        if (vertex_map[id0] != vertex_map[id1])
-                            border_edges.push_back(std::pair<int, int>(vertex_map[id0] + 1, vertex_map[id1] + 1));
+                        pos_map[id0] = true;
+                        pos_map[id1] = true;
+                        pos_tris.push_back({-1 * f1_idx - 1, id0, id1});
                     }
                 }
             }
-            else if (sum == -3 || sum == -2 || (sum == -1 && ((s0 == -1 && s1 == 0 && s2 == 0) || (s0 == 0 && s1 == -1 && s2 == 0) || (s0 == 0 && s1 == 0 && s2 == -1)))) // neg side
+            else if (f2 && f0 && !f1)
             {
-                neg_map[id0] = true;
-                neg_map[id1] = true;
-                neg_map[id2] = true;
-                neg.triangles.push_back(mesh.triangles[i]);
-                // the plane cross the triangle edge
-                if (sum == -1)
+                // f2
+                addEdgePoint(edge_map, welder, border, pi2, id2, id0, idx);
+                // f0
+                addEdgePoint(edge_map, welder, border, pi0, id0, id1, idx);
+
+                int f0_idx = *edge_map.Find(EdgeKey(id0, id1));
+                int f2_idx = *edge_map.Find(EdgeKey(id2, id0));
+                if (s0 == 1)
                 {
-                    if (s0 == -1 && s1 == 0 && s2 == 0)
+                    if (f0_idx != f2_idx)
                     {
-                        addPoint(vertex_map, border, p2, id2, idx);
-                        addPoint(vertex_map, border, p1, id1, idx);
-                        if (vertex_map[id2] != vertex_map[id1])
-                            border_edges.push_back(std::pair<int, int>(vertex_map[id2] + 1, vertex_map[id1] + 1));
+                        border_edges.push_back(std::pair<int, int>(f0_idx + 1, f2_idx + 1));
+                        pos_map[id0] = true;
+                        neg_map[id1] = true;
+                        neg_map[id2] = true;
+                        pos_tris.push_back({id0, -1 * f0_idx - 1, -1 * f2_idx - 1});
+                        neg_tris.push_back({id1, -1 * f2_idx - 1, -1 * f0_idx - 1});
+                        neg_tris.push_back({-1 * f2_idx - 1, id1, id2});
                     }
-                    else if (s0 == 0 && s1 == -1 && s2 == 0)
+                    else
                     {
-                        addPoint(vertex_map, border, p0, id0, idx);
-                        addPoint(vertex_map, border, p2, id2, idx);
-                        if (vertex_map[id0] != vertex_map[id2])
-                            border_edges.push_back(std::pair<int, int>(vertex_map[id0] + 1, vertex_map[id2] + 1));
+                        neg_map[id1] = true;
+                        neg_map[id2] = true;
+                        neg_tris.push_back({-1 * f2_idx - 1, id1, id2});
                     }
-                    else if (s0 == 0 && s1 == 0 && s2 == -1)
+                }
+                else
+                {
+                    if (f2_idx != f0_idx)
                     {
-                        addPoint(vertex_map, border, p1, id1, idx);
-                        addPoint(vertex_map, border, p0, id0, idx);
-                        if (vertex_map[id1] != vertex_map[id0])
-                            border_edges.push_back(std::pair<int, int>(vertex_map[id1] + 1, vertex_map[id0] + 1));
+                        border_edges.push_back(std::pair<int, int>(f2_idx + 1, f0_idx + 1));
+                        neg_map[id0] = true;
+                        pos_map[id1] = true;
+                        pos_map[id2] = true;
+                        neg_tris.push_back({id0, -1 * f0_idx - 1, -1 * f2_idx - 1});
+                        pos_tris.push_back({id1, -1 * f2_idx - 1, -1 * f0_idx - 1});
+                        pos_tris.push_back({-1 * f2_idx - 1, id1, id2});
+                    }
+                    else
+                    {
+                        pos_map[id1] = true;
+                        pos_map[id2] = true;
+                        pos_tris.push_back({-1 * f2_idx - 1, id1, id2});
                     }
                 }
             }
-            else // different side
+            else if (f0 && f1 && f2)
             {
-                bool f0, f1, f2;
-                vec3d pi0, pi1, pi2;
-                f0 = plane.IntersectSegment(p0, p1, pi0);
-                f1 = plane.IntersectSegment(p1, p2, pi1);
-                f2 = plane.IntersectSegment(p2, p0, pi2);
-
-                if (f0 && f1 && !f2)
+                if (s0 == 0 || (s0 != 0 && s1 != 0 && s2 != 0 && SamePointDetect(pi0, pi2))) // intersect at p0
                 {
-                    // record the points
-                    // f0
-                    addEdgePoint(edge_map, border, pi0, id0, id1, idx);
-                    // f1
-                    addEdgePoint(edge_map, border, pi1, id1, id2, idx);
+                    // f2 = f0 = p0
+                    addPoint(vertex_map, welder, border, p0, id0, idx);
+                    edge_map.Value(EdgeKey(id0, id1), 0) = vertex_map[id0];
+                    edge_map.Value(EdgeKey(id2, id0), 0) = vertex_map[id0];
 
-                    // record the edges
-                    int f0_idx = edge_map[std::pair<int, int>(id0, id1)];
-                    int f1_idx = edge_map[std::pair<int, int>(id1, id2)];
+                    // f1
+                    addEdgePoint(edge_map, welder, border, pi1, id1, id2, idx);
+                    int f1_idx = *edge_map.Find(EdgeKey(id1, id2));
+                    int f0_idx = vertex_map[id0];
                     if (s1 == 1)
                     {
                         if (f1_idx != f0_idx)
                         {
-                            border_edges.push_back(std::pair<int, int>(f1_idx + 1, f0_idx + 1)); // border
+                            border_edges.push_back(std::pair<int, int>(f1_idx + 1, f0_idx + 1));
                             pos_map[id1] = true;
-                            neg_map[id0] = true;
                             neg_map[id2] = true;
-                            pos.triangles.push_back({id1, -1 * f1_idx - 1, -1 * f0_idx - 1}); // make sure it is not zero
-                            neg.triangles.push_back({id0, -1 * f0_idx - 1, -1 * f1_idx - 1});
-                            neg.triangles.push_back({-1 * f1_idx - 1, id2, id0});
-                        }
-                        else
-                        {
-                            neg_map[id0] = true;
-                            neg_map[id2] = true;
-                            neg.triangles.push_back({-1 * f1_idx - 1, id2, id0});
+                            pos_tris.push_back({id1, -1 * f1_idx - 1, -1 * f0_idx - 1});
+                            neg_tris.push_back({id2, -1 * f0_idx - 1, -1 * f1_idx - 1});
                         }
                     }
                     else
                     {
                         if (f0_idx != f1_idx)
                         {
-                            border_edges.push_back(std::pair<int, int>(f0_idx + 1, f1_idx + 1)); // border
+                            border_edges.push_back(std::pair<int, int>(f0_idx + 1, f1_idx + 1));
                             neg_map[id1] = true;
-                            pos_map[id0] = true;
                             pos_map[id2] = true;
-                            neg.triangles.push_back({id1, -1 * f1_idx - 1, -1 * f0_idx - 1});
-                            pos.triangles.push_back({id0, -1 * f0_idx - 1, -1 * f1_idx - 1});
-                            pos.triangles.push_back({-1 * f1_idx - 1, id2, id0});
-                        }
-                        else
-                        {
-                            pos_map[id0] = true;
-                            pos_map[id2] = true;
-                            pos.triangles.push_back({-1 * f1_idx - 1, id2, id0});
+                            neg_tris.push_back({id1, -1 * f1_idx - 1, -1 * f0_idx - 1});
+                            pos_tris.push_back({id2, -1 * f0_idx - 1, -1 * f1_idx - 1});
                         }
                     }
                 }
-                else if (f1 && f2 && !f0)
+                else if (s1 == 0 || (s0 != 0 && s1 != 0 && s2 != 0 && SamePointDetect(pi0, pi1))) // intersect at p1
                 {
-                    // f1
-                    addEdgePoint(edge_map, border, pi1, id1, id2, idx);
-                    // f2
-                    addEdgePoint(edge_map, border, pi2, id2, id0, idx);
+                    // f0 = f1 = p1
+                    addPoint(vertex_map, welder, border, p1, id1, idx);
+                    edge_map.Value(EdgeKey(id0, id1), 0) = vertex_map[id1];
+                    edge_map.Value(EdgeKey(id1, id2), 0) = vertex_map[id1];
 
-                    // record the edges
-                    int f1_idx = edge_map[std::pair<int, int>(id1, id2)];
-                    int f2_idx = edge_map[std::pair<int, int>(id2, id0)];
-                    if (s2 == 1)
-                    {
-                        if (f2_idx != f1_idx)
-                        {
-                            border_edges.push_back(std::pair<int, int>(f2_idx + 1, f1_idx + 1));
-                            pos_map[id2] = true;
-                            neg_map[id0] = true;
-                            neg_map[id1] = true;
-                            pos.triangles.push_back({id2, -1 * f2_idx - 1, -1 * f1_idx - 1});
-                            neg.triangles.push_back({id0, -1 * f1_idx - 1, -1 * f2_idx - 1});
-                            neg.triangles.push_back({-1 * f1_idx - 1, id0, id1});
-                        }
-                        else
-                        {
-                            neg_map[id0] = true;
-                            neg_map[id1] = true;
-                            neg.triangles.push_back({-1 * f1_idx - 1, id0, id1});
-                        }
-                    }
-                    else
+                    // f2
+                    addEdgePoint(edge_map, welder, border, pi2, id2, id0, idx);
+                    int f1_idx = vertex_map[id1];
+                    int f2_idx = *edge_map.Find(EdgeKey(id2, id0));
+                    if (s0 == 1)
                     {
                         if (f1_idx != f2_idx)
                         {
                             border_edges.push_back(std::pair<int, int>(f1_idx + 1, f2_idx + 1));
-                            neg_map[id2] = true;
                             pos_map[id0] = true;
-                            pos_map[id1] = true;
-                            neg.triangles.push_back({id2, -1 * f2_idx - 1, -1 * f1_idx - 1});
-                            pos.triangles.push_back({id0, -1 * f1_idx - 1, -1 * f2_idx - 1});
-                            pos.triangles.push_back({-1 * f1_idx - 1, id0, id1});
+                            neg_map[id2] = true;
+                            pos_tris.push_back({id0, -1 * f1_idx - 1, -1 * f2_idx - 1});
+                            neg_tris.push_back({id2, -1 * f2_idx - 1, -1 * f1_idx - 1});
                         }
-                        else
+                    }
+                    else
+                    {
+                        if (f2_idx != f1_idx)
                         {
-                            pos_map[id0] = true;
-                            pos_map[id1] = true;
-                            pos.triangles.push_back({-1 * f1_idx - 1, id0, id1});
+                            border_edges.push_back(std::pair<int, int>(f2_idx + 1, f1_idx + 1));
+                            neg_map[id0] = true;
+                            pos_map[id2] = true;
+                            neg_tris.push_back({id0, -1 * f1_idx - 1, -1 * f2_idx - 1});
+                            pos_tris.push_back({id2, -1 * f2_idx - 1, -1 * f1_idx - 1});
                         }
                     }
                 }
-                else if (f2 && f0 && !f1)
+                else if (s2 == 0 || (s0 != 0 && s1 != 0 && s2 != 0 && SamePointDetect(pi1, pi2))) // intersect at p2
                 {
-                    // f2
-                    addEdgePoint(edge_map, border, pi2, id2, id0, idx);
-                    // f0
-                    addEdgePoint(edge_map, border, pi0, id0, id1, idx);
+                    // f1 = f2 = p2
+                    addPoint(vertex_map, welder, border, p2, id2, idx);
+                    edge_map.Value(EdgeKey(id1, id2), 0) = vertex_map[id2];
+                    edge_map.Value(EdgeKey(id2, id0), 0) = vertex_map[id2];
 
-                    int f0_idx = edge_map[std::pair<int, int>(id0, id1)];
-                    int f2_idx = edge_map[std::pair<int, int>(id2, id0)];
+                    // f0
+                    addEdgePoint(edge_map, welder, border, pi0, id0, id1, idx);
+                    int f0_idx = *edge_map.Find(EdgeKey(id0, id1));
+                    int f1_idx = vertex_map[id2];
                     if (s0 == 1)
                     {
-                        if (f0_idx != f2_idx)
+                        if (f0_idx != f1_idx)
                         {
-                            border_edges.push_back(std::pair<int, int>(f0_idx + 1, f2_idx + 1));
+                            border_edges.push_back(std::pair<int, int>(f0_idx + 1, f1_idx + 1));
                             pos_map[id0] = true;
                             neg_map[id1] = true;
-                            neg_map[id2] = true;
-                            pos.triangles.push_back({id0, -1 * f0_idx - 1, -1 * f2_idx - 1});
-                            neg.triangles.push_back({id1, -1 * f2_idx - 1, -1 * f0_idx - 1});
-                            neg.triangles.push_back({-1 * f2_idx - 1, id1, id2});
-                        }
-                        else
-                        {
-                            neg_map[id1] = true;
-                            neg_map[id2] = true;
-                            neg.triangles.push_back({-1 * f2_idx - 1, id1, id2});
+                            pos_tris.push_back({id0, -1 * f0_idx - 1, -1 * f1_idx - 1});
+                            neg_tris.push_back({id1, -1 * f1_idx - 1, -1 * f0_idx - 1});
                         }
                     }
                     else
                     {
-                        if (f2_idx != f0_idx)
+                        if (f1_idx != f0_idx)
                         {
-                            border_edges.push_back(std::pair<int, int>(f2_idx + 1, f0_idx + 1));
+                            border_edges.push_back(std::pair<int, int>(f1_idx + 1, f0_idx + 1));
                             neg_map[id0] = true;
                             pos_map[id1] = true;
-                            pos_map[id2] = true;
-                            neg.triangles.push_back({id0, -1 * f0_idx - 1, -1 * f2_idx - 1});
-                            pos.triangles.push_back({id1, -1 * f2_idx - 1, -1 * f0_idx - 1});
-                            pos.triangles.push_back({-1 * f2_idx - 1, id1, id2});
-                        }
-                        else
-                        {
-                            pos_map[id1] = true;
-                            pos_map[id2] = true;
-                            pos.triangles.push_back({-1 * f2_idx - 1, id1, id2});
+                            neg_tris.push_back({id0, -1 * f0_idx - 1, -1 * f1_idx - 1});
+                            pos_tris.push_back({id1, -1 * f1_idx - 1, -1 * f0_idx - 1});
                         }
                     }
                 }
-                else if (f0 && f1 && f2)
+                else
+                    throw runtime_error("Intersection error. Please report this error to sarahwei0210@gmail.com with your input OBJ and log file.");
+            }
+        }
+    }
+
+    // Exclusive prefix sum offsets[i] = count(0) + ... + count(i - 1), in parallel blocks; returns the total
+    template <typename Count>
+    static int PrefixSum(int n, const Count &count, vector<int> &offsets, bool parallel)
+    {
+        const int block = 1 << 14;
+        const int n_blocks = (n + block - 1) / block;
+        vector<int> block_sums(n_blocks + 1, 0);
+        offsets.resize(n);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if (parallel)
+#endif
+        for (int b = 0; b < n_blocks; b++)
+        {
+            int sum = 0;
+            for (int i = b * block; i < min(n, (b + 1) * block); i++)
+            {
+                offsets[i] = sum;
+                sum += count(i);
+            }
+            block_sums[b + 1] = sum;
+        }
+        for (int b = 0; b < n_blocks; b++)
+            block_sums[b + 1] += block_sums[b];
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if (parallel)
+#endif
+        for (int b = 1; b < n_blocks; b++)
+            for (int i = b * block; i < min(n, (b + 1) * block); i++)
+                offsets[i] += block_sums[b];
+        return block_sums[n_blocks];
+    }
+
+    static const int PURE_POS = -1, PURE_NEG = -2, SPECIAL = -3;
+
+    // Data-parallel triangle pass for large meshes. Every vertex is classified once; triangles entirely on one
+    // side are copied in parallel, and only the triangles touching the plane go through ClipTriangle, in mesh
+    // order, so the border and both triangle lists come out exactly as from the serial pass.
+    static void ClipTrianglesParallel(const Model &mesh, Plane &plane, ClipScratch &scratch, vector<vec3i> &pos_tris, vector<vec3i> &neg_tris)
+    {
+        const int N = (int)mesh.points.size(), M = (int)mesh.triangles.size();
+        const vec3d *points = mesh.points.data();
+        const vec3i *triangles = mesh.triangles.data();
+        const double a = plane.a, b = plane.b, c = plane.c, d = plane.d, eps = 1e-6;
+
+        // signed distances, evaluated as Plane::Side does
+        scratch.side.resize(N);
+        signed char *side = scratch.side.data();
+#ifdef _OPENMP
+#pragma omp parallel for simd schedule(static)
+#endif
+        for (int i = 0; i < N; i++)
+        {
+            double res = points[i][0] * a + points[i][1] * b + points[i][2] * c + d;
+            side[i] = (signed char)((res > eps) - (res < -1 * eps));
+        }
+
+        // triangles with two vertices strictly on one side and the third not across never touch the border
+        vector<int> &tri_class = scratch.tri_class;
+        char *pos_map = scratch.pos_map.data(), *neg_map = scratch.neg_map.data();
+        tri_class.resize(M);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (int i = 0; i < M; i++)
+        {
+            const vec3i &t = triangles[i];
+            int sum = side[t[0]] + side[t[1]] + side[t[2]];
+            char *map = sum >= 2 ? pos_map : sum <= -2 ? neg_map : nullptr;
+            tri_class[i] = sum >= 2 ? PURE_POS : sum <= -2 ? PURE_NEG : SPECIAL;
+            if (map)
+                for (int k = 0; k < 3; k++)
                 {
-                    if (s0 == 0 || (s0 != 0 && s1 != 0 && s2 != 0 && SamePointDetect(pi0, pi2))) // intersect at p0
-                    {
-                        // f2 = f0 = p0
-                        addPoint(vertex_map, border, p0, id0, idx);
-                        edge_map[std::pair<int, int>(id0, id1)] = vertex_map[id0];
-                        edge_map[std::pair<int, int>(id1, id0)] = vertex_map[id0];
-                        edge_map[std::pair<int, int>(id2, id0)] = vertex_map[id0];
-                        edge_map[std::pair<int, int>(id0, id2)] = vertex_map[id0];
-
-                        // f1
-                        addEdgePoint(edge_map, border, pi1, id1, id2, idx);
-                        int f1_idx = edge_map[std::pair<int, int>(id1, id2)];
-                        int f0_idx = vertex_map[id0];
-                        if (s1 == 1)
-                        {
-                            if (f1_idx != f0_idx)
-                            {
-                                border_edges.push_back(std::pair<int, int>(f1_idx + 1, f0_idx + 1));
-                                pos_map[id1] = true;
-                                neg_map[id2] = true;
-                                pos.triangles.push_back({id1, -1 * f1_idx - 1, -1 * f0_idx - 1});
-                                neg.triangles.push_back({id2, -1 * f0_idx - 1, -1 * f1_idx - 1});
-                            }
-                        }
-                        else
-                        {
-                            if (f0_idx != f1_idx)
-                            {
-                                border_edges.push_back(std::pair<int, int>(f0_idx + 1, f1_idx + 1));
-                                neg_map[id1] = true;
-                                pos_map[id2] = true;
-                                neg.triangles.push_back({id1, -1 * f1_idx - 1, -1 * f0_idx - 1});
-                                pos.triangles.push_back({id2, -1 * f0_idx - 1, -1 * f1_idx - 1});
-                            }
-                        }
-                    }
-                    else if (s1 == 0 || (s0 != 0 && s1 != 0 && s2 != 0 && SamePointDetect(pi0, pi1))) // intersect at p1
-                    {
-                        // f0 = f1 = p1
-                        addPoint(vertex_map, border, p1, id1, idx);
-                        edge_map[std::pair<int, int>(id0, id1)] = vertex_map[id1];
-                        edge_map[std::pair<int, int>(id1, id0)] = vertex_map[id1];
-                        edge_map[std::pair<int, int>(id1, id2)] = vertex_map[id1];
-                        edge_map[std::pair<int, int>(id2, id1)] = vertex_map[id1];
-
-                        // f2
-                        addEdgePoint(edge_map, border, pi2, id2, id0, idx);
-                        int f1_idx = vertex_map[id1];
-                        int f2_idx = edge_map[std::pair<int, int>(id2, id0)];
-                        if (s0 == 1)
-                        {
-                            if (f1_idx != f2_idx)
-                            {
-                                border_edges.push_back(std::pair<int, int>(f1_idx + 1, f2_idx + 1));
-                                pos_map[id0] = true;
-                                neg_map[id2] = true;
-                                pos.triangles.push_back({id0, -1 * f1_idx - 1, -1 * f2_idx - 1});
-                                neg.triangles.push_back({id2, -1 * f2_idx - 1, -1 * f1_idx - 1});
-                            }
-                        }
-                        else
-                        {
-                            if (f2_idx != f1_idx)
-                            {
-                                border_edges.push_back(std::pair<int, int>(f2_idx + 1, f1_idx + 1));
-                                neg_map[id0] = true;
-                                pos_map[id2] = true;
-                                neg.triangles.push_back({id0, -1 * f1_idx - 1, -1 * f2_idx - 1});
-                                pos.triangles.push_back({id2, -1 * f2_idx - 1, -1 * f1_idx - 1});
-                            }
-                        }
-                    }
-                    else if (s2 == 0 || (s0 != 0 && s1 != 0 && s2 != 0 && SamePointDetect(pi1, pi2))) // intersect at p2
-                    {
-                        // f1 = f2 = p2
-                        addPoint(vertex_map, border, p2, id2, idx);
-                        edge_map[std::pair<int, int>(id1, id2)] = vertex_map[id2];
-                        edge_map[std::pair<int, int>(id2, id1)] = vertex_map[id2];
-                        edge_map[std::pair<int, int>(id2, id0)] = vertex_map[id2];
-                        edge_map[std::pair<int, int>(id0, id2)] = vertex_map[id2];
-
-                        // f0
-                        addEdgePoint(edge_map, border, pi0, id0, id1, idx);
-                        int f0_idx = edge_map[std::pair<int, int>(id0, id1)];
-                        int f1_idx = vertex_map[id2];
-                        if (s0 == 1)
-                        {
-                            if (f0_idx != f1_idx)
-                            {
-                                border_edges.push_back(std::pair<int, int>(f0_idx + 1, f1_idx + 1));
-                                pos_map[id0] = true;
-                                neg_map[id1] = true;
-                                pos.triangles.push_back({id0, -1 * f0_idx - 1, -1 * f1_idx - 1});
-                                neg.triangles.push_back({id1, -1 * f1_idx - 1, -1 * f0_idx - 1});
-                            }
-                        }
-                        else
-                        {
-                            if (f1_idx != f0_idx)
-                            {
-                                border_edges.push_back(std::pair<int, int>(f1_idx + 1, f0_idx + 1));
-                                neg_map[id0] = true;
-                                pos_map[id1] = true;
-                                neg.triangles.push_back({id0, -1 * f0_idx - 1, -1 * f1_idx - 1});
-                                pos.triangles.push_back({id1, -1 * f1_idx - 1, -1 * f0_idx - 1});
-                            }
-                        }
-                    }
-                    else
-                        throw runtime_error("Intersection error. Please report this error to sarahwei0210@gmail.com with your input OBJ and log file.");
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
+                    map[t[k]] = 1;
                 }
+        }
+
+        vector<int> &specials = scratch.specials;
+        const int n_specials = PrefixSum(M, [&](int i) { return (int)(tri_class[i] == SPECIAL); }, scratch.pos_offsets, true);
+        specials.resize(n_specials);
+        scratch.cuts.resize(n_specials);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (int i = 0; i < M; i++)
+            if (tri_class[i] == SPECIAL)
+            {
+                int k = scratch.pos_offsets[i];
+                specials[k] = i;
+                tri_class[i] = k;
+                const vec3i &t = triangles[i];
+                // the plane crosses the edges of triangles with vertices strictly on both sides
+                if (max(max(side[t[0]], side[t[1]]), side[t[2]]) == 1 && min(min(side[t[0]], side[t[1]]), side[t[2]]) == -1)
+                    CutTriangle(plane, points[t[0]], points[t[1]], points[t[2]], scratch.cuts[k]);
             }
+
+        // border points and edges depend on the order the triangles are met in
+        scratch.special_pos_tris.clear();
+        scratch.special_neg_tris.clear();
+        scratch.special_pos.resize(n_specials + 1);
+        scratch.special_neg.resize(n_specials + 1);
+        for (int k = 0; k < n_specials; k++)
+        {
+            scratch.special_pos[k] = (int)scratch.special_pos_tris.size();
+            scratch.special_neg[k] = (int)scratch.special_neg_tris.size();
+            const vec3i &t = triangles[specials[k]];
+            ClipTriangle(mesh, plane, specials[k], side[t[0]], side[t[1]], side[t[2]], &scratch.cuts[k], scratch,
+                         scratch.special_pos_tris, scratch.special_neg_tris);
         }
+        scratch.special_pos[n_specials] = (int)scratch.special_pos_tris.size();
+        scratch.special_neg[n_specials] = (int)scratch.special_neg_tris.size();
+
+        // compact both sides in mesh order
+        auto pos_count = [&](int i)
+        { return tri_class[i] == PURE_POS ? 1 : tri_class[i] >= 0 ? scratch.special_pos[tri_class[i] + 1] - scratch.special_pos[tri_class[i]] : 0; };
+        auto neg_count = [&](int i)
+        { return tri_class[i] == PURE_NEG ? 1 : tri_class[i] >= 0 ? scratch.special_neg[tri_class[i] + 1] - scratch.special_neg[tri_class[i]] : 0; };
+        const int pos_base = (int)pos_tris.size(), neg_base = (int)neg_tris.size();
+        pos_tris.resize(pos_base + PrefixSum(M, pos_count, scratch.pos_offsets, true));
+        neg_tris.resize(neg_base + PrefixSum(M, neg_count, scratch.neg_offsets, true));
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (int i = 0; i < M; i++)
+        {
+            int k = tri_class[i];
+            if (k == PURE_POS)
+                pos_tris[pos_base + scratch.pos_offsets[i]] = triangles[i];
+            else if (k == PURE_NEG)
+                neg_tris[neg_base + scratch.neg_offsets[i]] = triangles[i];
+            else
+            {
+                std::copy(scratch.special_pos_tris.begin() + scratch.special_pos[k], scratch.special_pos_tris.begin() + scratch.special_pos[k + 1],
+                          pos_tris.begin() + pos_base + scratch.pos_offsets[i]);
+                std::copy(scratch.special_neg_tris.begin() + scratch.special_neg[k], scratch.special_neg_tris.begin() + scratch.special_neg[k + 1],
+                          neg_tris.begin() + neg_base + scratch.neg_offsets[i]);
+            }
+        }
+    }
+
+    static bool UseParallelClip(const Model &mesh)
+    {
+#ifdef _OPENMP
+        // the staged pass only pays off when its loops get several threads, which they do not inside an
+        // already active parallel region unless nesting is enabled
+        return (int)mesh.triangles.size() >= PARALLEL_CLIP_CUTOFF && omp_get_max_threads() > 1 &&
+               omp_get_active_level() < omp_get_max_active_levels();
+#else
+        return false;
+#endif
+    }
+
+    static void ResetClip(ClipScratch &scratch, int N)
+    {
+        scratch.pos_map.assign(N, 0);
+        scratch.neg_map.assign(N, 0);
+        scratch.edge_map.Clear();
+        scratch.vertex_map.assign(N, -1);
+        scratch.welder.Clear();
+        scratch.border.clear();
+        scratch.overlap.clear();
+        scratch.border_edges.clear();
+        scratch.idx = 0;
+    }
+
+    // Triangulates the cap from the recorded border and assembles both parts from the sorted triangles
+    static bool FinishClip(const Model &mesh, Model &pos, Model &neg, Plane &plane, double &cut_area, ClipScratch &scratch, bool parallel)
+    {
+        ArenaScope temps;
+        ScratchVector<vec3i> border_triangles(temps.resource()), final_triangles(temps.resource());
+        ScratchVector<int> border_map(temps.resource());
+        ScratchVector<vec3d> kept_border(temps.resource());
+        std::span<const vec3d> final_border; // the cap's points: the border, or what RemoveOutlierTriangles kept of it
+
+        const int N = (int)mesh.points.size();
+        vector<char> &pos_map = scratch.pos_map, &neg_map = scratch.neg_map;
+        vector<vec3d> &border = scratch.border, &overlap = scratch.overlap;
+        vector<pair<int, int>> &border_edges = scratch.border_edges;
 
         if (border.size() > 2)
         {
             int oriN = (int)border.size();
-            short flag = Triangulation(border, border_edges, border_triangles, plane);
-            if (flag == 0)
-                RemoveOutlierTriangles(border, overlap, border_edges, border_triangles, oriN, border_map, final_border, final_triangles);
-            else if (flag == 1)
-                final_border = border; // remember to fill final_border with border!
+            if (overlap.empty() && SimpleCapTriangulation(border, border_edges, plane, final_triangles))
+            {
+                final_border = border;
+                border_map.resize(border.size() + 1);
+                std::iota(border_map.begin(), border_map.end(), 0);
+            }
             else
-                return false; // clip failed
+            {
+                short flag = Triangulation(border, border_edges, border_triangles, plane);
+                if (flag == 0)
+                {
+                    RemoveOutlierTriangles(border, overlap, border_edges, border_triangles, oriN, border_map, kept_border, final_triangles);
+                    final_border = kept_border;
+                    cap_cdt_count.fetch_add(1, std::memory_order_relaxed);
+                }
+                else if (flag == 1)
+                    final_border = border; // remember to fill final_border with border!
+                else
+                    return false; // clip failed
+            }
 
             cut_area = 0;
         }
@@ -806,15 +1398,19 @@ namespace coacd
         double pos_x_min = INF, pos_x_max = -INF, pos_y_min = INF, pos_y_max = -INF, pos_z_min = INF, pos_z_max = -INF;
         double neg_x_min = INF, neg_x_max = -INF, neg_y_min = INF, neg_y_max = -INF, neg_z_min = INF, neg_z_max = -INF;
 
-        int pos_idx = 0, neg_idx = 0;
-        int *pos_proj = new int[N]();
-        int *neg_proj = new int[N]();
+        // pos_proj/neg_proj: index of each kept vertex in its part
+        vector<int> &pos_proj = scratch.pos_proj, &neg_proj = scratch.neg_proj;
+        pos.points.resize(PrefixSum(N, [&](int i) { return (int)pos_map[i]; }, pos_proj, parallel));
+        neg.points.resize(PrefixSum(N, [&](int i) { return (int)neg_map[i]; }, neg_proj, parallel));
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if (parallel) reduction(min : pos_x_min, pos_y_min, pos_z_min, neg_x_min, neg_y_min, neg_z_min) \
+    reduction(max : pos_x_max, pos_y_max, pos_z_max, neg_x_max, neg_y_max, neg_z_max)
+#endif
         for (int i = 0; i < N; i++)
         {
             if (pos_map[i] == true)
             {
-                pos.points.push_back(mesh.points[i]);
-                pos_proj[i] = ++pos_idx; // 0 means not exist, so all plus 1
+                pos.points[pos_proj[i]] = mesh.points[i];
 
                 pos_x_min = min(pos_x_min, mesh.points[i][0]);
                 pos_x_max = max(pos_x_max, mesh.points[i][0]);
@@ -825,8 +1421,7 @@ namespace coacd
             }
             if (neg_map[i] == true)
             {
-                neg.points.push_back(mesh.points[i]);
-                neg_proj[i] = ++neg_idx;
+                neg.points[neg_proj[i]] = mesh.points[i];
 
                 neg_x_min = min(neg_x_min, mesh.points[i][0]);
                 neg_x_max = max(neg_x_max, mesh.points[i][0]);
@@ -874,37 +1469,43 @@ namespace coacd
         neg.bbox[5] = neg_z_max;
 
         // triangles
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if (parallel)
+#endif
         for (int i = 0; i < (int)pos.triangles.size(); i++)
         {
             int f0, f1, f2;
             if (pos.triangles[i][0] >= 0)
-                f0 = pos_proj[pos.triangles[i][0]] - 1;
+                f0 = pos_proj[pos.triangles[i][0]];
             else
                 f0 = -1 * pos.triangles[i][0] + pos_N - 1;
             if (pos.triangles[i][1] >= 0)
-                f1 = pos_proj[pos.triangles[i][1]] - 1;
+                f1 = pos_proj[pos.triangles[i][1]];
             else
                 f1 = -1 * pos.triangles[i][1] + pos_N - 1;
             if (pos.triangles[i][2] >= 0)
-                f2 = pos_proj[pos.triangles[i][2]] - 1;
+                f2 = pos_proj[pos.triangles[i][2]];
             else
                 f2 = -1 * pos.triangles[i][2] + pos_N - 1;
 
             pos.triangles[i] = {f0, f1, f2};
         }
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if (parallel)
+#endif
         for (int i = 0; i < (int)neg.triangles.size(); i++)
         {
             int f0, f1, f2;
             if (neg.triangles[i][0] >= 0)
-                f0 = neg_proj[neg.triangles[i][0]] - 1;
+                f0 = neg_proj[neg.triangles[i][0]];
             else
                 f0 = -1 * neg.triangles[i][0] + neg_N - 1;
             if (neg.triangles[i][1] >= 0)
-                f1 = neg_proj[neg.triangles[i][1]] - 1;
+                f1 = neg_proj[neg.triangles[i][1]];
             else
                 f1 = -1 * neg.triangles[i][1] + neg_N - 1;
             if (neg.triangles[i][2] >= 0)
-                f2 = neg_proj[neg.triangles[i][2]] - 1;
+                f2 = neg_proj[neg.triangles[i][2]];
             else
                 f2 = -1 * neg.triangles[i][2] + neg_N - 1;
 
@@ -921,11 +1522,194 @@ namespace coacd
                                      neg_N + border_map[final_triangles[i][1]] - 1,
                                      neg_N + border_map[final_triangles[i][0]] - 1});
         }
-        delete[] pos_proj;
-        delete[] neg_proj;
-        delete[] neg_map;
-        delete[] pos_map;
+        pos.Invalidate();
+        neg.Invalidate();
+        return true;
+    }
+
+    bool Clip(const Model &mesh, Model &pos, Model &neg, Plane &plane, double &cut_area, bool foo)
+    {
+        ClipScratch &scratch = clip_scratch;
+        const bool parallel = UseParallelClip(mesh);
+        ResetClip(scratch, (int)mesh.points.size());
+
+        if (parallel)
+            ClipTrianglesParallel(mesh, plane, scratch, pos.triangles, neg.triangles);
+        else
+            for (int i = 0; i < (int)mesh.triangles.size(); i++)
+            {
+                const vec3i &t = mesh.triangles[i];
+                ClipTriangle(mesh, plane, i, plane.Side(mesh.points[t[0]]), plane.Side(mesh.points[t[1]]), plane.Side(mesh.points[t[2]]), nullptr,
+                             scratch, pos.triangles, neg.triangles);
+            }
+
+        return FinishClip(mesh, pos, neg, plane, cut_area, scratch, parallel);
+    }
+
+    bool ClipSlabs(const Model &mesh, vector<Plane> &planes, const std::function<void(int, Model &, Model &, double, bool)> &visit)
+    {
+        if (planes.empty())
+            return true;
+        const double a = planes[0].a, b = planes[0].b, c = planes[0].c, eps = 1e-6;
+        for (Plane &plane : planes)
+            if (plane.a != a || plane.b != b || plane.c != c)
+                return false;
+
+        const int N = (int)mesh.points.size(), M = (int)mesh.triangles.size();
+        ClipScratch &scratch = clip_scratch;
+        if (planes.size() == 1 || UseParallelClip(mesh))
+        {
+            // a lone plane gains nothing from the shared pass, and large meshes have the data-parallel one
+            for (int k = 0; k < (int)planes.size(); k++)
+            {
+                Model pos, neg;
+                double cut_area = 0;
+                bool flag = Clip(mesh, pos, neg, planes[k], cut_area);
+                visit(k, pos, neg, cut_area, flag);
+            }
+            return true;
+        }
+
+        // Planes by falling d. Each triangle is first wholly on the pos side, then cut, then wholly on the neg side, so
+        // the planes that cut it are one run of this order, found by two binary searches over its span.
+        ArenaScope temps;
+        const int K = (int)planes.size();
+        ScratchVector<int> order(K, temps.resource());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](int x, int y) { return planes[x].d > planes[y].d; });
 
+        // distance term of every vertex, summed as Plane::Side sums it so adding d gives the same sides
+        ScratchVector<double> base(N, temps.resource());
+        for (int i = 0; i < N; i++)
+            base[i] = mesh.points[i][0] * a + mesh.points[i][1] * b + mesh.points[i][2] * c;
+
+        // triangle i is on the pos side of sorted planes [0, lo[i]), cut by [lo[i], hi[i]) and on the neg side of the rest
+        ScratchVector<int> lo(M, temps.resource()), hi(M, temps.resource());
+        ScratchVector<int> cut_start(K + 1, 0, temps.resource()), lo_start(K + 2, 0, temps.resource()), hi_start(K + 2, 0, temps.resource());
+        for (int i = 0; i < M; i++)
+        {
+            const vec3i &t = mesh.triangles[i];
+            const double tmin = min(min(base[t[0]], base[t[1]]), base[t[2]]);
+            const double tmax = max(max(base[t[0]], base[t[1]]), base[t[2]]);
+            lo[i] = (int)(std::partition_point(order.begin(), order.end(), [&](int k) { return tmin + planes[k].d > eps; }) - order.begin());
+            hi[i] = (int)(std::partition_point(order.begin() + lo[i], order.end(), [&](int k) { return !(tmax + planes[k].d < -1 * eps); }) - order.begin());
+            for (int j = lo[i]; j < hi[i]; j++)
+                cut_start[j + 1]++;
+            lo_start[lo[i] + 1]++;
+            hi_start[hi[i] + 1]++;
+        }
+        for (int j = 0; j < K; j++)
+            cut_start[j + 1] += cut_start[j];
+        for (int j = 0; j <= K; j++)
+        {
+            lo_start[j + 1] += lo_start[j];
+            hi_start[j + 1] += hi_start[j];
+        }
+
+        // the triangles each plane cuts, and the triangles whose lo and hi are j, all in index order
+        ScratchVector<int> cut_tris(cut_start[K], temps.resource()), by_lo(M, temps.resource()), by_hi(M, temps.resource());
+        {
+            ScratchVector<int> cut_fill(cut_start.begin(), cut_start.end() - 1, temps.resource());
+            ScratchVector<int> lo_fill(lo_start.begin(), lo_start.end() - 1, temps.resource()), hi_fill(hi_start.begin(), hi_start.end() - 1, temps.resource());
+            for (int i = 0; i < M; i++)
+            {
+                for (int j = lo[i]; j < hi[i]; j++)
+                    cut_tris[cut_fill[j]++] = i;
+                by_lo[lo_fill[lo[i]]++] = i;
+                by_hi[hi_fill[hi[i]]++] = i;
+            }
+        }
+
+        // Doubly linked lists in index order, M is the head: the triangles wholly on the pos side of the current plane,
+        // which only lose members as d falls, and those wholly on its neg side, which only gain them. The neg list is
+        // built for the last plane and emptied down to the first one; restoring the unlinked nodes in reverse order
+        // then grows it back plane by plane.
+        ScratchVector<int> pos_next(M + 1, temps.resource()), pos_prev(M + 1, temps.resource());
+        ScratchVector<int> neg_next(M + 1, temps.resource()), neg_prev(M + 1, temps.resource());
+        int pos_tail = M, neg_tail = M;
+        for (int i = 0; i < M; i++)
+        {
+            if (lo[i] > 0)
+            {
+                pos_next[pos_tail] = i;
+                pos_prev[i] = pos_tail;
+                pos_tail = i;
+            }
+            if (hi[i] < K)
+            {
+                neg_next[neg_tail] = i;
+                neg_prev[i] = neg_tail;
+                neg_tail = i;
+            }
+        }
+        pos_next[pos_tail] = M;
+        pos_prev[M] = pos_tail;
+        neg_next[neg_tail] = M;
+        neg_prev[M] = neg_tail;
+        auto unlink = [](ScratchVector<int> &next, ScratchVector<int> &prev, int i)
+        {
+            next[prev[i]] = next[i];
+            prev[next[i]] = prev[i];
+        };
+        auto relink = [](ScratchVector<int> &next, ScratchVector<int> &prev, int i)
+        {
+            next[prev[i]] = i;
+            prev[next[i]] = i;
+        };
+        for (int j = K - 1; j > 0; j--)
+            for (int x = hi_start[j]; x < hi_start[j + 1]; x++)
+                unlink(neg_next, neg_prev, by_hi[x]);
+
+        auto side = [&](int v, double d) -> short
+        {
+            double res = base[v] + d;
+            return res > eps ? 1 : res < -1 * eps ? -1 : 0;
+        };
+        for (int j = 0; j < K; j++)
+        {
+            if (j > 0)
+            {
+                for (int x = lo_start[j]; x < lo_start[j + 1]; x++)
+                    unlink(pos_next, pos_prev, by_lo[x]);
+                for (int x = hi_start[j + 1] - 1; x >= hi_start[j]; x--)
+                    relink(neg_next, neg_prev, by_hi[x]);
+            }
+
+            const int k = order[j];
+            Plane &plane = planes[k];
+            const double d = plane.d;
+            Model pos, neg;
+            double cut_area = 0;
+            ResetClip(scratch, N);
+
+            // merge the uncut triangles with the cut ones by index, the order Clip sorts them in
+            int p = pos_next[M], q = neg_next[M];
+            auto take_uncut = [&](int end)
+            {
+                for (; p < end; p = pos_next[p])
+                {
+                    const vec3i &t = mesh.triangles[p];
+                    scratch.pos_map[t[0]] = scratch.pos_map[t[1]] = scratch.pos_map[t[2]] = 1;
+                    pos.triangles.push_back(t);
+                }
+                for (; q < end; q = neg_next[q])
+                {
+                    const vec3i &t = mesh.triangles[q];
+                    scratch.neg_map[t[0]] = scratch.neg_map[t[1]] = scratch.neg_map[t[2]] = 1;
+                    neg.triangles.push_back(t);
+                }
+            };
+            for (int x = cut_start[j]; x < cut_start[j + 1]; x++)
+            {
+                const int i = cut_tris[x];
+                const vec3i &t = mesh.triangles[i];
+                take_uncut(i);
+                ClipTriangle(mesh, plane, i, side(t[0], d), side(t[1], d), side(t[2], d), nullptr, scratch, pos.triangles, neg.triangles);
+            }
+            take_uncut(M);
+            bool flag = FinishClip(mesh, pos, neg, plane, cut_area, scratch, false);
+            visit(k, pos, neg, cut_area, flag);
+        }
         return true;
     }
 }
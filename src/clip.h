@@ -1,7 +1,10 @@
 #pragma once
 
 #include "model_obj.h"
+#include "arena.h"
+#include <cstdint>
 #include <deque>
+#include <functional>
 
 using std::deque;
 using std::endl;
@@ -10,30 +13,180 @@ namespace coacd
 {
     void SimpleCyclesFromEdges(const vector<pair<int, int>> edges, vector<vector<int>> &simple_cycles);
     void FindCycleDirection(vector<vec3d> border, vector<vector<int>> cycles, Plane plane, map<pair<int, int>, bool> &cycles_dir);
-    void RemoveOutlierTriangles(vector<vec3d> border, vector<vec3d> overlap, vector<pair<int, int>> border_edges, int oriN,
-                                vector<vec3i> border_triangles, vector<vec3i> &final_triangles);
-    void RecordIntersectPoint(Model mesh, map<pair<int, int>, int> &edge_map, int i, int ep0, int ep1, int &idx, vector<vec3d> &border, vec3d point);
+    void RemoveOutlierTriangles(const vector<vec3d> &border, const vector<vec3d> &overlap, const vector<pair<int, int>> &border_edges,
+                                const ScratchVector<vec3i> &border_triangles, int oriN, ScratchVector<int> &vertex_map, ScratchVector<vec3d> &final_border,
+                                ScratchVector<vec3i> &final_triangles);
     bool Clip(const Model &mesh, Model &pos, Model &neg, Plane &plane, double &cut_area, bool foo = false);
-    bool CreatePlaneRotationMatrix(vector<vec3d> &border, vector<pair<int, int>> border_edges, vec3d &T, double R[3][3], Plane &plane);
-    short Triangulation(vector<vec3d> &border, vector<pair<int, int>> border_edges, vector<vec3i> &border_triangles, Plane &plane);
+    // Clips mesh by every plane of a family sharing one normal (a, b, c), sweeping the planes by offset. Each
+    // triangle's span along the normal is read once, and each plane only visits the triangles it cuts; the ones it
+    // leaves whole are carried over from the previous plane. visit(k, pos, neg, cut_area, ok) receives the result
+    // for planes[k], in offset order, exactly as Clip(mesh, pos, neg, planes[k], cut_area) would return it.
+    // Returns false if the normals differ.
+    bool ClipSlabs(const Model &mesh, vector<Plane> &planes, const std::function<void(int, Model &, Model &, double, bool)> &visit);
+    bool CreatePlaneRotationMatrix(vector<vec3d> &border, const vector<pair<int, int>> &border_edges, vec3d &T, double R[3][3], Plane &plane);
+    // Constrained Delaunay triangulation of the cap; its temporaries come from border_triangles' memory resource
+    short Triangulation(vector<vec3d> &border, const vector<pair<int, int>> &border_edges, ScratchVector<vec3i> &border_triangles, Plane &plane);
+
+    // Number of cut caps triangulated by each tier since the last ResetCapStats(): a fan for convex loops,
+    // ear clipping for simple loops with a few holes, and constrained Delaunay for everything else
+    struct CapStats
+    {
+        size_t fan = 0, ear = 0, cdt = 0;
+    };
+    CapStats GetCapStats();
+    void ResetCapStats();
     void PrintEdgeSet(vector<pair<int, int>> edges);
 
-    inline void addPoint(map<int, int> &vertex_map, vector<vec3d> &border, vec3d pt, int id, int &idx)
+    // Open-addressing hash map from 64-bit keys to ints; Clear() keeps the storage for the next call
+    struct FlatIndexMap
     {
-        if (vertex_map.find(id) == vertex_map.end())
+        static constexpr uint64_t EMPTY = ~0ull;
+        vector<uint64_t> keys;
+        vector<int> values;
+        size_t count = 0;
+
+        void Clear()
         {
-            int flag = -1;
-            for (int i = 0; i < (int)border.size(); i++)
+            // shrink back after an unusually large cut so clearing stays proportional to typical use
+            size_t capacity = keys.size();
+            if (capacity < 64 || (capacity > 64 && count * 8 < capacity))
+            {
+                capacity = 64;
+                while (capacity < count * 4)
+                    capacity <<= 1;
+                keys.assign(capacity, EMPTY);
+                values.assign(capacity, 0);
+            }
+            else
+                std::fill(keys.begin(), keys.end(), EMPTY);
+            count = 0;
+        }
+
+        static size_t Slot(uint64_t key)
+        {
+            key ^= key >> 33;
+            key *= 0xff51afd7ed558ccdull;
+            key ^= key >> 33;
+            return (size_t)key;
+        }
+
+        const int *Find(uint64_t key) const
+        {
+            const size_t mask = keys.size() - 1;
+            for (size_t i = Slot(key) & mask;; i = (i + 1) & mask)
             {
-                if ((fabs(border[i][0] - pt[0])) < 1e-4 && (fabs(border[i][1] - pt[1])) < 1e-4 && (fabs(border[i][2] - pt[2])) < 1e-4)
+                if (keys[i] == key)
+                    return &values[i];
+                if (keys[i] == EMPTY)
+                    return nullptr;
+            }
+        }
+
+        // value stored under key, inserting init first if the key is absent
+        int &Value(uint64_t key, int init)
+        {
+            if ((count + 1) * 2 > keys.size())
+                Grow();
+            const size_t mask = keys.size() - 1;
+            size_t i = Slot(key) & mask;
+            while (keys[i] != key && keys[i] != EMPTY)
+                i = (i + 1) & mask;
+            if (keys[i] == EMPTY)
+            {
+                keys[i] = key;
+                values[i] = init;
+                count++;
+            }
+            return values[i];
+        }
+
+        void Grow()
+        {
+            vector<uint64_t> old_keys(keys.size() * 2, EMPTY);
+            vector<int> old_values(keys.size() * 2, 0);
+            old_keys.swap(keys);
+            old_values.swap(values);
+            const size_t mask = keys.size() - 1;
+            for (size_t j = 0; j < old_keys.size(); j++)
+                if (old_keys[j] != EMPTY)
                 {
-                    flag = i;
-                    break;
+                    size_t i = Slot(old_keys[j]) & mask;
+                    while (keys[i] != EMPTY)
+                        i = (i + 1) & mask;
+                    keys[i] = old_keys[j];
+                    values[i] = old_values[j];
                 }
-            }
+        }
+    };
+
+    // Key of an undirected mesh edge
+    inline uint64_t EdgeKey(int id1, int id2)
+    {
+        if (id1 > id2)
+            std::swap(id1, id2);
+        return ((uint64_t)(uint32_t)id1 << 32) | (uint32_t)id2;
+    }
+
+    // Spatial hash over the border points of one cut. Points closer than 1e-4 on every axis are welded to the
+    // first border point that close, exactly as a linear scan over the border would find it.
+    struct BorderWelder
+    {
+        static constexpr double TOLERANCE = 1e-4;
+        static constexpr double CELL = 2e-4; // twice the tolerance, so rounding never hides a neighbour cell
+        FlatIndexMap cells;                 // cell -> last border point inserted in it
+        vector<int> next;                   // previous border point in the same cell, or -1
+
+        void Clear()
+        {
+            cells.Clear();
+            next.clear();
+        }
+
+        static uint64_t CellKey(int64_t x, int64_t y, int64_t z)
+        {
+            uint64_t h = (uint64_t)x;
+            h = h * 0x9e3779b97f4a7c15ull + (uint64_t)y;
+            h = h * 0x9e3779b97f4a7c15ull + (uint64_t)z;
+            return h == FlatIndexMap::EMPTY ? h - 1 : h; // distinct cells may share a key; candidates are re-checked
+        }
+
+        int Find(const vector<vec3d> &border, const vec3d &pt) const
+        {
+            const int64_t cx = (int64_t)floor(pt[0] / CELL), cy = (int64_t)floor(pt[1] / CELL), cz = (int64_t)floor(pt[2] / CELL);
+            int flag = -1;
+            for (int64_t x = cx - 1; x <= cx + 1; x++)
+                for (int64_t y = cy - 1; y <= cy + 1; y++)
+                    for (int64_t z = cz - 1; z <= cz + 1; z++)
+                    {
+                        const int *head = cells.Find(CellKey(x, y, z));
+                        if (!head)
+                            continue;
+                        for (int i = *head; i != -1; i = next[i])
+                            if ((flag == -1 || i < flag) && (fabs(border[i][0] - pt[0])) < TOLERANCE && (fabs(border[i][1] - pt[1])) < TOLERANCE &&
+                                (fabs(border[i][2] - pt[2])) < TOLERANCE)
+                                flag = i;
+                    }
+            return flag;
+        }
+
+        void Insert(const vec3d &pt, int i)
+        {
+            int &head = cells.Value(CellKey((int64_t)floor(pt[0] / CELL), (int64_t)floor(pt[1] / CELL), (int64_t)floor(pt[2] / CELL)), -1);
+            next.resize(i + 1, -1);
+            next[i] = head;
+            head = i;
+        }
+    };
+
+    inline void addPoint(vector<int> &vertex_map, BorderWelder &welder, vector<vec3d> &border, vec3d pt, int id, int &idx)
+    {
+        if (vertex_map[id] == -1)
+        {
+            int flag = welder.Find(border, pt);
             if (flag == -1)
             {
                 vertex_map[id] = idx;
+                welder.Insert(pt, idx);
                 border.push_back(pt);
                 idx++;
             }
@@ -42,42 +195,26 @@ namespace coacd
         }
     }
 
-    inline void addEdgePoint(map<pair<int, int>, int> &edge_map, vector<vec3d> &border, vec3d pt, int id1, int id2, int &idx)
+    inline void addEdgePoint(FlatIndexMap &edge_map, BorderWelder &welder, vector<vec3d> &border, vec3d pt, int id1, int id2, int &idx)
     {
-        pair<int, int> edge1 = make_pair(id1, id2);
-        pair<int, int> edge2 = make_pair(id2, id1);
-        if (edge_map.find(edge1) == edge_map.end() && edge_map.find(edge2) == edge_map.end())
+        uint64_t edge = EdgeKey(id1, id2);
+        if (!edge_map.Find(edge))
         {
-            int flag = -1;
-            for (int i = 0; i < (int)border.size(); i++)
-            {
-                if ((fabs(border[i][0] - pt[0])) < 1e-4 && (fabs(border[i][1] - pt[1])) < 1e-4 && (fabs(border[i][2] - pt[2])) < 1e-4)
-                {
-                    flag = i;
-                    break;
-                }
-            }
+            int flag = welder.Find(border, pt);
             if (flag == -1)
             {
-                edge_map[edge1] = idx;
-                edge_map[edge2] = idx;
+                edge_map.Value(edge, idx) = idx;
+                welder.Insert(pt, idx);
                 border.push_back(pt);
                 idx++;
             }
             else
-            {
-                edge_map[edge1] = flag;
-                edge_map[edge2] = flag;
-            }
+                edge_map.Value(edge, flag) = flag;
         }
     }
 
-    inline bool FaceOverlap(map<int, bool> overlap_map, vec3i triangle)
+    inline bool FaceOverlap(const vector<char> &overlap_map, vec3i triangle)
     {
-        int idx0 = triangle[0], idx1 = triangle[1], idx2 = triangle[2];
-        if (overlap_map.find(idx0) == overlap_map.end() && overlap_map.find(idx1) == overlap_map.end() &&
-            overlap_map.find(idx2) == overlap_map.end())
-            return false;
-        return true;
+        return overlap_map[triangle[0]] || overlap_map[triangle[1]] || overlap_map[triangle[2]];
     }
 }
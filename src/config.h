@@ -33,13 +33,18 @@ namespace coacd
     int prep_resolution;
     bool pca;
     bool merge;
+    string merge_mode;
     int max_convex_hull;
     double dmc_thres;
     string apx_mode;
     bool decimate;
     int max_ch_vertex;
+    string decimate_mode;
     bool extrude;
     double extrude_margin;
+    string hb_mode;
+    string dist_mode;
+    double sdf_voxel_ratio;
 
     /////////////// MCTS Config ///////////////
     int mcts_iteration;
@@ -59,12 +64,17 @@ namespace coacd
       prep_resolution = 50;
       pca = false;
       merge = true;
+      merge_mode = "all";
       dmc_thres = 0.55;
       apx_mode = "ch";
       decimate = false;
       max_ch_vertex = 256;
+      decimate_mode = "collapse"; // "hull" builds a vertex-budgeted hull instead
       extrude = false;
       extrude_margin = 0.01;
+      hb_mode = "kdtree";
+      dist_mode = "kdtree";
+      sdf_voxel_ratio = 0.1; // SDF voxel = ratio * threshold, Hb error <= sqrt(3)/2 * voxel
 
       mcts_iteration = 150;
       mcts_max_depth = 3;
@@ -1,4 +1,7 @@
 #include "cost.h"
+#if WITH_3RD_PARTY_LIBS
+#include "sdf.h"
+#endif
 #include "hausdorff.h"
 
 namespace coacd
@@ -6,7 +9,7 @@ namespace coacd
 
   constexpr double Pi = 3.14159265;
 
-  double ComputeRv(Model &tmesh1, Model &tmesh2, double k, double epsilon)
+  double ComputeRv(const Model &tmesh1, const Model &tmesh2, double k, double epsilon)
   {
     double v1, v2;
     v1 = MeshVolume(tmesh1);
@@ -17,7 +20,7 @@ namespace coacd
     return d;
   }
 
-  double ComputeRv(Model &cvx1, Model &cvx2, Model &cvxCH, double k, double epsilon)
+  double ComputeRv(const Model &cvx1, const Model &cvx2, const Model &cvxCH, double k, double epsilon)
   {
     double v1, v2, v3;
 
@@ -25,28 +28,31 @@ namespace coacd
     v2 = MeshVolume(cvx2);
     v3 = MeshVolume(cvxCH);
 
-    double d = pow(3 * fabs(v1 + v2 - v3) / (4 * Pi), 1.0 / 3) * k;
+    return ComputeRv(v1, v2, v3, k);
+  }
+
+  // Rv of merging two hulls whose union volume is already known
+  double ComputeRv(double volume1, double volume2, double volumeCH, double k)
+  {
+    double d = pow(3 * fabs(volume1 + volume2 - volumeCH) / (4 * Pi), 1.0 / 3) * k;
 
     return d;
   }
 
-  double ComputeHb(Model &tmesh1, Model &tmesh2, unsigned int resolution, unsigned int seed, bool flag)
+  double ComputeHb(const Model &tmesh1, const Model &tmesh2, unsigned int resolution, unsigned int seed, bool flag)
   {
-    vector<vec3d> samples1, samples2;
-    vector<int> sample_tri_ids1, sample_tri_ids2;
-
-    tmesh1.ExtractPointSet(samples1, sample_tri_ids1, seed, resolution, 1);
-    tmesh2.ExtractPointSet(samples2, sample_tri_ids2, seed, resolution, 1);
+    const SurfaceSamples &samples1 = tmesh1.GetSamples(resolution);
+    const SurfaceSamples &samples2 = tmesh2.GetSamples(resolution);
 
-    if (!((int)samples1.size() > 0 && (int)samples2.size() > 0))
+    if (!((int)samples1.points.size() > 0 && (int)samples2.points.size() > 0))
       return INF;
 
     double h;
-    h = face_hausdorff_distance(tmesh1, samples1, sample_tri_ids1, tmesh2, samples2, sample_tri_ids2);
+    h = face_hausdorff_distance(tmesh1, samples1.points, samples1.cloud, samples1.tri_ids, tmesh2, samples2.points, samples2.cloud, samples2.tri_ids);
 
     return h;
   }
-  double ComputeHb(Model &cvx1, Model &cvx2, Model &cvxCH, unsigned int resolution, unsigned int seed)
+  double ComputeHb(const Model &cvx1, const Model &cvx2, const Model &cvxCH, unsigned int resolution, unsigned int seed)
   {
     if (cvx1.points.size() + cvx2.points.size() == cvxCH.points.size())
       return 0.0;
@@ -65,7 +71,63 @@ namespace coacd
     return h;
   }
 
-  double ComputeTotalRv(Model &mesh, Model &volume1, Model &volumeCH1, Model &volume2, Model &volumeCH2, double k, Plane &plane, double epsilon)
+#if WITH_3RD_PARTY_LIBS
+  // The part's field, cached on it: voxels of sdf_voxel_ratio * threshold, and a band of 2 * threshold whose clamping
+  // never changes a threshold decision
+  static const DistanceField &PartField(const Model &part, Params &params)
+  {
+    return part.GetDistanceField(params.threshold * params.sdf_voxel_ratio, 2 * params.threshold);
+  }
+
+  // Hb of the mesh the field was built for and its convex hull. Hull samples are looked up in the field; mesh samples
+  // lie inside the convex hull, so their exact distance is to the nearest hull face plane.
+  static double SDFHausdorff(const DistanceField &field, const vector<vec3d> &mesh_samples, const Model &hull, const vector<vec3d> &hull_samples)
+  {
+    double cmax = 0;
+    for (const vec3d &p : hull_samples)
+      cmax = max(cmax, field.Distance(p));
+
+    vector<array<double, 4>> planes;
+    for (int i = 0; i < (int)hull.triangles.size(); i++)
+    {
+      vec3d p0 = hull.points[hull.triangles[i][0]], p1 = hull.points[hull.triangles[i][1]], p2 = hull.points[hull.triangles[i][2]];
+      vec3d n = CrossProduct({p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]}, {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]});
+      double len = pt_norm(n);
+      if (len < 1e-12)
+        continue;
+      planes.push_back({n[0] / len, n[1] / len, n[2] / len, -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]) / len});
+    }
+    if (planes.empty())
+      return cmax;
+
+    for (const vec3d &p : mesh_samples)
+    {
+      double cmin = INF;
+      for (const array<double, 4> &f : planes)
+        cmin = min(cmin, fabs(f[0] * p[0] + f[1] * p[1] + f[2] * p[2] + f[3]));
+      cmax = max(cmax, cmin);
+    }
+
+    return cmax;
+  }
+#endif
+
+  double ComputeHbSDF(const Model &tmesh1, const Model &tmesh2, Params &params)
+  {
+#if WITH_3RD_PARTY_LIBS
+    const SurfaceSamples &samples1 = tmesh1.GetSamples(params.resolution);
+    const SurfaceSamples &samples2 = tmesh2.GetSamples(params.resolution);
+
+    if (!((int)samples1.points.size() > 0 && (int)samples2.points.size() > 0))
+      return INF;
+
+    return SDFHausdorff(PartField(tmesh1, params), samples1.points, tmesh2, samples2.points);
+#else
+    return ComputeHb(tmesh1, tmesh2, params.resolution, params.seed);
+#endif
+  }
+
+  double ComputeTotalRv(const Model &mesh, const Model &volume1, const Model &volumeCH1, const Model &volume2, const Model &volumeCH2, double k, Plane &plane, double epsilon)
   {
     double h_pos = ComputeRv(volume1, volumeCH1, k, epsilon);
     double h_neg = ComputeRv(volume2, volumeCH2, k, epsilon);
@@ -73,7 +135,7 @@ namespace coacd
     return max(h_pos, h_neg);
   }
 
-  double ComputeHCost(Model &tmesh1, Model &tmesh2, double k, unsigned int resolution, unsigned int seed, double epsilon, bool flag)
+  double ComputeHCost(const Model &tmesh1, const Model &tmesh2, double k, unsigned int resolution, unsigned int seed, double epsilon, bool flag)
   {
     double h1 = ComputeRv(tmesh1, tmesh2, k, epsilon);
     double h2 = ComputeHb(tmesh1, tmesh2, resolution, seed, flag);
@@ -81,7 +143,18 @@ namespace coacd
     return max(h1, h2);
   }
 
-  double ComputeHCost(Model &cvx1, Model &cvx2, Model &cvxCH, double k, unsigned int resolution, unsigned int seed, double epsilon)
+  double ComputeHCost(const Model &tmesh1, const Model &tmesh2, Params &params)
+  {
+    if (params.hb_mode != "sdf")
+      return ComputeHCost(tmesh1, tmesh2, params.rv_k, params.resolution, params.seed, 0.0001, false);
+
+    double h1 = ComputeRv(tmesh1, tmesh2, params.rv_k);
+    double h2 = ComputeHbSDF(tmesh1, tmesh2, params);
+
+    return max(h1, h2);
+  }
+
+  double ComputeHCost(const Model &cvx1, const Model &cvx2, const Model &cvxCH, double k, unsigned int resolution, unsigned int seed, double epsilon)
   {
     double h1 = ComputeRv(cvx1, cvx2, cvxCH, k, epsilon);
     double h2 = ComputeHb(cvx1, cvx2, cvxCH, resolution + 2000, seed);
@@ -89,44 +162,42 @@ namespace coacd
     return max(h1, h2);
   }
 
-  double ComputeEnergy(Model &mesh, Model &pos, Model &posCH, Model &neg, Model &negCH, double k, double cut_area, unsigned int resolution, unsigned int seed, double epsilon)
+  double ComputeHCost(const Model &cvx1, const Model &cvx2, const Model &cvxCH, double volumeCH, Params &params)
+  {
+    double h1 = ComputeRv(MeshVolume(cvx1), MeshVolume(cvx2), volumeCH, params.rv_k);
+    double h2 = ComputeHb(cvx1, cvx2, cvxCH, params.resolution + 2000, params.seed);
+
+    return max(h1, h2);
+  }
+
+  double ComputeEnergy(const Model &mesh, const Model &pos, const Model &posCH, const Model &neg, const Model &negCH, double k, double cut_area, unsigned int resolution, unsigned int seed, double epsilon)
   {
     double h_pos = ComputeHCost(pos, posCH, k, resolution, seed, epsilon);
     double h_neg = ComputeHCost(neg, negCH, k, resolution, seed, epsilon);
     return max(h_pos, h_neg);
   }
 
-  double MeshDist(Model &ch1, Model &ch2)
+  double MeshDist(const Model &ch1, const Model &ch2)
   {
-    vector<vec3d> XA = ch1.points, XB = ch2.points;
+    const vector<vec3d> &XA = ch1.points, &XB = ch2.points;
+    const PointsSoA &cloudA = ch1.GetPointCloud();
 
     int nA = XA.size();
 
-    PointCloud<double> cloudB;
-    vec2PointCloud(cloudB, XB);
-
-    typedef KDTreeSingleIndexAdaptor<
-        L2_Simple_Adaptor<double, PointCloud<double>>,
-        PointCloud<double>,
-        3 /* dim */
-        >
-        my_kd_tree_t;
-
-    my_kd_tree_t indexB(3 /*dim*/, cloudB, KDTreeSingleIndexAdaptorParams(10 /* max leaf */));
+    PointsKDTree indexB(3 /*dim*/, ch2.GetPointCloud(), KDTreeSingleIndexAdaptorParams(10 /* max leaf */));
     indexB.buildIndex();
 
     double minDist = INF;
     for (int i = 0; i < nA; i++)
     {
-      size_t num_results = 1;
-
-      double query_pt[3] = {XA[i][0], XA[i][1], XA[i][2]};
-
-      std::vector<size_t> ret_index(num_results);
-      std::vector<double> out_dist_sqr(num_results);
-
-      num_results = indexB.knnSearch(&query_pt[0], num_results, &ret_index[0], &out_dist_sqr[0]);
-      double dist = sqrt(out_dist_sqr[0]);
+      const float query_pt[3] = {cloudA.x[i], cloudA.y[i], cloudA.z[i]};
+      size_t ret_index;
+      float out_dist_sqr;
+      if (indexB.knnSearch(&query_pt[0], 1, &ret_index, &out_dist_sqr) == 0)
+        continue;
+      // the nearest vertex comes from the float tree, its distance from the double points
+      const vec3d &p = XA[i], &q = XB[ret_index];
+      double dist = sqrt(pow(p[0] - q[0], 2) + pow(p[1] - q[1], 2) + pow(p[2] - q[2], 2));
       minDist = min(minDist, dist);
     }
 
@@ -14,13 +14,17 @@
 
 namespace coacd
 {
-    double ComputeRv(Model &tmesh1, Model &tmesh2, double k, double epsilon = 0.0001);
-    double ComputeRv(Model &cvx1, Model &cvx2, Model &cvxCH, double k, double epsilon = 0.0001);
-    double ComputeHb(Model &tmesh1, Model &tmesh2, unsigned int resolution, unsigned int seed, bool flag = false);
-    double ComputeHb(Model &cvx1, Model &cvx2, Model &cvxCH, unsigned int resolution, unsigned int seed);
-    double ComputeTotalRv(Model &mesh, Model &volume1, Model &volumeCH1, Model &volume2, Model &volumeCH2, double k, Plane &plane, double epsilon = 0.0001);
-    double ComputeHCost(Model &tmesh1, Model &tmesh2, double k, unsigned int resolution, unsigned int seed = 1235, double epsilon = 0.0001, bool flag = false);
-    double ComputeHCost(Model &cvx1, Model &cvx2, Model &cvxCH, double k, unsigned int resolution, unsigned int seed = 1235, double epsilon = 0.0001);
-    double ComputeEnergy(Model &mesh, Model &pos, Model &posCH, Model &neg, Model &negCH, double k, double cut_area, unsigned int resolution, unsigned int seed, double epsilon = 0.0001);
-    double MeshDist(Model &ch1, Model &ch2);
+    double ComputeRv(const Model &tmesh1, const Model &tmesh2, double k, double epsilon = 0.0001);
+    double ComputeRv(const Model &cvx1, const Model &cvx2, const Model &cvxCH, double k, double epsilon = 0.0001);
+    double ComputeRv(double volume1, double volume2, double volumeCH, double k);
+    double ComputeHb(const Model &tmesh1, const Model &tmesh2, unsigned int resolution, unsigned int seed, bool flag = false);
+    double ComputeHb(const Model &cvx1, const Model &cvx2, const Model &cvxCH, unsigned int resolution, unsigned int seed);
+    double ComputeHbSDF(const Model &tmesh1, const Model &tmesh2, Params &params);
+    double ComputeTotalRv(const Model &mesh, const Model &volume1, const Model &volumeCH1, const Model &volume2, const Model &volumeCH2, double k, Plane &plane, double epsilon = 0.0001);
+    double ComputeHCost(const Model &tmesh1, const Model &tmesh2, double k, unsigned int resolution, unsigned int seed = 1235, double epsilon = 0.0001, bool flag = false);
+    double ComputeHCost(const Model &cvx1, const Model &cvx2, const Model &cvxCH, double k, unsigned int resolution, unsigned int seed = 1235, double epsilon = 0.0001);
+    double ComputeHCost(const Model &tmesh1, const Model &tmesh2, Params &params);
+    double ComputeHCost(const Model &cvx1, const Model &cvx2, const Model &cvxCH, double volumeCH, Params &params);
+    double ComputeEnergy(const Model &mesh, const Model &pos, const Model &posCH, const Model &neg, const Model &negCH, double k, double cut_area, unsigned int resolution, unsigned int seed, double epsilon = 0.0001);
+    double MeshDist(const Model &ch1, const Model &ch2);
 }
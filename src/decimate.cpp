@@ -0,0 +1,222 @@
+#include "decimate.h"
+
+#include <algorithm>
+#include <queue>
+
+namespace coacd
+{
+    struct EdgeCollapse
+    {
+        bool conservative; // the placement lies on or outside every face around the edge
+        double cost;       // added volume, or the edge length for a midpoint collapse
+        int a, b;
+
+        // conservative collapses always go first
+        bool operator>(const EdgeCollapse &other) const
+        {
+            if (conservative != other.conservative)
+                return !conservative;
+            return cost > other.cost;
+        }
+    };
+
+    struct CollapseMesh
+    {
+        vector<vec3d> points;
+        vector<vec3i> faces;
+        vector<vector<int>> vertex_faces; // live faces around each vertex
+        vector<char> alive;
+
+        // scratch
+        vector<int> star, na, nb;
+        vector<array<double, 4>> planes; // unit normal and offset of each star face
+    };
+
+    static void Neighbors(const CollapseMesh &m, int a, vector<int> &out)
+    {
+        out.clear();
+        for (int f : m.vertex_faces[a])
+            for (int k = 0; k < 3; k++)
+                if (m.faces[f][k] != a)
+                    out.push_back(m.faces[f][k]);
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    }
+
+    // Link condition: a and b only share the two vertices opposite their edge, so the collapse keeps a 2-manifold
+    static bool CanCollapse(CollapseMesh &m, int a, int b)
+    {
+        Neighbors(m, a, m.na);
+        Neighbors(m, b, m.nb);
+        if (!std::binary_search(m.na.begin(), m.na.end(), b))
+            return false;
+        int common = 0;
+        for (int i = 0, j = 0; i < (int)m.na.size() && j < (int)m.nb.size();)
+        {
+            if (m.na[i] < m.nb[j])
+                i++;
+            else if (m.na[i] > m.nb[j])
+                j++;
+            else
+            {
+                common++;
+                i++;
+                j++;
+            }
+        }
+        return common == 2;
+    }
+
+    // Placement of the merged vertex that adds the least volume while staying on or outside every face plane
+    // around the edge. The added volume is linear in the placement and the constraints are half-spaces, so the
+    // optimum is a vertex of their intersection: a point where three of the planes meet, or one of the endpoints
+    // when the faces are coplanar.
+    static EdgeCollapse Evaluate(CollapseMesh &m, int a, int b, vec3d &v)
+    {
+        m.star.assign(m.vertex_faces[a].begin(), m.vertex_faces[a].end());
+        m.star.insert(m.star.end(), m.vertex_faces[b].begin(), m.vertex_faces[b].end());
+        std::sort(m.star.begin(), m.star.end());
+        m.star.erase(std::unique(m.star.begin(), m.star.end()), m.star.end());
+
+        // added volume = sum over the star faces of area * height / 3 = (g . v - c) / 6
+        vec3d g = {0, 0, 0};
+        double c = 0;
+        m.planes.clear();
+        for (int f : m.star)
+        {
+            const vec3d &p0 = m.points[m.faces[f][0]], &p1 = m.points[m.faces[f][1]], &p2 = m.points[m.faces[f][2]];
+            vec3d n = CrossProduct(vec3d{p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]}, vec3d{p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]});
+            double len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            if (len <= 0)
+                continue;
+            for (int k = 0; k < 3; k++)
+                g[k] += n[k];
+            c += n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2];
+            m.planes.push_back({n[0] / len, n[1] / len, n[2] / len, (n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]) / len});
+        }
+
+        const int np = (int)m.planes.size();
+        bool found = false;
+        double best = INF;
+        auto consider = [&](const vec3d &q)
+        {
+            double cost = max(0.0, (g[0] * q[0] + g[1] * q[1] + g[2] * q[2] - c) / 6);
+            if (cost >= best)
+                return;
+            for (int i = 0; i < np; i++)
+                if (m.planes[i][0] * q[0] + m.planes[i][1] * q[1] + m.planes[i][2] * q[2] - m.planes[i][3] < -1e-9)
+                    return;
+            best = cost;
+            v = q;
+            found = true;
+        };
+
+        const vec3d &pa = m.points[a], &pb = m.points[b];
+        const vec3d mid = {0.5 * (pa[0] + pb[0]), 0.5 * (pa[1] + pb[1]), 0.5 * (pa[2] + pb[2])};
+        consider(pa);
+        consider(pb);
+        consider(mid);
+        for (int i = 0; i < np; i++)
+            for (int j = i + 1; j < np; j++)
+                for (int k = j + 1; k < np; k++)
+                {
+                    const array<double, 4> &p = m.planes[i], &q = m.planes[j], &r = m.planes[k];
+                    // Cramer's rule on the three unit normals
+                    double det = p[0] * (q[1] * r[2] - q[2] * r[1]) - p[1] * (q[0] * r[2] - q[2] * r[0]) + p[2] * (q[0] * r[1] - q[1] * r[0]);
+                    if (fabs(det) < 1e-9)
+                        continue;
+                    vec3d x = {(p[3] * (q[1] * r[2] - q[2] * r[1]) - p[1] * (q[3] * r[2] - q[2] * r[3]) + p[2] * (q[3] * r[1] - q[1] * r[3])) / det,
+                               (p[0] * (q[3] * r[2] - q[2] * r[3]) - p[3] * (q[0] * r[2] - q[2] * r[0]) + p[2] * (q[0] * r[3] - q[3] * r[0])) / det,
+                               (p[0] * (q[1] * r[3] - q[3] * r[1]) - p[1] * (q[0] * r[3] - q[3] * r[0]) + p[3] * (q[0] * r[1] - q[1] * r[0])) / det};
+                    consider(x);
+                }
+
+        if (found)
+            return {true, best, a, b};
+        v = mid;
+        return {false, sqrt(pow(pa[0] - pb[0], 2) + pow(pa[1] - pb[1], 2) + pow(pa[2] - pb[2], 2)), a, b};
+    }
+
+    // b merges into a, which moves to v; the two faces on the edge disappear
+    static void Collapse(CollapseMesh &m, int a, int b, const vec3d &v)
+    {
+        m.points[a] = v;
+        for (int f : m.vertex_faces[b])
+        {
+            vec3i &tri = m.faces[f];
+            if (tri[0] == a || tri[1] == a || tri[2] == a)
+            {
+                for (int k = 0; k < 3; k++)
+                    if (tri[k] != b)
+                    {
+                        vector<int> &around = m.vertex_faces[tri[k]];
+                        around.erase(std::find(around.begin(), around.end(), f));
+                    }
+                continue;
+            }
+            for (int k = 0; k < 3; k++)
+                if (tri[k] == b)
+                    tri[k] = a;
+            m.vertex_faces[a].push_back(f);
+        }
+        m.vertex_faces[b].clear();
+        m.alive[b] = 0;
+    }
+
+    void CollapseHull(const vector<vec3d> &points, const vector<vec3i> &triangles, int tgt_pts, vector<vec3d> &kept)
+    {
+        CollapseMesh m;
+        m.points = points;
+        m.faces = triangles;
+        m.vertex_faces.resize(points.size());
+        m.alive.assign(points.size(), 0);
+        for (int f = 0; f < (int)triangles.size(); f++)
+            for (int k = 0; k < 3; k++)
+            {
+                m.vertex_faces[triangles[f][k]].push_back(f);
+                m.alive[triangles[f][k]] = 1;
+            }
+        int n_alive = 0;
+        for (int i = 0; i < (int)points.size(); i++)
+            n_alive += m.alive[i];
+
+        std::priority_queue<EdgeCollapse, vector<EdgeCollapse>, std::greater<EdgeCollapse>> queue;
+        vec3d v;
+        for (int f = 0; f < (int)triangles.size(); f++)
+            for (int k = 0; k < 3; k++)
+            {
+                int a = triangles[f][k], b = triangles[f][(k + 1) % 3];
+                if (a < b)
+                    queue.push(Evaluate(m, a, b, v));
+            }
+
+        tgt_pts = max(tgt_pts, 4);
+        while (n_alive > tgt_pts && !queue.empty())
+        {
+            EdgeCollapse top = queue.top();
+            queue.pop();
+            if (!m.alive[top.a] || !m.alive[top.b] || !CanCollapse(m, top.a, top.b))
+                continue;
+
+            // costs are only refreshed for the edges of a moved vertex; others are re-evaluated when they surface
+            EdgeCollapse now = Evaluate(m, top.a, top.b, v);
+            if (now > top && (now.conservative != top.conservative || now.cost > top.cost * (1 + 1e-9) + 1e-15))
+            {
+                queue.push(now);
+                continue;
+            }
+
+            Collapse(m, top.a, top.b, v);
+            n_alive--;
+            Neighbors(m, top.a, m.na);
+            vector<int> ring = m.na;
+            for (int n : ring)
+                queue.push(Evaluate(m, top.a, n, v));
+        }
+
+        kept.clear();
+        for (int i = 0; i < (int)m.points.size(); i++)
+            if (m.alive[i])
+                kept.push_back(m.points[i]);
+    }
+}
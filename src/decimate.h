@@ -0,0 +1,14 @@
+#pragma once
+
+#include <vector>
+
+#include "shape.h"
+
+namespace coacd
+{
+    // Edge-collapse simplification of a closed convex hull (counter-clockwise seen from outside) down to
+    // tgt_pts vertices. Every collapse moves the merged vertex to the point on or outside all faces around the
+    // edge that adds the least volume, so the result still encloses the input. Returns the remaining vertex
+    // positions; their convex hull is the simplified hull.
+    void CollapseHull(const vector<vec3d> &points, const vector<vec3i> &triangles, int tgt_pts, vector<vec3d> &kept);
+}
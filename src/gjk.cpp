@@ -0,0 +1,231 @@
+#include "gjk.h"
+
+namespace coacd
+{
+    static inline double Dot(const vec3d &a, const vec3d &b)
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    static inline vec3d Sub(const vec3d &a, const vec3d &b)
+    {
+        return {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+    }
+
+    ConvexSupport::ConvexSupport(Model &ch)
+    {
+        points = ch.points;
+        const int n = (int)points.size();
+        offsets.assign(n + 1, 0);
+        for (int i = 0; i < (int)ch.triangles.size(); i++)
+            for (int j = 0; j < 3; j++)
+            {
+                offsets[ch.triangles[i][j] + 1]++;
+                offsets[ch.triangles[i][(j + 1) % 3] + 1]++;
+            }
+        for (int i = 0; i < n; i++)
+            offsets[i + 1] += offsets[i];
+
+        // both directions of every triangle edge, so open or flat hulls stay connected too
+        vector<int> fill(offsets.begin(), offsets.end() - 1);
+        neighbors.resize(offsets[n]);
+        for (int i = 0; i < (int)ch.triangles.size(); i++)
+            for (int j = 0; j < 3; j++)
+            {
+                int a = ch.triangles[i][j], b = ch.triangles[i][(j + 1) % 3];
+                neighbors[fill[a]++] = b;
+                neighbors[fill[b]++] = a;
+            }
+    }
+
+    int ConvexSupport::Support(const vec3d &dir, int start) const
+    {
+        // a linear function has no local maximum on the vertex graph of a convex polytope other than the global one
+        int best = start;
+        double best_dot = Dot(points[best], dir);
+        bool improved = true;
+        while (improved)
+        {
+            improved = false;
+            for (int k = offsets[best]; k < offsets[best + 1]; k++)
+            {
+                double d = Dot(points[neighbors[k]], dir);
+                if (d > best_dot)
+                {
+                    best_dot = d;
+                    best = neighbors[k];
+                    improved = true;
+                }
+            }
+        }
+        return best;
+    }
+
+    // Point of the affine hull of w[idx[0..n)] closest to the origin, with its barycentric weights.
+    // Returns false if the sub-simplex is degenerate.
+    static bool AffineClosest(const vec3d *w, const int *idx, int n, double *lambda)
+    {
+        if (n == 1)
+        {
+            lambda[0] = 1;
+            return true;
+        }
+        const vec3d &p0 = w[idx[0]];
+        vec3d e[3];
+        for (int i = 1; i < n; i++)
+            e[i - 1] = Sub(w[idx[i]], p0);
+
+        // normal equations M mu = -b for p0 + sum mu_i e_i
+        const int m = n - 1;
+        double M[3][3], b[3], mu[3];
+        for (int i = 0; i < m; i++)
+        {
+            b[i] = -Dot(e[i], p0);
+            for (int j = 0; j < m; j++)
+                M[i][j] = Dot(e[i], e[j]);
+        }
+
+        double scale = 0;
+        for (int i = 0; i < m; i++)
+            scale = max(scale, M[i][i]);
+        if (m == 1)
+        {
+            if (M[0][0] <= 1e-24 * max(scale, 1e-300))
+                return false;
+            mu[0] = b[0] / M[0][0];
+        }
+        else if (m == 2)
+        {
+            double det = M[0][0] * M[1][1] - M[0][1] * M[1][0];
+            if (fabs(det) <= 1e-20 * scale * scale)
+                return false;
+            mu[0] = (b[0] * M[1][1] - M[0][1] * b[1]) / det;
+            mu[1] = (M[0][0] * b[1] - b[0] * M[1][0]) / det;
+        }
+        else
+        {
+            double det = M[0][0] * (M[1][1] * M[2][2] - M[1][2] * M[2][1]) - M[0][1] * (M[1][0] * M[2][2] - M[1][2] * M[2][0]) + M[0][2] * (M[1][0] * M[2][1] - M[1][1] * M[2][0]);
+            if (fabs(det) <= 1e-16 * scale * scale * scale)
+                return false;
+            for (int c = 0; c < 3; c++)
+            {
+                double A[3][3];
+                for (int i = 0; i < 3; i++)
+                    for (int j = 0; j < 3; j++)
+                        A[i][j] = j == c ? b[i] : M[i][j];
+                mu[c] = (A[0][0] * (A[1][1] * A[2][2] - A[1][2] * A[2][1]) - A[0][1] * (A[1][0] * A[2][2] - A[1][2] * A[2][0]) + A[0][2] * (A[1][0] * A[2][1] - A[1][1] * A[2][0])) / det;
+            }
+        }
+
+        lambda[0] = 1;
+        for (int i = 0; i < m; i++)
+        {
+            lambda[i + 1] = mu[i];
+            lambda[0] -= mu[i];
+        }
+        return true;
+    }
+
+    // Reduce the simplex w[0..n) to the face holding the point closest to the origin; returns that point
+    static vec3d ClosestOnSimplex(vec3d *w, vec3d *wa, vec3d *wb, int &n)
+    {
+        // the closest point is the affine projection of the one face whose weights are all positive,
+        // and every such projection lies in the simplex, so the shortest one wins
+        double best_norm = INF;
+        vec3d best_point = w[0];
+        int best_mask = 1;
+        for (int mask = 1; mask < (1 << n); mask++)
+        {
+            int idx[4], k = 0;
+            for (int i = 0; i < n; i++)
+                if (mask & (1 << i))
+                    idx[k++] = i;
+            double lambda[4];
+            if (!AffineClosest(w, idx, k, lambda))
+                continue;
+            bool inside = true;
+            for (int i = 0; i < k; i++)
+                if (lambda[i] <= 0)
+                    inside = false;
+            if (!inside)
+                continue;
+            vec3d p = {0, 0, 0};
+            for (int i = 0; i < k; i++)
+                for (int c = 0; c < 3; c++)
+                    p[c] += lambda[i] * w[idx[i]][c];
+            double norm = Dot(p, p);
+            if (norm < best_norm)
+            {
+                best_norm = norm;
+                best_point = p;
+                best_mask = mask;
+            }
+        }
+
+        int k = 0;
+        for (int i = 0; i < n; i++)
+            if (best_mask & (1 << i))
+            {
+                w[k] = w[i];
+                wa[k] = wa[i];
+                wb[k] = wb[i];
+                k++;
+            }
+        n = k;
+        return best_point;
+    }
+
+    double GJKDistance(const ConvexSupport &a, const ConvexSupport &b)
+    {
+        if (a.points.empty() || b.points.empty())
+            return INF;
+
+        double scale = 0;
+        for (const vec3d &p : a.points)
+            scale = max(scale, Dot(p, p));
+        for (const vec3d &p : b.points)
+            scale = max(scale, Dot(p, p));
+
+        // simplex of A - B, with the vertices of A and B it came from, seeded with an arbitrary point
+        vec3d w[4], wa[4], wb[4];
+        int ia = 0, ib = 0;
+        vec3d v = Sub(a.points[0], b.points[0]);
+        w[0] = v;
+        wa[0] = a.points[0];
+        wb[0] = b.points[0];
+        int n = 1;
+
+        for (int iter = 0; iter < 128; iter++)
+        {
+            double vv = Dot(v, v);
+            if (vv <= 1e-24 * scale)
+                return 0;
+
+            ia = a.Support({-v[0], -v[1], -v[2]}, ia);
+            ib = b.Support(v, ib);
+            vec3d s = Sub(a.points[ia], b.points[ib]);
+
+            // no support point gets meaningfully closer than v: v is the distance vector
+            if (vv - Dot(v, s) <= 1e-12 * vv)
+                break;
+            bool repeated = false;
+            for (int i = 0; i < n; i++)
+                if (wa[i] == a.points[ia] && wb[i] == b.points[ib])
+                    repeated = true;
+            if (repeated)
+                break;
+
+            w[n] = s;
+            wa[n] = a.points[ia];
+            wb[n] = b.points[ib];
+            n++;
+            vec3d next = ClosestOnSimplex(w, wa, wb, n);
+            if (n == 4)
+                return 0; // the origin is inside the tetrahedron: the hulls intersect
+            if (Dot(next, next) >= vv)
+                break; // numerical stall
+            v = next;
+        }
+        return sqrt(Dot(v, v));
+    }
+}
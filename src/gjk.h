@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vector>
+
+#include "shape.h"
+#include "model_obj.h"
+
+namespace coacd
+{
+    // Vertex adjacency of a convex hull, so support queries can hill-climb from a previous answer
+    // instead of scanning every vertex
+    struct ConvexSupport
+    {
+        vector<vec3d> points;
+        vector<int> offsets;   // neighbors of vertex i are neighbors[offsets[i]..offsets[i + 1])
+        vector<int> neighbors;
+
+        ConvexSupport() {}
+        ConvexSupport(Model &ch);
+        int Support(const vec3d &dir, int start) const;
+    };
+
+    // Euclidean distance between two convex hulls (0 if they intersect), by GJK on their Minkowski difference
+    double GJKDistance(const ConvexSupport &a, const ConvexSupport &b);
+}
@@ -17,6 +17,7 @@
 
 #include "nanoflann.hpp"
 #include "shape.h"
+#include "arena.h"
 using namespace std;
 using namespace nanoflann;
 
@@ -146,37 +147,27 @@ namespace coacd
         }
     }
 
-    double face_hausdorff_distance(Model &meshA, vector<vec3d> &XA, vector<int> &idA, Model &meshB, vector<vec3d> &XB, vector<int> &idB, bool flag = false)
+    // KD-tree over single-precision points; only neighbour selection runs in float, distances are taken in double
+    typedef KDTreeSingleIndexAdaptor<L2_Simple_Adaptor<float, PointsSoA>, PointsSoA, 3> PointsKDTree;
+
+    double face_hausdorff_distance(const Model &meshA, const vector<vec3d> &XA, const PointsSoA &cloudA, const vector<int> &idA,
+                                   const Model &meshB, const vector<vec3d> &XB, const PointsSoA &cloudB, const vector<int> &idB, bool flag = false)
     {
         int nA = XA.size();
         int nB = XB.size();
         double cmax = 0;
 
-        PointCloud<double> cloudA, cloudB;
-        vec2PointCloud(cloudA, XA);
-        vec2PointCloud(cloudB, XB);
-
-        typedef KDTreeSingleIndexAdaptor<
-            L2_Simple_Adaptor<double, PointCloud<double>>,
-            PointCloud<double>,
-            3 /* dim */
-            >
-            my_kd_tree_t;
-
-        my_kd_tree_t indexA(3 /*dim*/, cloudA, KDTreeSingleIndexAdaptorParams(10 /* max leaf */));
-        my_kd_tree_t indexB(3 /*dim*/, cloudB, KDTreeSingleIndexAdaptorParams(10 /* max leaf */));
+        PointsKDTree indexA(3 /*dim*/, cloudA, KDTreeSingleIndexAdaptorParams(10 /* max leaf */));
+        PointsKDTree indexB(3 /*dim*/, cloudB, KDTreeSingleIndexAdaptorParams(10 /* max leaf */));
         indexA.buildIndex();
         indexB.buildIndex();
 
+        size_t ret_index[10];
+        float out_dist_sqr[10];
         for (int i = 0; i < nB; i++)
         {
-            size_t num_results = 10;
-            double query_pt[3] = {XB[i][0], XB[i][1], XB[i][2]};
-
-            std::vector<size_t> ret_index(num_results);
-            std::vector<double> out_dist_sqr(num_results);
-
-            num_results = indexA.knnSearch(&query_pt[0], num_results, &ret_index[0], &out_dist_sqr[0]);
+            const float query_pt[3] = {cloudB.x[i], cloudB.y[i], cloudB.z[i]};
+            size_t num_results = indexA.knnSearch(&query_pt[0], 10, &ret_index[0], &out_dist_sqr[0]);
 
             double cmin = INF;
             for (int j = 0; j < (int)num_results; j++)
@@ -198,14 +189,8 @@ namespace coacd
 
         for (int i = 0; i < nA; i++)
         {
-            size_t num_results = 10;
-
-            double query_pt[3] = {XA[i][0], XA[i][1], XA[i][2]};
-
-            std::vector<size_t> ret_index(num_results);
-            std::vector<double> out_dist_sqr(num_results);
-
-            num_results = indexB.knnSearch(&query_pt[0], num_results, &ret_index[0], &out_dist_sqr[0]);
+            const float query_pt[3] = {cloudA.x[i], cloudA.y[i], cloudA.z[i]};
+            size_t num_results = indexB.knnSearch(&query_pt[0], 10, &ret_index[0], &out_dist_sqr[0]);
 
             double cmin = INF;
             for (int j = 0; j < (int)num_results; j++)
@@ -227,4 +212,10 @@ namespace coacd
 
         return cmax;
     }
+
+    double face_hausdorff_distance(const Model &meshA, const vector<vec3d> &XA, const vector<int> &idA, const Model &meshB, const vector<vec3d> &XB, const vector<int> &idB, bool flag = false)
+    {
+        ArenaScope scratch;
+        return face_hausdorff_distance(meshA, XA, PointsSoA(XA, scratch.resource()), idA, meshB, XB, PointsSoA(XB, scratch.resource()), idB, flag);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,878 @@
+#include <cmath>
+
+#include "hull.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace coacd
+{
+    /* exact arithmetic on floating-point expansions (Shewchuk, "Adaptive Precision
+       Floating-Point Arithmetic and Fast Robust Geometric Predicates") */
+
+    static inline void FastTwoSum(double a, double b, double &x, double &y)
+    {
+        x = a + b;
+        double bvirt = x - a;
+        y = b - bvirt;
+    }
+
+    static inline void TwoSum(double a, double b, double &x, double &y)
+    {
+        x = a + b;
+        double bvirt = x - a;
+        double avirt = x - bvirt;
+        y = (a - avirt) + (b - bvirt);
+    }
+
+    static inline void TwoDiff(double a, double b, double &x, double &y)
+    {
+        x = a - b;
+        double bvirt = a - x;
+        double avirt = x + bvirt;
+        y = (a - avirt) + (bvirt - b);
+    }
+
+    static inline void TwoProduct(double a, double b, double &x, double &y)
+    {
+        x = a * b;
+        y = std::fma(a, b, -x);
+    }
+
+    static int ScaleExpansion(int elen, const double *e, double b, double *h)
+    {
+        double Q, hh, product1, product0, sum;
+        int hindex = 0;
+        TwoProduct(e[0], b, Q, hh);
+        if (hh != 0.0)
+            h[hindex++] = hh;
+        for (int i = 1; i < elen; i++)
+        {
+            TwoProduct(e[i], b, product1, product0);
+            TwoSum(Q, product0, sum, hh);
+            if (hh != 0.0)
+                h[hindex++] = hh;
+            FastTwoSum(product1, sum, Q, hh);
+            if (hh != 0.0)
+                h[hindex++] = hh;
+        }
+        if (Q != 0.0 || hindex == 0)
+            h[hindex++] = Q;
+        return hindex;
+    }
+
+    static int ExpansionSum(int elen, const double *e, int flen, const double *f, double *h)
+    {
+        double Q, Qnew, hh;
+        int eindex = 0, findex = 0, hindex = 0;
+        double enow = e[0];
+        double fnow = f[0];
+        if ((fnow > enow) == (fnow > -enow))
+        {
+            Q = enow;
+            enow = ++eindex < elen ? e[eindex] : 0.0;
+        }
+        else
+        {
+            Q = fnow;
+            fnow = ++findex < flen ? f[findex] : 0.0;
+        }
+        if (eindex < elen && findex < flen)
+        {
+            if ((fnow > enow) == (fnow > -enow))
+            {
+                FastTwoSum(enow, Q, Qnew, hh);
+                enow = ++eindex < elen ? e[eindex] : 0.0;
+            }
+            else
+            {
+                FastTwoSum(fnow, Q, Qnew, hh);
+                fnow = ++findex < flen ? f[findex] : 0.0;
+            }
+            Q = Qnew;
+            if (hh != 0.0)
+                h[hindex++] = hh;
+            while (eindex < elen && findex < flen)
+            {
+                if ((fnow > enow) == (fnow > -enow))
+                {
+                    TwoSum(Q, enow, Qnew, hh);
+                    enow = ++eindex < elen ? e[eindex] : 0.0;
+                }
+                else
+                {
+                    TwoSum(Q, fnow, Qnew, hh);
+                    fnow = ++findex < flen ? f[findex] : 0.0;
+                }
+                Q = Qnew;
+                if (hh != 0.0)
+                    h[hindex++] = hh;
+            }
+        }
+        while (eindex < elen)
+        {
+            TwoSum(Q, enow, Qnew, hh);
+            enow = ++eindex < elen ? e[eindex] : 0.0;
+            Q = Qnew;
+            if (hh != 0.0)
+                h[hindex++] = hh;
+        }
+        while (findex < flen)
+        {
+            TwoSum(Q, fnow, Qnew, hh);
+            fnow = ++findex < flen ? f[findex] : 0.0;
+            Q = Qnew;
+            if (hh != 0.0)
+                h[hindex++] = hh;
+        }
+        if (Q != 0.0 || hindex == 0)
+            h[hindex++] = Q;
+        return hindex;
+    }
+
+    // h = e * f, elen * flen * 2 components at most
+    static int ExpansionProduct(int elen, const double *e, int flen, const double *f, double *h)
+    {
+        double part[64], acc[2][128];
+        int alen = ScaleExpansion(elen, e, f[0], acc[0]);
+        int cur = 0;
+        for (int i = 1; i < flen; i++)
+        {
+            int plen = ScaleExpansion(elen, e, f[i], part);
+            alen = ExpansionSum(alen, acc[cur], plen, part, acc[1 - cur]);
+            cur = 1 - cur;
+        }
+        for (int i = 0; i < alen; i++)
+            h[i] = acc[cur][i];
+        return alen;
+    }
+
+    static int ExpansionDiff(int elen, const double *e, int flen, const double *f, double *h)
+    {
+        double neg[128];
+        for (int i = 0; i < flen; i++)
+            neg[i] = -f[i];
+        return ExpansionSum(elen, e, flen, neg, h);
+    }
+
+    // Shewchuk's orient3d(a, b, c, d) evaluated exactly
+    static double Orient3DExact(const vec3d &a, const vec3d &b, const vec3d &c, const vec3d &d)
+    {
+        double adx[2], ady[2], adz[2], bdx[2], bdy[2], bdz[2], cdx[2], cdy[2], cdz[2];
+        TwoDiff(a[0], d[0], adx[1], adx[0]);
+        TwoDiff(a[1], d[1], ady[1], ady[0]);
+        TwoDiff(a[2], d[2], adz[1], adz[0]);
+        TwoDiff(b[0], d[0], bdx[1], bdx[0]);
+        TwoDiff(b[1], d[1], bdy[1], bdy[0]);
+        TwoDiff(b[2], d[2], bdz[1], bdz[0]);
+        TwoDiff(c[0], d[0], cdx[1], cdx[0]);
+        TwoDiff(c[1], d[1], cdy[1], cdy[0]);
+        TwoDiff(c[2], d[2], cdz[1], cdz[0]);
+
+        double t1[8], t2[8], m[16], s[3][64];
+        int t1len, t2len, mlen, slen[3];
+
+        t1len = ExpansionProduct(2, bdx, 2, cdy, t1);
+        t2len = ExpansionProduct(2, cdx, 2, bdy, t2);
+        mlen = ExpansionDiff(t1len, t1, t2len, t2, m);
+        slen[0] = ExpansionProduct(mlen, m, 2, adz, s[0]);
+
+        t1len = ExpansionProduct(2, cdx, 2, ady, t1);
+        t2len = ExpansionProduct(2, adx, 2, cdy, t2);
+        mlen = ExpansionDiff(t1len, t1, t2len, t2, m);
+        slen[1] = ExpansionProduct(mlen, m, 2, bdz, s[1]);
+
+        t1len = ExpansionProduct(2, adx, 2, bdy, t1);
+        t2len = ExpansionProduct(2, bdx, 2, ady, t2);
+        mlen = ExpansionDiff(t1len, t1, t2len, t2, m);
+        slen[2] = ExpansionProduct(mlen, m, 2, cdz, s[2]);
+
+        double ab[128], det[192];
+        int ablen = ExpansionSum(slen[0], s[0], slen[1], s[1], ab);
+        int detlen = ExpansionSum(ablen, ab, slen[2], s[2], det);
+        return det[detlen - 1];
+    }
+
+    double Orient3D(const vec3d &a, const vec3d &b, const vec3d &c, const vec3d &d)
+    {
+        // static filter: the rounded determinant has the right sign whenever it exceeds this bound
+        static const double epsilon = std::ldexp(1.0, -53);
+        static const double errbound = (7.0 + 56.0 * epsilon) * epsilon;
+
+        double adx = a[0] - d[0], ady = a[1] - d[1], adz = a[2] - d[2];
+        double bdx = b[0] - d[0], bdy = b[1] - d[1], bdz = b[2] - d[2];
+        double cdx = c[0] - d[0], cdy = c[1] - d[1], cdz = c[2] - d[2];
+
+        double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+        double cdxady = cdx * ady, adxcdy = adx * cdy;
+        double adxbdy = adx * bdy, bdxady = bdx * ady;
+
+        double det = adz * (bdxcdy - cdxbdy) + bdz * (cdxady - adxcdy) + cdz * (adxbdy - bdxady);
+        double permanent = (fabs(bdxcdy) + fabs(cdxbdy)) * fabs(adz) + (fabs(cdxady) + fabs(adxcdy)) * fabs(bdz) + (fabs(adxbdy) + fabs(bdxady)) * fabs(cdz);
+        if (det > errbound * permanent || -det > errbound * permanent)
+            return -det;
+
+        // the determinant of the rounded differences, with exact products and sums (Shewchuk's stage B); it is the
+        // exact value when no difference was rounded, as for coplanar points on a grid or on a cap
+        static const double errbound_b = (3.0 + 28.0 * epsilon) * epsilon;
+        const double minors[3][5] = {{bdx, cdy, cdx, bdy, adz}, {cdx, ady, adx, cdy, bdz}, {adx, bdy, bdx, ady, cdz}};
+        double scaled[3][8], ab[16], fin[24];
+        int slen[3];
+        for (int k = 0; k < 3; k++)
+        {
+            const double *m = minors[k];
+            double t1[2], t2[2], minor[4];
+            TwoProduct(m[0], m[1], t1[1], t1[0]);
+            TwoProduct(m[2], m[3], t2[1], t2[0]);
+            int mlen = ExpansionDiff(2, t1, 2, t2, minor);
+            slen[k] = ScaleExpansion(mlen, minor, m[4], scaled[k]);
+        }
+        int ablen = ExpansionSum(slen[0], scaled[0], slen[1], scaled[1], ab);
+        int finlen = ExpansionSum(ablen, ab, slen[2], scaled[2], fin);
+        det = 0;
+        for (int i = 0; i < finlen; i++)
+            det += fin[i];
+        if (det >= errbound_b * permanent || -det >= errbound_b * permanent)
+            return -det;
+
+        double head, tail, tails = 0;
+        for (int i = 0; i < 3; i++)
+        {
+            TwoDiff(a[i], d[i], head, tail);
+            tails += fabs(tail);
+            TwoDiff(b[i], d[i], head, tail);
+            tails += fabs(tail);
+            TwoDiff(c[i], d[i], head, tail);
+            tails += fabs(tail);
+        }
+        if (tails == 0)
+            return -fin[finlen - 1];
+        return -Orient3DExact(a, b, c, d);
+    }
+
+    /* QuickHull */
+
+    // Point batches at least this large are classified in parallel; smaller hulls stay serial
+    static const int PARALLEL_HULL_CUTOFF = 20000;
+
+    struct HullFace
+    {
+        int v[3];     // counter-clockwise seen from outside
+        int n[3];     // n[i] is the face across edge (v[i], v[i + 1])
+        vec3d normal; // unit normal
+        double offset;
+        double tolerance; // bound on the rounding error of the plane distance, beyond it the distance's sign is exact
+        int furthest;
+        double furthest_dist;
+        int mark; // visibility round stamp
+        bool visible;
+        bool deleted;
+        vector<int> outside;
+    };
+
+    // Per-thread scratch state, reused across hulls so steady-state construction does not allocate
+    struct HullWorkspace
+    {
+        vector<HullFace> faces;
+        vector<int> free_faces;
+        vector<int> pending;
+        vector<int> visible;
+        vector<pair<int, int>> horizon;
+        vector<array<int, 3>> dfs; // face, first edge, edges visited
+        vector<int> new_faces;
+        vector<int> orphans;
+        vector<int> remap;
+        vector<int> assign; // face chosen for each classified point, -1 if it lies inside
+        vector<int> valence; // live faces around each input point
+        vector<pair<double, int>> heap; // (furthest distance, face), budgeted mode only
+        vector<vec3d> joint;             // both inputs of UniteHulls
+        vector<int> out_offsets;         // outgoing edges of vertex v are out_edges[out_offsets[v]..out_offsets[v + 1])
+        vector<pair<int, int>> out_edges; // (edge end, 3 * face + edge) of a seed hull
+        double scale;  // largest input coordinate magnitude
+        double margin; // points no farther than this from a face are left out of the hull
+        int hull_vertices;
+        int round;
+    };
+    static thread_local HullWorkspace hull_workspace;
+
+    static int NewFace(HullWorkspace &ws, const vector<vec3d> &pts, int a, int b, int c)
+    {
+        int id;
+        if (!ws.free_faces.empty())
+        {
+            id = ws.free_faces.back();
+            ws.free_faces.pop_back();
+        }
+        else
+        {
+            id = (int)ws.faces.size();
+            ws.faces.emplace_back();
+        }
+        HullFace &f = ws.faces[id];
+        f.v[0] = a;
+        f.v[1] = b;
+        f.v[2] = c;
+        f.n[0] = f.n[1] = f.n[2] = -1;
+        f.furthest = -1;
+        f.furthest_dist = 0;
+        f.mark = 0;
+        f.visible = false;
+        f.deleted = false;
+        f.outside.clear();
+        for (int v : {a, b, c})
+            if (ws.valence[v]++ == 0)
+                ws.hull_vertices++;
+
+        const vec3d &p0 = pts[a], &p1 = pts[b], &p2 = pts[c];
+        vec3d e1 = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]}, e2 = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        vec3d n = CrossProduct(e1, e2);
+        double len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (len > 0)
+            n = {n[0] / len, n[1] / len, n[2] / len};
+        f.normal = n;
+        f.offset = n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2];
+
+        // the rounded cross product turns the normal by up to about 20 eps * |e1| |e2| / |e1 x e2|, which moves a
+        // point of the input's extent by that times 2 sqrt(3) scale; the dot products add about 25 eps * scale. The
+        // tolerance is several times the sum; a degenerate face always goes to Orient3D.
+        static const double epsilon = std::ldexp(1.0, -53);
+        double spread = sqrt((e1[0] * e1[0] + e1[1] * e1[1] + e1[2] * e1[2]) * (e2[0] * e2[0] + e2[1] * e2[1] + e2[2] * e2[2]));
+        f.tolerance = len > 0 ? 512 * epsilon * ws.scale * (spread / len + 1) : INF;
+        return id;
+    }
+
+    static inline bool Above(const HullFace &f, const vector<vec3d> &pts, int p)
+    {
+        // the plane distance settles all but the points close to the face's plane
+        double dist = f.normal[0] * pts[p][0] + f.normal[1] * pts[p][1] + f.normal[2] * pts[p][2] - f.offset;
+        if (dist > f.tolerance)
+            return true;
+        if (dist < -f.tolerance)
+            return false;
+        return Orient3D(pts[f.v[0]], pts[f.v[1]], pts[f.v[2]], pts[p]) > 0;
+    }
+
+    // Whether p goes to the outside set of f. The margin only drops points, so every point kept is exactly above
+    // the face and the visible regions built from it stay exact.
+    static inline bool Outside(const HullWorkspace &ws, const HullFace &f, const vector<vec3d> &pts, int p)
+    {
+        if (ws.margin > 0 && f.normal[0] * pts[p][0] + f.normal[1] * pts[p][1] + f.normal[2] * pts[p][2] - f.offset <= ws.margin)
+            return false;
+        return Above(f, pts, p);
+    }
+
+    static void AddOutside(HullWorkspace &ws, const vector<vec3d> &pts, int fid, int p)
+    {
+        HullFace &f = ws.faces[fid];
+        double dist = f.normal[0] * pts[p][0] + f.normal[1] * pts[p][1] + f.normal[2] * pts[p][2] - f.offset;
+        if (f.outside.empty())
+            ws.pending.push_back(fid);
+        if (f.furthest < 0 || dist > f.furthest_dist)
+        {
+            f.furthest = p;
+            f.furthest_dist = dist;
+        }
+        f.outside.push_back(p);
+    }
+
+    static void Link(HullWorkspace &ws, int fid, int a, int b, int other)
+    {
+        HullFace &f = ws.faces[fid];
+        for (int i = 0; i < 3; i++)
+            if (f.v[i] == a && f.v[(i + 1) % 3] == b)
+                f.n[i] = other;
+    }
+
+    static bool InitialSimplex(HullWorkspace &ws, const vector<vec3d> &pts, int simplex[4])
+    {
+        const int n = (int)pts.size();
+        int extremes[6] = {0, 0, 0, 0, 0, 0};
+        for (int i = 1; i < n; i++)
+            for (int k = 0; k < 3; k++)
+            {
+                if (pts[i][k] < pts[extremes[2 * k]][k])
+                    extremes[2 * k] = i;
+                if (pts[i][k] > pts[extremes[2 * k + 1]][k])
+                    extremes[2 * k + 1] = i;
+            }
+
+        double best = 0;
+        simplex[0] = simplex[1] = 0;
+        for (int i = 0; i < 6; i++)
+            for (int j = i + 1; j < 6; j++)
+            {
+                const vec3d &p = pts[extremes[i]], &q = pts[extremes[j]];
+                double d = (p[0] - q[0]) * (p[0] - q[0]) + (p[1] - q[1]) * (p[1] - q[1]) + (p[2] - q[2]) * (p[2] - q[2]);
+                if (d > best)
+                {
+                    best = d;
+                    simplex[0] = extremes[i];
+                    simplex[1] = extremes[j];
+                }
+            }
+        if (best == 0)
+            return false;
+
+        const vec3d &p0 = pts[simplex[0]], &p1 = pts[simplex[1]];
+        vec3d dir = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        best = 0;
+        simplex[2] = -1;
+        for (int i = 0; i < n; i++)
+        {
+            vec3d c = CrossProduct(dir, vec3d{pts[i][0] - p0[0], pts[i][1] - p0[1], pts[i][2] - p0[2]});
+            double d = c[0] * c[0] + c[1] * c[1] + c[2] * c[2];
+            if (d > best)
+            {
+                best = d;
+                simplex[2] = i;
+            }
+        }
+        if (simplex[2] < 0)
+            return false;
+
+        const vec3d &p2 = pts[simplex[2]];
+        best = 0;
+        simplex[3] = -1;
+        for (int i = 0; i < n; i++)
+        {
+            double d = fabs(Orient3D(p0, p1, p2, pts[i]));
+            if (d > best)
+            {
+                best = d;
+                simplex[3] = i;
+            }
+        }
+        if (simplex[3] < 0)
+            return false;
+
+        // orient the tetrahedron so that every face sees the opposite vertex on its negative side
+        double orientation = Orient3D(p0, p1, p2, pts[simplex[3]]);
+        if (orientation == 0)
+            return false;
+        if (orientation > 0)
+            std::swap(simplex[1], simplex[2]);
+        const int tri[4][4] = {{0, 1, 2, 3}, {0, 3, 1, 2}, {1, 3, 2, 0}, {2, 3, 0, 1}};
+        int fids[4];
+        for (int i = 0; i < 4; i++)
+            fids[i] = NewFace(ws, pts, simplex[tri[i][0]], simplex[tri[i][1]], simplex[tri[i][2]]);
+        for (int i = 0; i < 4; i++)
+            for (int j = 0; j < 4; j++)
+            {
+                if (i == j)
+                    continue;
+                HullFace &f = ws.faces[fids[j]];
+                for (int e = 0; e < 3; e++)
+                    Link(ws, fids[i], f.v[(e + 1) % 3], f.v[e], fids[j]);
+            }
+
+        // the exact tests are independent per point; only the list insertion below is serial
+        ws.assign.assign(n, -1);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if (n >= PARALLEL_HULL_CUTOFF)
+#endif
+        for (int i = 0; i < n; i++)
+        {
+            if (i == simplex[0] || i == simplex[1] || i == simplex[2] || i == simplex[3])
+                continue;
+            for (int k = 0; k < 4; k++)
+                if (Outside(ws, ws.faces[fids[k]], pts, i))
+                {
+                    ws.assign[i] = k;
+                    break;
+                }
+        }
+        for (int i = 0; i < n; i++)
+            if (ws.assign[i] >= 0)
+                AddOutside(ws, pts, fids[ws.assign[i]], i);
+        return true;
+    }
+
+    // Visible region around face `start` seen from `eye`, with its boundary collected as an ordered edge loop
+    static void ComputeHorizon(HullWorkspace &ws, const vector<vec3d> &pts, int eye, int start)
+    {
+        const int round = ++ws.round;
+        ws.visible.clear();
+        ws.horizon.clear();
+        ws.dfs.clear();
+
+        ws.faces[start].mark = round;
+        ws.faces[start].visible = true;
+        ws.visible.push_back(start);
+        ws.dfs.push_back({start, 0, 0});
+        while (!ws.dfs.empty())
+        {
+            array<int, 3> &top = ws.dfs.back();
+            int steps = top[0] == start ? 3 : 2;
+            if (top[2] == steps)
+            {
+                ws.dfs.pop_back();
+                continue;
+            }
+            int fid = top[0];
+            int e = (top[1] + top[2]) % 3;
+            top[2]++;
+
+            int nid = ws.faces[fid].n[e];
+            HullFace &nb = ws.faces[nid];
+            if (nb.mark != round)
+            {
+                nb.mark = round;
+                nb.visible = Above(nb, pts, eye);
+                if (nb.visible)
+                {
+                    ws.visible.push_back(nid);
+                    int back = 0;
+                    while (nb.n[back] != fid || nb.v[back] != ws.faces[fid].v[(e + 1) % 3])
+                        back++;
+                    ws.dfs.push_back({nid, (back + 1) % 3, 0});
+                    continue;
+                }
+            }
+            if (!nb.visible)
+                ws.horizon.push_back({fid, e});
+        }
+    }
+
+    // Scale factors about `center` for the hull vertices so that the scaled vertex set encloses every point
+    // still outside the hull. A point p is reached through the face its ray from the center exits, the face
+    // maximising need / reach; scaling that face's three vertices by the ratio covers p.
+    static void EnclosingScales(HullWorkspace &ws, const vector<vec3d> &points, const vec3d &center, vector<double> &scales)
+    {
+        for (int fid = 0; fid < (int)ws.faces.size(); fid++)
+        {
+            if (ws.faces[fid].deleted)
+                continue;
+            for (int p : ws.faces[fid].outside)
+            {
+                // the faces seen from p form a connected patch around the face p was assigned to, and include the exit face
+                const int round = ++ws.round;
+                ws.faces[fid].mark = round;
+                ws.visible.clear();
+                ws.visible.push_back(fid);
+                int exit_face = fid;
+                double ratio = 1.0;
+                for (int k = 0; k < (int)ws.visible.size(); k++)
+                {
+                    const HullFace &f = ws.faces[ws.visible[k]];
+                    double reach = f.offset - (f.normal[0] * center[0] + f.normal[1] * center[1] + f.normal[2] * center[2]);
+                    double need = f.normal[0] * (points[p][0] - center[0]) + f.normal[1] * (points[p][1] - center[1]) + f.normal[2] * (points[p][2] - center[2]);
+                    if (reach > 0 && need / reach > ratio)
+                    {
+                        ratio = need / reach;
+                        exit_face = ws.visible[k];
+                    }
+                    for (int nid : f.n)
+                    {
+                        HullFace &nb = ws.faces[nid];
+                        if (nb.mark == round)
+                            continue;
+                        nb.mark = round;
+                        if (Above(nb, points, p))
+                            ws.visible.push_back(nid);
+                    }
+                }
+                for (int v : ws.faces[exit_face].v)
+                    scales[v] = max(scales[v], ratio);
+            }
+        }
+    }
+
+    static void ResetWorkspace(HullWorkspace &ws, const vector<vec3d> &points)
+    {
+        const int n = (int)points.size();
+        ws.scale = 0;
+        for (const vec3d &p : points)
+            ws.scale = max(ws.scale, max(fabs(p[0]), max(fabs(p[1]), fabs(p[2]))));
+        ws.margin = 0;
+        // recycle every face slot of the previous hull so their outside lists keep their capacity
+        ws.free_faces.clear();
+        for (int i = (int)ws.faces.size() - 1; i >= 0; i--)
+        {
+            ws.faces[i].deleted = true;
+            ws.free_faces.push_back(i);
+        }
+        ws.pending.clear();
+        ws.heap.clear();
+        ws.valence.assign(n, 0);
+        ws.hull_vertices = 0;
+        ws.round = 0;
+    }
+
+    // Grow the current hull until no point is left outside it (or, if budget, until it has max_vertex vertices).
+    // Returns false if a horizon is not a single loop.
+    static bool ExpandHull(HullWorkspace &ws, const vector<vec3d> &points, bool budget, int max_vertex)
+    {
+        while (true)
+        {
+            int fid;
+            if (budget)
+            {
+                // farthest point first, so the vertices spent are the ones that matter most;
+                // a face's outside set only changes when it is created, so its heap entry stays exact
+                for (int nid : ws.pending)
+                {
+                    ws.heap.push_back({ws.faces[nid].furthest_dist, nid});
+                    std::push_heap(ws.heap.begin(), ws.heap.end());
+                }
+                ws.pending.clear();
+                if (ws.heap.empty() || ws.hull_vertices >= max_vertex)
+                    break;
+                std::pop_heap(ws.heap.begin(), ws.heap.end());
+                fid = ws.heap.back().second;
+                ws.heap.pop_back();
+            }
+            else
+            {
+                if (ws.pending.empty())
+                    break;
+                fid = ws.pending.back();
+                ws.pending.pop_back();
+            }
+            if (ws.faces[fid].deleted || ws.faces[fid].outside.empty())
+                continue;
+            int eye = ws.faces[fid].furthest;
+
+            ComputeHorizon(ws, points, eye, fid);
+
+            // the exact visibility test keeps the visible region a disk, so the horizon is one closed loop
+            const int nh = (int)ws.horizon.size();
+            for (int k = 0; k < nh; k++)
+            {
+                const HullFace &f = ws.faces[ws.horizon[k].first];
+                const HullFace &g = ws.faces[ws.horizon[(k + 1) % nh].first];
+                if (f.v[(ws.horizon[k].second + 1) % 3] != g.v[ws.horizon[(k + 1) % nh].second])
+                    return false;
+            }
+
+            ws.orphans.clear();
+            for (int vid : ws.visible)
+            {
+                HullFace &f = ws.faces[vid];
+                for (int p : f.outside)
+                    if (p != eye)
+                        ws.orphans.push_back(p);
+                f.outside.clear();
+                f.deleted = true;
+                for (int v : f.v)
+                    if (--ws.valence[v] == 0)
+                        ws.hull_vertices--;
+            }
+
+            ws.new_faces.clear();
+            for (int k = 0; k < nh; k++)
+            {
+                int a = ws.faces[ws.horizon[k].first].v[ws.horizon[k].second];
+                int b = ws.faces[ws.horizon[k].first].v[(ws.horizon[k].second + 1) % 3];
+                int across = ws.faces[ws.horizon[k].first].n[ws.horizon[k].second];
+                int nid = NewFace(ws, points, a, b, eye);
+                ws.faces[nid].n[0] = across;
+                Link(ws, across, b, a, nid);
+                ws.new_faces.push_back(nid);
+            }
+            for (int k = 0; k < nh; k++)
+            {
+                HullFace &f = ws.faces[ws.new_faces[k]];
+                f.n[1] = ws.new_faces[(k + 1) % nh];
+                f.n[2] = ws.new_faces[(k + nh - 1) % nh];
+            }
+            // deleted faces are recycled only after the new ones took their slots' neighbours
+            for (int vid : ws.visible)
+                ws.free_faces.push_back(vid);
+
+            const int no = (int)ws.orphans.size();
+            if (no < PARALLEL_HULL_CUTOFF)
+            {
+                for (int p : ws.orphans)
+                    for (int nid : ws.new_faces)
+                        if (Outside(ws, ws.faces[nid], points, p))
+                        {
+                            AddOutside(ws, points, nid, p);
+                            break;
+                        }
+                continue;
+            }
+
+            // the first expansions of a large input hand most of its points to the new cone at once
+            ws.assign.assign(no, -1);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+            for (int i = 0; i < no; i++)
+                for (int k = 0; k < nh; k++)
+                    if (Outside(ws, ws.faces[ws.new_faces[k]], points, ws.orphans[i]))
+                    {
+                        ws.assign[i] = k;
+                        break;
+                    }
+            for (int i = 0; i < no; i++)
+                if (ws.assign[i] >= 0)
+                    AddOutside(ws, points, ws.new_faces[ws.assign[i]], ws.orphans[i]);
+        }
+        return true;
+    }
+
+    static void ExtractHull(HullWorkspace &ws, const vector<vec3d> &points, vector<vec3d> &hull_points, vector<vec3i> &hull_triangles)
+    {
+        ws.remap.assign(points.size(), -1);
+        // a closed triangulated hull with F faces has F / 2 + 2 vertices
+        const int faces = (int)ws.faces.size() - (int)ws.free_faces.size();
+        hull_triangles.reserve(faces);
+        hull_points.reserve(faces / 2 + 2);
+        for (const HullFace &f : ws.faces)
+        {
+            if (f.deleted)
+                continue;
+            vec3i tri;
+            for (int i = 0; i < 3; i++)
+            {
+                int &id = ws.remap[f.v[i]];
+                if (id < 0)
+                {
+                    id = (int)hull_points.size();
+                    hull_points.push_back(points[f.v[i]]);
+                }
+                tri[i] = id;
+            }
+            hull_triangles.push_back(tri);
+        }
+    }
+
+    bool ComputeHull(const vector<vec3d> &points, vector<vec3d> &hull_points, vector<vec3i> &hull_triangles, int max_vertex, double tolerance)
+    {
+        hull_points.clear();
+        hull_triangles.clear();
+        if (points.size() < 4)
+            return false;
+
+        HullWorkspace &ws = hull_workspace;
+        ResetWorkspace(ws, points);
+        ws.margin = tolerance * ws.scale;
+        const bool budget = max_vertex >= 4 && max_vertex < (int)points.size();
+
+        int simplex[4];
+        if (!InitialSimplex(ws, points, simplex))
+            return false;
+        if (!ExpandHull(ws, points, budget, max_vertex))
+            return false;
+        ExtractHull(ws, points, hull_points, hull_triangles);
+
+        if (budget && !ws.heap.empty())
+        {
+            // each enclosed point is a convex combination of scaled vertices, so their hull encloses everything
+            vec3d center = {0, 0, 0};
+            for (const vec3d &p : hull_points)
+                for (int k = 0; k < 3; k++)
+                    center[k] += p[k] / hull_points.size();
+            vector<double> scales(points.size(), 1.0);
+            EnclosingScales(ws, points, center, scales);
+            vector<vec3d> scaled;
+            for (int i = 0; i < (int)points.size(); i++)
+                if (ws.remap[i] >= 0)
+                    scaled.push_back({center[0] + (points[i][0] - center[0]) * scales[i],
+                                      center[1] + (points[i][1] - center[1]) * scales[i],
+                                      center[2] + (points[i][2] - center[2]) * scales[i]});
+            return ComputeHull(scaled, hull_points, hull_triangles);
+        }
+        return true;
+    }
+    // Faces of a closed hull, counter-clockwise seen from outside, wired to their neighbours.
+    // Returns false unless every directed edge has exactly one twin and every edge is convex.
+    static bool SeedHull(HullWorkspace &ws, const vector<vec3d> &pts, const vector<vec3i> &triangles)
+    {
+        const int n = (int)pts.size(), nf = (int)triangles.size();
+        ws.new_faces.clear();
+        for (int i = 0; i < nf; i++)
+            ws.new_faces.push_back(NewFace(ws, pts, triangles[i][0], triangles[i][1], triangles[i][2]));
+
+        // every face around a vertex leaves it through exactly one of its edges, so valence sizes the buckets
+        ws.out_offsets.assign(n + 1, 0);
+        for (int v = 0; v < n; v++)
+            ws.out_offsets[v + 1] = ws.out_offsets[v] + ws.valence[v];
+        ws.out_edges.resize(3 * nf);
+        ws.assign.assign(ws.out_offsets.begin(), ws.out_offsets.end() - 1);
+        for (int fid : ws.new_faces)
+            for (int e = 0; e < 3; e++)
+                ws.out_edges[ws.assign[ws.faces[fid].v[e]]++] = {ws.faces[fid].v[(e + 1) % 3], 3 * fid + e};
+
+        for (int fid : ws.new_faces)
+        {
+            HullFace &f = ws.faces[fid];
+            for (int e = 0; e < 3; e++)
+            {
+                const int a = f.v[e], b = f.v[(e + 1) % 3];
+                int twin = -1, count = 0, same = 0;
+                for (int k = ws.out_offsets[b]; k < ws.out_offsets[b + 1]; k++)
+                    if (ws.out_edges[k].first == a)
+                    {
+                        twin = ws.out_edges[k].second;
+                        count++;
+                    }
+                for (int k = ws.out_offsets[a]; k < ws.out_offsets[a + 1]; k++)
+                    if (ws.out_edges[k].first == b)
+                        same++;
+                if (count != 1 || same != 1)
+                    return false;
+
+                // a float test suffices to reject a non-convex seed, caps make exactly coplanar neighbours common
+                const vec3d &q = pts[ws.faces[twin / 3].v[(twin % 3 + 2) % 3]];
+                if (f.normal[0] * q[0] + f.normal[1] * q[1] + f.normal[2] * q[2] - f.offset > 1e-9)
+                    return false;
+                f.n[e] = twin / 3;
+            }
+        }
+        return true;
+    }
+
+    bool UniteHulls(const vector<vec3d> &points1, const vector<vec3i> &triangles1, const vector<vec3d> &points2, const vector<vec3i> &triangles2,
+                    vector<vec3d> &hull_points, vector<vec3i> &hull_triangles, double &volume)
+    {
+        hull_points.clear();
+        hull_triangles.clear();
+
+        // the hull with more faces is kept; the other one only contributes its vertices outside of it
+        const bool swap = triangles2.size() > triangles1.size();
+        const vector<vec3d> &seed_points = swap ? points2 : points1, &other_points = swap ? points1 : points2;
+        const vector<vec3i> &seed_triangles = swap ? triangles2 : triangles1;
+        if (seed_triangles.size() < 4)
+            return false;
+
+        HullWorkspace &ws = hull_workspace;
+        ws.joint.assign(seed_points.begin(), seed_points.end());
+        ws.joint.insert(ws.joint.end(), other_points.begin(), other_points.end());
+        const vector<vec3d> &pts = ws.joint;
+        const int ns = (int)seed_points.size(), n = (int)pts.size();
+        ResetWorkspace(ws, pts);
+        if (!SeedHull(ws, pts, seed_triangles))
+            return false;
+
+        // a point inside the seed is inside the union; the others start from the first face they see,
+        // scanning from the previous point's face since consecutive hull vertices tend to be close
+        ws.assign.assign(n, -1);
+        const int nf = (int)ws.new_faces.size();
+        int last = 0;
+        for (int i = ns; i < n; i++)
+            for (int k = 0; k < nf; k++)
+            {
+                int j = (last + k) % nf;
+                if (Above(ws.faces[ws.new_faces[j]], pts, i))
+                {
+                    ws.assign[i] = ws.new_faces[j];
+                    last = j;
+                    break;
+                }
+            }
+        for (int i = ns; i < n; i++)
+            if (ws.assign[i] >= 0)
+                AddOutside(ws, pts, ws.assign[i], i);
+
+        if (!ExpandHull(ws, pts, false, -1))
+            return false;
+        ExtractHull(ws, pts, hull_points, hull_triangles);
+
+        volume = 0;
+        for (const vec3i &tri : hull_triangles)
+            volume += Volume(hull_points[tri[0]], hull_points[tri[1]], hull_points[tri[2]]);
+        return true;
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+
+#include "shape.h"
+
+namespace coacd
+{
+    // Orientation of d against the plane through a, b, c:
+    // > 0 if d lies on the side of (b - a) x (c - a), < 0 on the other side, 0 if coplanar.
+    // The sign is exact (floating-point filter with an exact expansion fallback).
+    double Orient3D(const vec3d &a, const vec3d &b, const vec3d &c, const vec3d &d);
+
+    // Double-precision QuickHull whose visibility decisions all go through Orient3D.
+    // Output triangles are counter-clockwise seen from outside. Returns false only for
+    // inputs without a full-dimensional hull (fewer than 4 non-coplanar points).
+    // With max_vertex >= 4, points are inserted farthest-first until the hull has max_vertex
+    // vertices; those are then pushed away from the centroid just enough to enclose the rest.
+    // With tolerance > 0, a point within tolerance * (largest coordinate magnitude) of the planes of the faces it sees
+    // is left out, so the near-coplanar vertices of cut caps do not become hull vertices. Such a point can end up
+    // outside the hull by that distance over the sine of half the dihedral angle, more than it at sharp edges.
+    bool ComputeHull(const vector<vec3d> &points, vector<vec3d> &hull_points, vector<vec3i> &hull_triangles, int max_vertex = -1, double tolerance = 0);
+
+    // Hull of the union of two closed convex hulls (counter-clockwise seen from outside), with its volume.
+    // The hull with more faces is extended in place by the other one's vertices outside it, so only the faces
+    // bridging the two are built. Returns false if an input is not such a hull; callers then use ComputeHull.
+    bool UniteHulls(const vector<vec3d> &points1, const vector<vec3i> &triangles1, const vector<vec3d> &points2, const vector<vec3i> &triangles2,
+                    vector<vec3d> &hull_points, vector<vec3i> &hull_triangles, double &volume);
+}
@@ -1,6 +1,12 @@
 #include "io.h"
 #include "logger.h"
 
+#include <bit>
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+
 namespace coacd
 {
     void SaveConfig(Params params)
@@ -17,14 +23,18 @@ namespace coacd
         logger::info("\tManifold Preprocess Mode (auto/on/off):    {}", params.preprocess_mode);
         logger::info("\tPreprocess Resolution:                     {}", params.prep_resolution);
         logger::info("\tMerge Postprocess (on/off):                {}", params.merge);
+        logger::info("\tMerge Mode (all/graph):                    {}", params.merge_mode);
         logger::info("\tDecimate Postprocess (on/off):             {}", params.decimate);
         logger::info("\tMax Convex Hull Vertex:                    {}", params.max_ch_vertex);
+        logger::info("\tDecimate Mode (collapse/hull):             {}", params.decimate_mode);
         logger::info("\tExtrude Postprocess (on/off):              {}", params.extrude);
         logger::info("\tExtrude Margin:                            {}", params.extrude_margin);
         logger::info("\tPCA (ON/OFF):                              {}", params.pca);
         logger::info("\tk for Rv:                                  {}", params.rv_k);
         logger::info("\tHausdorff Sampling Resolution:             {}", params.resolution);
         logger::info("\tApproximation Mode (ch/box):               {}", params.apx_mode);
+        logger::info("\tHausdorff Backend (kdtree/sdf):            {}", params.hb_mode);
+        logger::info("\tHull Distance Mode (kdtree/gjk):           {}", params.dist_mode);
         logger::info("\tRandom Seed:                               {}", params.seed);
     }
 
@@ -44,7 +54,7 @@ namespace coacd
         os.close();
     }
 
-    void SaveOBJ(const string &filename, vector<Model> parts, Params &params)
+    void SaveOBJ(const string &filename, const vector<Model> &parts, Params &params)
     {
         vector<int> v_numbers;
         v_numbers.push_back(0);
@@ -67,7 +77,7 @@ namespace coacd
         os.close();
     }
 
-    void SaveOBJs(const string &foldername, const string &filename, vector<Model> parts, Params &params)
+    void SaveOBJs(const string &foldername, const string &filename, const vector<Model> &parts, Params &params)
     {
         int n_zero = 3;
         for (int n = 0; n < (int)parts.size(); n++)
@@ -89,7 +99,7 @@ namespace coacd
         }
     }
 
-    bool WriteVRML(ofstream &fout, Model mesh)
+    bool WriteVRML(ofstream &fout, const Model &mesh)
     {
         Material material;
         material.m_diffuseColor[0] = material.m_diffuseColor[1] = material.m_diffuseColor[2] = 0.0f;
@@ -179,4 +189,508 @@ namespace coacd
             foutCH.close();
         }
     }
+
+    // Buffered sequential reads of a file, so large inputs are streamed instead of loaded whole
+    class FileReader
+    {
+    public:
+        explicit FileReader(const string &fileName) : fid(fopen(fileName.c_str(), "rb")), buffer(1 << 20) {}
+        ~FileReader()
+        {
+            if (fid)
+                fclose(fid);
+        }
+        FileReader(const FileReader &) = delete;
+        FileReader &operator=(const FileReader &) = delete;
+
+        bool ok() const { return fid != nullptr; }
+
+        // Bytes of the file consumed so far
+        size_t Tell() const { return offset + pos; }
+
+        bool Read(void *dst, size_t n)
+        {
+            char *out = static_cast<char *>(dst);
+            while (n > 0)
+            {
+                if (pos == filled && !Fill())
+                    return false;
+                size_t k = min(n, filled - pos);
+                memcpy(out, buffer.data() + pos, k);
+                pos += k;
+                out += k;
+                n -= k;
+            }
+            return true;
+        }
+
+        // Next line without its end, false at the end of the file
+        bool ReadLine(string &line)
+        {
+            line.clear();
+            while (true)
+            {
+                if (pos == filled && !Fill())
+                    return !line.empty();
+                const char *begin = buffer.data() + pos, *eol = static_cast<const char *>(memchr(begin, '\n', filled - pos));
+                size_t k = eol ? eol - begin : filled - pos;
+                line.append(begin, k);
+                pos += k;
+                if (eol)
+                {
+                    pos++;
+                    if (!line.empty() && line.back() == '\r')
+                        line.pop_back();
+                    return true;
+                }
+            }
+        }
+
+    private:
+        bool Fill()
+        {
+            offset += filled;
+            pos = 0;
+            filled = fread(buffer.data(), 1, buffer.size(), fid);
+            return filled > 0;
+        }
+
+        FILE *fid;
+        vector<char> buffer;
+        size_t pos = 0, filled = 0, offset = 0;
+    };
+
+    // Merges bitwise-equal points as they are added, so unindexed formats come out with shared vertices
+    class PointWelder
+    {
+    public:
+        explicit PointWelder(vector<vec3d> &points) : points(points), slots(1024, -1) {}
+
+        int Add(vec3d p)
+        {
+            for (double &x : p)
+                x += 0.0; // -0 and +0 are the same point
+            if (2 * (points.size() + 1) > slots.size())
+                Grow();
+            size_t mask = slots.size() - 1;
+            for (size_t h = Hash(p) & mask;; h = (h + 1) & mask)
+            {
+                if (slots[h] == -1)
+                {
+                    slots[h] = (int)points.size();
+                    points.push_back(p);
+                    return slots[h];
+                }
+                if (points[slots[h]] == p)
+                    return slots[h];
+            }
+        }
+
+    private:
+        static size_t Hash(const vec3d &p)
+        {
+            uint64_t h = 0;
+            for (double x : p)
+            {
+                uint64_t bits;
+                memcpy(&bits, &x, sizeof(bits));
+                h = (h ^ bits) * 0x9E3779B97F4A7C15ull;
+                h ^= h >> 29;
+            }
+            return (size_t)h;
+        }
+
+        void Grow()
+        {
+            slots.assign(2 * slots.size(), -1);
+            size_t mask = slots.size() - 1;
+            for (int i = 0; i < (int)points.size(); i++)
+            {
+                size_t h = Hash(points[i]) & mask;
+                while (slots[h] != -1)
+                    h = (h + 1) & mask;
+                slots[h] = i;
+            }
+        }
+
+        vector<vec3d> &points;
+        vector<int> slots;
+    };
+
+    // Triangles that welding collapsed to a segment or a point are dropped
+    static void AddWeldedTriangle(Model &mesh, PointWelder &welder, const vec3d &p0, const vec3d &p1, const vec3d &p2, size_t &degenerate)
+    {
+        vec3i t = {welder.Add(p0), welder.Add(p1), welder.Add(p2)};
+        if (t[0] == t[1] || t[1] == t[2] || t[2] == t[0])
+            degenerate++;
+        else
+            mesh.triangles.push_back(t);
+    }
+
+    static void FinishLoad(Model &mesh)
+    {
+        mesh.Invalidate();
+        const array<double, 6> &bounds = mesh.GetBounds();
+        for (int k = 0; k < 6; k++)
+            mesh.bbox[k] = bounds[k];
+    }
+
+    template <typename T>
+    static T FromLittleEndian(T value)
+    {
+        if constexpr (std::endian::native == std::endian::big)
+        {
+            char *bytes = reinterpret_cast<char *>(&value);
+            std::reverse(bytes, bytes + sizeof(T));
+        }
+        return value;
+    }
+
+    bool LoadSTL(const string &fileName, Model &mesh)
+    {
+        mesh.points.clear();
+        mesh.triangles.clear();
+
+        // binary STL: an 80-byte header, the triangle count, then 50 bytes per triangle; anything else starting
+        // with "solid" is read as ASCII
+        std::error_code ec;
+        uintmax_t size = std::filesystem::file_size(fileName, ec);
+        FileReader reader(fileName);
+        if (ec || !reader.ok())
+        {
+            logger::error("Open File Error!");
+            return false;
+        }
+        char header[80];
+        uint32_t count = 0;
+        bool binary = reader.Read(header, sizeof(header)) && reader.Read(&count, sizeof(count)) &&
+                      size == 84 + 50 * (uintmax_t)FromLittleEndian(count);
+        size_t degenerate = 0;
+        PointWelder welder(mesh.points);
+
+        if (binary)
+        {
+            count = FromLittleEndian(count);
+            mesh.triangles.reserve(count);
+            mesh.points.reserve(count / 2 + 2);
+            char record[50];
+            for (uint32_t i = 0; i < count; i++)
+            {
+                if (!reader.Read(record, sizeof(record)))
+                {
+                    logger::error("Invalid STL File!");
+                    return false;
+                }
+                vec3d p[3];
+                for (int j = 0; j < 3; j++)
+                    for (int k = 0; k < 3; k++)
+                    {
+                        float x;
+                        memcpy(&x, record + 12 * (j + 1) + 4 * k, sizeof(x)); // after the facet normal
+                        p[j][k] = FromLittleEndian(x);
+                    }
+                AddWeldedTriangle(mesh, welder, p[0], p[1], p[2], degenerate);
+            }
+        }
+        else
+        {
+            if (strncmp(header, "solid", 5) != 0)
+            {
+                logger::error("Invalid STL File!");
+                return false;
+            }
+            // the header was a part of the first lines
+            FileReader text(fileName);
+            string line;
+            vector<vec3d> loop;
+            while (text.ReadLine(line))
+            {
+                const char *p = line.c_str(), *end = p + line.size();
+                while (p < end && isspace((unsigned char)*p))
+                    p++;
+                if (strncmp(p, "vertex", 6) == 0)
+                {
+                    p += 6;
+                    vec3d v;
+                    for (int k = 0; k < 3; k++)
+                    {
+                        while (p < end && isspace((unsigned char)*p))
+                            p++;
+                        if (p < end && *p == '+')
+                            p++;
+                        std::from_chars_result r = std::from_chars(p, end, v[k]);
+                        if (r.ec != std::errc())
+                        {
+                            logger::error("Invalid STL File!");
+                            return false;
+                        }
+                        p = r.ptr;
+                    }
+                    loop.push_back(v);
+                }
+                else if (strncmp(p, "endloop", 7) == 0)
+                {
+                    for (int j = 1; j + 1 < (int)loop.size(); j++)
+                        AddWeldedTriangle(mesh, welder, loop[0], loop[j], loop[j + 1], degenerate);
+                    loop.clear();
+                }
+            }
+        }
+
+        if (degenerate > 0)
+            logger::warn("Dropped {} STL triangles that welding collapsed", degenerate);
+        FinishLoad(mesh);
+        return true;
+    }
+
+    // One property of a PLY element; lists are a count followed by that many items
+    struct PlyProperty
+    {
+        string name;
+        int size = 0;       // bytes of the value, or of each list item
+        int count_size = 0; // bytes of the list count, 0 for a scalar
+        char type = 'f';    // 'i' signed, 'u' unsigned or 'f' floating point
+    };
+
+    struct PlyElement
+    {
+        string name;
+        size_t count = 0;
+        vector<PlyProperty> properties;
+    };
+
+    static bool PlyType(const string &name, int &size, char &type)
+    {
+        static const std::pair<const char *, std::pair<int, char>> types[] = {
+            {"char", {1, 'i'}}, {"int8", {1, 'i'}}, {"uchar", {1, 'u'}}, {"uint8", {1, 'u'}},
+            {"short", {2, 'i'}}, {"int16", {2, 'i'}}, {"ushort", {2, 'u'}}, {"uint16", {2, 'u'}},
+            {"int", {4, 'i'}}, {"int32", {4, 'i'}}, {"uint", {4, 'u'}}, {"uint32", {4, 'u'}},
+            {"float", {4, 'f'}}, {"float32", {4, 'f'}}, {"double", {8, 'f'}}, {"float64", {8, 'f'}}};
+        for (const auto &t : types)
+            if (name == t.first)
+            {
+                size = t.second.first;
+                type = t.second.second;
+                return true;
+            }
+        return false;
+    }
+
+    // Value of a binary PLY scalar of the given size and type, stored in the file's byte order
+    static double PlyValue(const char *bytes, int size, char type, bool big_endian)
+    {
+        char v[8];
+        memcpy(v, bytes, size);
+        if (big_endian != (std::endian::native == std::endian::big))
+            std::reverse(v, v + size);
+        auto as = [&](auto x)
+        {
+            memcpy(&x, v, sizeof(x));
+            return (double)x;
+        };
+        if (type == 'f')
+            return size == 4 ? as(float()) : as(double());
+        if (type == 'i')
+            return size == 1 ? as(int8_t()) : size == 2 ? as(int16_t()) : as(int32_t());
+        return size == 1 ? as(uint8_t()) : size == 2 ? as(uint16_t()) : as(uint32_t());
+    }
+
+    // Values of a PLY body in file order: fixed-size records of the binary formats, or whitespace-separated numbers
+    // of the ASCII one
+    class PlyValueReader
+    {
+    public:
+        PlyValueReader(FileReader &reader, bool ascii, bool big_endian) : reader(reader), ascii(ascii), big_endian(big_endian) {}
+
+        bool Next(int size, char type, double &value)
+        {
+            if (!ascii)
+            {
+                char bytes[8];
+                if (!reader.Read(bytes, size))
+                    return false;
+                value = PlyValue(bytes, size, type, big_endian);
+                return true;
+            }
+            while (true)
+            {
+                while (pos < line.size() && isspace((unsigned char)line[pos]))
+                    pos++;
+                if (pos < line.size())
+                    break;
+                if (!reader.ReadLine(line))
+                    return false;
+                pos = 0;
+            }
+            const char *p = line.data() + pos, *end = line.data() + line.size();
+            if (*p == '+')
+                p++;
+            std::from_chars_result r = std::from_chars(p, end, value);
+            pos = r.ptr - line.data();
+            return r.ec == std::errc() && (r.ptr == end || isspace((unsigned char)*r.ptr));
+        }
+
+    private:
+        FileReader &reader;
+        bool ascii, big_endian;
+        string line;
+        size_t pos = 0;
+    };
+
+    bool LoadPLY(const string &fileName, Model &mesh)
+    {
+        mesh.points.clear();
+        mesh.triangles.clear();
+        std::error_code ec;
+        uintmax_t size = std::filesystem::file_size(fileName, ec);
+        FileReader reader(fileName);
+        if (ec || !reader.ok())
+        {
+            logger::error("Open File Error!");
+            return false;
+        }
+
+        string line, format;
+        vector<PlyElement> elements;
+        if (!reader.ReadLine(line) || line != "ply")
+        {
+            logger::error("Invalid PLY File!");
+            return false;
+        }
+        while (reader.ReadLine(line) && line != "end_header")
+        {
+            std::istringstream words(line);
+            string word;
+            words >> word;
+            if (word == "format")
+                words >> format;
+            else if (word == "element")
+            {
+                elements.emplace_back();
+                words >> elements.back().name >> elements.back().count;
+            }
+            else if (word == "property" && !elements.empty())
+            {
+                PlyProperty prop;
+                string type, count_type, item_type;
+                words >> type;
+                char count_kind;
+                bool ok = type == "list" ? (words >> count_type >> item_type && PlyType(count_type, prop.count_size, count_kind) &&
+                                            PlyType(item_type, prop.size, prop.type))
+                                         : PlyType(type, prop.size, prop.type);
+                words >> prop.name;
+                if (!ok)
+                {
+                    logger::error("Unsupported PLY Property: {}", line);
+                    return false;
+                }
+                elements.back().properties.push_back(prop);
+            }
+        }
+        if (format != "ascii" && format != "binary_little_endian" && format != "binary_big_endian")
+        {
+            logger::error("Unsupported PLY Format: {}", format);
+            return false;
+        }
+        const bool ascii = format == "ascii";
+        PlyValueReader values(reader, ascii, format == "binary_big_endian");
+
+        // every row takes at least its scalars and list counts (a digit and a separator each in ASCII), so counts
+        // the rest of the file cannot hold are rejected before anything is allocated for them
+        uintmax_t remaining = size - std::min<uintmax_t>(size, reader.Tell()) + (ascii ? 1 : 0);
+        for (const PlyElement &element : elements)
+        {
+            uintmax_t row = 0;
+            for (const PlyProperty &prop : element.properties)
+                row += ascii ? 2 : prop.count_size > 0 ? prop.count_size : prop.size;
+            if (row == 0 ? element.count > 0 : element.count > remaining / row)
+            {
+                logger::error("Invalid PLY File!");
+                return false;
+            }
+            remaining -= element.count * row;
+        }
+
+        double value;
+        for (const PlyElement &element : elements)
+        {
+            const bool vertex = element.name == "vertex", face = element.name == "face";
+            int xyz[3] = {-1, -1, -1}, indices = -1;
+            for (int i = 0; i < (int)element.properties.size(); i++)
+            {
+                const string &name = element.properties[i].name;
+                if (name == "x" || name == "y" || name == "z")
+                    xyz[name[0] - 'x'] = i;
+                else if (name == "vertex_indices" || name == "vertex_index")
+                    indices = i;
+            }
+            if ((vertex && (xyz[0] < 0 || xyz[1] < 0 || xyz[2] < 0)) || (face && indices < 0))
+            {
+                logger::error("Invalid PLY File!");
+                return false;
+            }
+            if (vertex)
+                mesh.points.resize(element.count);
+            if (face)
+                mesh.triangles.reserve(element.count);
+
+            vector<int> polygon;
+            for (size_t r = 0; r < element.count; r++)
+                for (int i = 0; i < (int)element.properties.size(); i++)
+                {
+                    const PlyProperty &prop = element.properties[i];
+                    size_t n = 1;
+                    if (prop.count_size > 0)
+                    {
+                        if (!values.Next(prop.count_size, 'u', value) || value < 0)
+                        {
+                            logger::error("Invalid PLY File!");
+                            return false;
+                        }
+                        n = (size_t)value;
+                    }
+                    if (face && i == indices)
+                        polygon.clear();
+                    for (size_t j = 0; j < n; j++)
+                    {
+                        if (!values.Next(prop.size, prop.type, value))
+                        {
+                            logger::error("Invalid PLY File!");
+                            return false;
+                        }
+                        if (vertex && (i == xyz[0] || i == xyz[1] || i == xyz[2]))
+                            mesh.points[r][i == xyz[0] ? 0 : i == xyz[1] ? 1 : 2] = value;
+                        else if (face && i == indices) // checked against the points once all elements are read
+                            polygon.push_back(value >= 0 && value < (double)std::numeric_limits<int>::max() ? (int)value : -1);
+                    }
+                    if (face && i == indices)
+                        for (int j = 1; j + 1 < (int)polygon.size(); j++)
+                            mesh.triangles.push_back({polygon[0], polygon[j], polygon[j + 1]});
+                }
+        }
+
+        for (const vec3i &t : mesh.triangles)
+            for (int k = 0; k < 3; k++)
+                if (t[k] < 0 || t[k] >= (int)mesh.points.size())
+                {
+                    logger::error("Invalid PLY File!");
+                    return false;
+                }
+        FinishLoad(mesh);
+        return true;
+    }
+
+    bool LoadMesh(const string &fileName, Model &mesh)
+    {
+        string ext = std::filesystem::path(fileName).extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)tolower(c); });
+        if (ext == ".obj")
+            return mesh.LoadOBJ(fileName);
+        if (ext == ".stl")
+            return LoadSTL(fileName, mesh);
+        if (ext == ".ply")
+            return LoadPLY(fileName, mesh);
+        logger::error("Unsupported Input Format: {}", ext);
+        return false;
+    }
 }
\ No newline at end of file
@@ -31,8 +31,14 @@ namespace coacd
     //////////////// IO ////////////////
     void SaveMesh(const string &filename, Model &mesh);
     void SaveConfig(Params params);
-    void SaveOBJ(const string &filename, vector<Model> parts, Params &params);
-    void SaveOBJs(const string &foldername, const string &filename, vector<Model> parts, Params &params);
-    bool WriteVRML(ofstream &fout, Model mesh);
+    void SaveOBJ(const string &filename, const vector<Model> &parts, Params &params);
+    void SaveOBJs(const string &foldername, const string &filename, const vector<Model> &parts, Params &params);
+    bool WriteVRML(ofstream &fout, const Model &mesh);
     void SaveVRML(const string &fileName, vector<Model>& meshes, Params &params);
+
+    // Readers for the other input formats. STL vertices are welded by exact position; PLY may be ASCII or binary.
+    bool LoadSTL(const string &fileName, Model &mesh);
+    bool LoadPLY(const string &fileName, Model &mesh);
+    // Loads .obj, .stl or .ply by the (case-insensitive) extension of the file
+    bool LoadMesh(const string &fileName, Model &mesh);
 }
@@ -4,14 +4,14 @@
 
 namespace coacd
 {
-    Part::Part(Params _params, Model mesh)
+    Part::Part(Params _params, MeshHandle mesh)
     {
         params = _params;
-        current_mesh = mesh;
+        current_mesh = std::move(mesh);
         next_choice = 0;
-        ComputeAxesAlignedClippingPlanes(mesh, params.mcts_nodes, available_moves, true);
+        ComputeAxesAlignedClippingPlanes(*current_mesh, params.mcts_nodes, available_moves, true);
     }
-    Part Part::operator=(const Part &_part)
+    Part &Part::operator=(const Part &_part)
     {
         params = _part.params;
         current_mesh = _part.current_mesh;
@@ -41,7 +41,7 @@ namespace coacd
         current_round = 0;
         worst_part_idx = 0;
     }
-    State::State(Params _params, Model &_initial_part)
+    State::State(Params _params, const MeshHandle &_initial_part)
     {
         params = _params;
         terminal_threshold = params.threshold;
@@ -51,15 +51,13 @@ namespace coacd
         Part p(params, _initial_part);
         current_costs.push_back(INF); // costs for every part
         current_parts.push_back(p);
-        initial_part = _initial_part;
-        ori_mesh_area = MeshArea(initial_part);
-        ori_mesh_volume = MeshVolume(initial_part);
-        Model ch;
-        initial_part.ComputeAPX(ch);
-        ori_meshCH_volume = MeshVolume(ch);
+        initial_part = _initial_part; // every state of a search shares one mesh, and with it the cached area, volume and hull
+        ori_mesh_area = initial_part->GetArea();
+        ori_mesh_volume = initial_part->GetVolume();
+        ori_meshCH_volume = initial_part->GetHullVolume();
         current_cost = 0; // accumulated score
     }
-    State::State(Params _params, vector<double> &_current_costs, vector<Part> &_current_parts, Model &_initial_part)
+    State::State(Params _params, vector<double> &_current_costs, vector<Part> &_current_parts, const MeshHandle &_initial_part)
     {
         params = _params;
         terminal_threshold = params.threshold;
@@ -68,15 +66,13 @@ namespace coacd
         current_costs = _current_costs;
         current_parts = _current_parts;
         worst_part_idx = 0;
-        initial_part = _initial_part;
-        ori_mesh_area = MeshArea(initial_part);
-        ori_mesh_volume = MeshVolume(initial_part);
-        Model ch;
-        initial_part.ComputeAPX(ch);
-        ori_meshCH_volume = MeshVolume(ch);
+        initial_part = _initial_part; // every state of a search shares one mesh, and with it the cached area, volume and hull
+        ori_mesh_area = initial_part->GetArea();
+        ori_mesh_volume = initial_part->GetVolume();
+        ori_meshCH_volume = initial_part->GetHullVolume();
         current_cost = 0;
     }
-    State State::operator=(const State &_state)
+    State &State::operator=(const State &_state)
     {
         params = _state.params;
         terminal_threshold = _state.terminal_threshold;
@@ -132,7 +128,7 @@ namespace coacd
         Plane cutting_plane = one_move(worst_part_idx);
         Model pos, neg, posCH, negCH;
         double cut_area;
-        bool flag = Clip(current_parts[worst_part_idx].current_mesh, pos, neg, cutting_plane, cut_area);
+        bool flag = Clip(*current_parts[worst_part_idx].current_mesh, pos, neg, cutting_plane, cut_area);
         if (!flag)
         {
             State next_state(params, current_costs, current_parts, initial_part);
@@ -157,8 +153,8 @@ namespace coacd
             neg.ComputeAPX(negCH);
             double cost_pos = ComputeRv(pos, posCH, params.rv_k);
             double cost_neg = ComputeRv(neg, negCH, params.rv_k);
-            Part part_pos(params, pos);
-            Part part_neg(params, neg);
+            Part part_pos(params, std::move(pos));
+            Part part_neg(params, std::move(neg));
             _current_parts.push_back(part_pos);
             _current_parts.push_back(part_neg);
             _current_costs.push_back(cost_pos);
@@ -191,7 +187,7 @@ namespace coacd
         if (state != NULL)
             delete state;
     }
-    Node Node::operator=(const Node &_node)
+    Node &Node::operator=(const Node &_node)
     {
         params = _node.params;
         children = _node.children;
@@ -202,7 +198,7 @@ namespace coacd
 
         return (*this);
     }
-    void Node::set_state(State _state)
+    void Node::set_state(const State &_state)
     {
         state = new State(params);
         *state = _state;
@@ -259,33 +255,27 @@ namespace coacd
         children.push_back(sub_node);
     }
 
-    bool clip_by_path(Model &m, double &final_cost, Params &params, Plane &first_plane, vector<Plane> &best_path)
+    // Cost of a first cut into pos and neg followed by the rest of best_path on the worst part; pos and neg are moved from
+    static bool cost_by_path(Model &pos, Model &neg, double &final_cost, Params &params, vector<Plane> &best_path)
     {
+        // the scores of the pieces live in the scratch arena; the pieces themselves are Models
+        ArenaScope scratch;
         int worst_idx = 0;
-        vector<double> scores;
+        ScratchVector<double> scores(scratch.resource());
         vector<Model> parts;
         bool flag;
         double tmp;
         double max_cost;
 
-        Model ch;
-        m.ComputeAPX(ch);
-
-        Model pos, neg, posCH, negCH;
-        flag = Clip(m, pos, neg, first_plane, tmp);
-        if (!flag)
-        {
-            final_cost = INF;
-            return false;
-        }
+        Model posCH, negCH;
         pos.ComputeAPX(posCH);
         neg.ComputeAPX(negCH);
         double pos_cost = ComputeRv(pos, posCH, params.rv_k);
         double neg_cost = ComputeRv(neg, negCH, params.rv_k);
         scores.push_back(pos_cost);
         scores.push_back(neg_cost);
-        parts.push_back(pos);
-        parts.push_back(neg);
+        parts.push_back(std::move(pos));
+        parts.push_back(std::move(neg));
 
         if (pos_cost > neg_cost)
             worst_idx = 0;
@@ -308,25 +298,25 @@ namespace coacd
             double _pos_cost = ComputeRv(_pos, _posCH, params.rv_k);
             double _neg_cost = ComputeRv(_neg, _negCH, params.rv_k);
 
-            vector<double> _scores;
+            ScratchVector<double> _scores(scratch.resource());
             vector<Model> _parts;
             for (int j = 0; j < (int)parts.size(); j++)
             {
                 if (j != worst_idx)
                 {
                     _scores.push_back(scores[j]);
-                    _parts.push_back(parts[j]);
+                    _parts.push_back(std::move(parts[j]));
                 }
             }
             scores = _scores;
-            parts = _parts;
+            parts = std::move(_parts);
             _scores.clear();
             _parts.clear();
 
             scores.push_back(_pos_cost);
             scores.push_back(_neg_cost);
-            parts.push_back(_pos);
-            parts.push_back(_neg);
+            parts.push_back(std::move(_pos));
+            parts.push_back(std::move(_neg));
 
             max_cost = scores[0];
             worst_idx = 0;
@@ -344,9 +334,34 @@ namespace coacd
         return true;
     }
 
-    bool TernaryMCTS(Model &m, Params &params, Plane &bestplane, vector<Plane> &best_path, double best_cost, bool mode, double epsilon)
+    bool clip_by_path(const Model &m, double &final_cost, Params &params, Plane &first_plane, vector<Plane> &best_path)
     {
-        double *bbox = m.GetBBox();
+        Model pos, neg;
+        double tmp;
+        if (!Clip(m, pos, neg, first_plane, tmp))
+        {
+            final_cost = INF;
+            return false;
+        }
+        return cost_by_path(pos, neg, final_cost, params, best_path);
+    }
+
+    void clip_by_paths(const Model &m, vector<double> &final_costs, Params &params, vector<Plane> &first_planes, vector<Plane> &best_path)
+    {
+        final_costs.assign(first_planes.size(), INF);
+        bool shared = ClipSlabs(m, first_planes, [&](int k, Model &pos, Model &neg, double cut_area, bool flag)
+                                {
+                                    if (flag)
+                                        cost_by_path(pos, neg, final_costs[k], params, best_path);
+                                });
+        if (!shared)
+            for (int k = 0; k < (int)first_planes.size(); k++)
+                clip_by_path(m, final_costs[k], params, first_planes[k], best_path);
+    }
+
+    bool TernaryMCTS(const Model &m, Params &params, Plane &bestplane, vector<Plane> &best_path, double best_cost, bool mode, double epsilon)
+    {
+        const double *bbox = m.GetBBox();
         double interval;
         double minItv = 0.01;
         size_t thres = 10;
@@ -381,11 +396,10 @@ namespace coacd
                 double m2 = m1 + margin;
                 Plane p1 = Plane(1.0, 0.0, 0.0, -m1), p2 = Plane(1.0, 0.0, 0.0, -m2);
 
-                double E1;
-                flag = clip_by_path(m, E1, params, p1, best_path);
-
-                double E2;
-                flag = clip_by_path(m, E2, params, p2, best_path);
+                vector<Plane> probes = {p1, p2};
+                vector<double> E;
+                clip_by_paths(m, E, params, probes, best_path);
+                double E1 = E[0], E2 = E[1];
 
                 if (E1 < E2)
                 {
@@ -439,11 +453,10 @@ namespace coacd
                 double m2 = m1 + margin;
                 Plane p1 = Plane(0.0, 1.0, 0.0, -m1), p2 = Plane(0.0, 1.0, 0.0, -m2);
 
-                double E1;
-                flag = clip_by_path(m, E1, params, p1, best_path);
-
-                double E2;
-                flag = clip_by_path(m, E2, params, p2, best_path);
+                vector<Plane> probes = {p1, p2};
+                vector<double> E;
+                clip_by_paths(m, E, params, probes, best_path);
+                double E1 = E[0], E2 = E[1];
                 if (E1 < E2)
                 {
                     right = m2;
@@ -496,11 +509,10 @@ namespace coacd
                 double m2 = m1 + margin;
                 Plane p1 = Plane(0.0, 0.0, 1.0, -m1), p2 = Plane(0.0, 0.0, 1.0, -m2);
 
-                double E1;
-                flag = clip_by_path(m, E1, params, p1, best_path);
-
-                double E2;
-                flag = clip_by_path(m, E2, params, p2, best_path);
+                vector<Plane> probes = {p1, p2};
+                vector<double> E;
+                clip_by_paths(m, E, params, probes, best_path);
+                double E1 = E[0], E2 = E[1];
                 if (E1 < E2)
                 {
                     right = m2;
@@ -536,12 +548,11 @@ namespace coacd
 
         return true;
     }
-    void RefineMCTS(Model &m, Params &params, Plane &bestplane, vector<Plane> &best_path, double best_cost, double epsilon)
+    void RefineMCTS(const Model &m, Params &params, Plane &bestplane, vector<Plane> &best_path, double best_cost, double epsilon)
     {
-        double *bbox = m.GetBBox();
+        const double *bbox = m.GetBBox();
         double downsample;
         double interval = 0.01;
-        bool flag;
         if (fabs(bestplane.a - 1.0) < 1e-4)
         {
             double left, right;
@@ -549,16 +560,19 @@ namespace coacd
             left = max(bbox[0] + interval, -1.0 * bestplane.d - downsample);
             right = min(bbox[1] - interval, -1.0 * bestplane.d + downsample);
 
-            double min_cost = INF;
+            vector<Plane> candidates;
             for (double i = left; i <= right; i += interval)
+                candidates.push_back(Plane(1.0, 0.0, 0.0, -i));
+            vector<double> E;
+            clip_by_paths(m, E, params, candidates, best_path);
+
+            double min_cost = INF;
+            for (int k = 0; k < (int)candidates.size(); k++)
             {
-                double E;
-                Plane pl = Plane(1.0, 0.0, 0.0, -i);
-                flag = clip_by_path(m, E, params, pl, best_path);
-                if (E < best_cost && E < min_cost)
+                if (E[k] < best_cost && E[k] < min_cost)
                 {
-                    min_cost = E;
-                    bestplane = pl;
+                    min_cost = E[k];
+                    bestplane = candidates[k];
                 }
             }
         }
@@ -569,16 +583,19 @@ namespace coacd
             left = max(bbox[2] + interval, -1.0 * bestplane.d - downsample);
             right = min(bbox[3] - interval, -1.0 * bestplane.d + downsample);
 
-            double min_cost = INF;
+            vector<Plane> candidates;
             for (double i = left; i <= right; i += interval)
+                candidates.push_back(Plane(0.0, 1.0, 0.0, -i));
+            vector<double> E;
+            clip_by_paths(m, E, params, candidates, best_path);
+
+            double min_cost = INF;
+            for (int k = 0; k < (int)candidates.size(); k++)
             {
-                double E;
-                Plane pl = Plane(0.0, 1.0, 0.0, -i);
-                flag = clip_by_path(m, E, params, pl, best_path);
-                if (E < best_cost && E < min_cost)
+                if (E[k] < best_cost && E[k] < min_cost)
                 {
-                    min_cost = E;
-                    bestplane = pl;
+                    min_cost = E[k];
+                    bestplane = candidates[k];
                 }
             }
         }
@@ -589,16 +606,19 @@ namespace coacd
             left = max(bbox[4] + interval, -1.0 * bestplane.d - downsample);
             right = min(bbox[5] - interval, -1.0 * bestplane.d + downsample);
 
-            double min_cost = INF;
+            vector<Plane> candidates;
             for (double i = left; i <= right; i += interval)
+                candidates.push_back(Plane(0.0, 0.0, 1.0, -i));
+            vector<double> E;
+            clip_by_paths(m, E, params, candidates, best_path);
+
+            double min_cost = INF;
+            for (int k = 0; k < (int)candidates.size(); k++)
             {
-                double E;
-                Plane pl = Plane(0.0, 0.0, 1.0, -i);
-                flag = clip_by_path(m, E, params, pl, best_path);
-                if (E < best_cost && E < min_cost)
+                if (E[k] < best_cost && E[k] < min_cost)
                 {
-                    min_cost = E;
-                    bestplane = pl;
+                    min_cost = E[k];
+                    bestplane = candidates[k];
                 }
             }
         }
@@ -606,9 +626,9 @@ namespace coacd
             throw runtime_error("RefineMCTS Error!");
     }
 
-    void ComputeAxesAlignedClippingPlanes(Model &m, const int mcts_nodes, vector<Plane> &planes, bool shuffle)
+    void ComputeAxesAlignedClippingPlanes(const Model &m, const int mcts_nodes, vector<Plane> &planes, bool shuffle)
     {
-        double *bbox = m.GetBBox();
+        const double *bbox = m.GetBBox();
         double interval;
         double eps = 1e-6;
         interval = max(0.01, abs(bbox[0] - bbox[1]) / ((double)mcts_nodes + 1));
@@ -633,37 +653,38 @@ namespace coacd
         }
     }
 
-    bool ComputeBestRvClippingPlane(Model &m, Params &params, vector<Plane> &planes, Plane &bestplane, double &bestcost)
+    bool ComputeBestRvClippingPlane(const Model &m, Params &params, vector<Plane> &planes, Plane &bestplane, double &bestcost)
     {
         if ((int)planes.size() == 0)
             return false;
         double H_min = INF;
-        double cut_area;
-        bool flag;
-        for (int i = 0; i < (int)planes.size(); i++)
+        vector<double> H(planes.size(), INF);
+        // the planes come in runs along one axis, and each run is clipped in one sweep
+        for (int first = 0, last; first < (int)planes.size(); first = last)
         {
-            Model pos, neg, posCH, negCH;
-
-            flag = Clip(m, pos, neg, planes[i], cut_area);
-            double H;
-            if (!flag)
-                H = INF;
-            else
-            {
-                if (pos.points.size() <= 0 || neg.points.size() <= 0)
-                    continue;
-
-                pos.ComputeAPX(posCH);
-                neg.ComputeAPX(negCH);
-
-                H = ComputeTotalRv(m, pos, posCH, neg, negCH, params.rv_k, planes[i]);
-            }
+            for (last = first + 1; last < (int)planes.size() && planes[last].a == planes[first].a && planes[last].b == planes[first].b &&
+                                   planes[last].c == planes[first].c;
+                 last++)
+                ;
+            vector<Plane> family(planes.begin() + first, planes.begin() + last);
+            ClipSlabs(m, family, [&](int k, Model &pos, Model &neg, double cut_area, bool flag)
+                      {
+                          if (!flag || pos.points.size() <= 0 || neg.points.size() <= 0)
+                              return;
+                          Model posCH, negCH;
+                          pos.ComputeAPX(posCH);
+                          neg.ComputeAPX(negCH);
+                          H[first + k] = ComputeTotalRv(m, pos, posCH, neg, negCH, params.rv_k, family[k]);
+                      });
+        }
 
-            if (H < H_min)
+        for (int i = 0; i < (int)planes.size(); i++)
+        {
+            if (H[i] < H_min)
             {
-                H_min = H;
+                H_min = H[i];
                 bestplane = planes[i];
-                bestcost = H;
+                bestcost = H[i];
             }
         }
 
@@ -718,15 +739,15 @@ namespace coacd
             vector<Plane> planes;
             Plane bestplane;
             double bestcost, cut_area;
-            ComputeAxesAlignedClippingPlanes(current_state.current_parts[current_state.worst_part_idx].current_mesh, MCTS_RANDOM_CUT, planes);
+            ComputeAxesAlignedClippingPlanes(*current_state.current_parts[current_state.worst_part_idx].current_mesh, MCTS_RANDOM_CUT, planes);
             if ((int)planes.size() == 0)
             {
                 break;
             }
-            ComputeBestRvClippingPlane(current_state.current_parts[current_state.worst_part_idx].current_mesh, params, planes, bestplane, bestcost);
+            ComputeBestRvClippingPlane(*current_state.current_parts[current_state.worst_part_idx].current_mesh, params, planes, bestplane, bestcost);
 
             Model pos, neg, posCH, negCH;
-            bool clipf = Clip(current_state.current_parts[current_state.worst_part_idx].current_mesh, pos, neg, bestplane, cut_area);
+            bool clipf = Clip(*current_state.current_parts[current_state.worst_part_idx].current_mesh, pos, neg, bestplane, cut_area);
             if (!clipf)
                 throw runtime_error("Wrong MCTS clip proposal!");
             current_path.push_back(bestplane);
@@ -745,8 +766,8 @@ namespace coacd
             double cost_pos = ComputeRv(pos, posCH, params.rv_k);
             double cost_neg = ComputeRv(neg, negCH, params.rv_k);
 
-            Part part_pos(params, pos);
-            Part part_neg(params, neg);
+            Part part_pos(params, std::move(pos));
+            Part part_neg(params, std::move(neg));
             _current_parts.push_back(part_pos);
             _current_parts.push_back(part_neg);
             _current_costs.push_back(cost_pos);
@@ -848,9 +869,8 @@ namespace coacd
     Node *MonteCarloTreeSearch(Params &params, Node *node, vector<Plane> &best_path)
     {
         int computation_budget = params.mcts_iteration;
-        Model initial_mesh = node->get_state()->current_parts[0].current_mesh, initial_ch;
-        initial_mesh.ComputeAPX(initial_ch);
-        double cost = ComputeRv(initial_mesh, initial_ch, params.rv_k) / params.mcts_max_depth;
+        const Model &initial_mesh = *node->get_state()->current_parts[0].current_mesh;
+        double cost = ComputeRv(initial_mesh, initial_mesh.GetHull(), params.rv_k) / params.mcts_max_depth;
         vector<Plane> current_path;
 
         for (int i = 0; i < computation_budget; i++)
@@ -28,18 +28,18 @@ namespace coacd
 
   constexpr int MCTS_RANDOM_CUT = 1;
 
-  void ComputeAxesAlignedClippingPlanes(Model &m, const int mcts_nodes, vector<Plane> &planes, bool shuffle = false);
+  void ComputeAxesAlignedClippingPlanes(const Model &m, const int mcts_nodes, vector<Plane> &planes, bool shuffle = false);
 
   class Part
   {
   public:
     Params params;
-    Model current_mesh;
+    MeshHandle current_mesh;
     int next_choice;
     vector<Plane> available_moves;
 
-    Part(Params _params, Model mesh);
-    Part operator=(const Part &_part);
+    Part(Params _params, MeshHandle mesh);
+    Part &operator=(const Part &_part);
     Plane get_one_move();
   };
 
@@ -53,7 +53,7 @@ namespace coacd
     double current_cost;
     double current_score;
     int current_round;
-    Model initial_part;
+    MeshHandle initial_part;
     double ori_mesh_area;
     double ori_mesh_volume;
     double ori_meshCH_volume;
@@ -64,10 +64,10 @@ namespace coacd
 
     State();
     State(Params _params);
-    State(Params _params, Model &_initial_part);
-    State(Params _params, vector<double> &_current_costs, vector<Part> &_current_parts, Model &_initial_part);
+    State(Params _params, const MeshHandle &_initial_part);
+    State(Params _params, vector<double> &_current_costs, vector<Part> &_current_parts, const MeshHandle &_initial_part);
 
-    State operator=(const State &_state);
+    State &operator=(const State &_state);
 
     void set_current_value(pair<Plane, int> value);
     pair<Plane, int> get_current_value();
@@ -95,8 +95,8 @@ namespace coacd
 
     Node(Params _params);
     ~Node();
-    Node operator=(const Node &_node);
-    void set_state(State _state);
+    Node &operator=(const Node &_node);
+    void set_state(const State &_state);
     State *get_state();
     void set_parent(Node *_parent);
     Node *get_parent();
@@ -118,11 +118,13 @@ namespace coacd
   void backup(Node *node, double reward, vector<Plane> &current_path, vector<Plane> &best_path);
   Node *MonteCarloTreeSearch(Params &params, Node *node, vector<Plane> &best_path);
 
-  bool clip_by_path(Model &m, double &final_cost, Params &params, Plane &first_plane, vector<Plane> &best_path);
-  bool TernaryMCTS(Model &m, Params &params, Plane &bestplane, vector<Plane> &best_path, double best_cost, bool mode = 1, double epsilon = 0.0001);
-  void RefineMCTS(Model &m, Params &params, Plane &bestplane, vector<Plane> &best_path, double best_cost, double epsilon = 0.0001);
-  void ComputeAxesAlignedClippingPlanes(Model &m, const int mcts_nodes, vector<Plane> &planes, bool shuffle);
-  bool ComputeBestRvClippingPlane(Model &m, Params &params, vector<Plane> &planes, Plane &bestplane, double &bestcost);
+  bool clip_by_path(const Model &m, double &final_cost, Params &params, Plane &first_plane, vector<Plane> &best_path);
+  // clip_by_path for planes sharing one normal, clipped in one shared pass
+  void clip_by_paths(const Model &m, vector<double> &final_costs, Params &params, vector<Plane> &first_planes, vector<Plane> &best_path);
+  bool TernaryMCTS(const Model &m, Params &params, Plane &bestplane, vector<Plane> &best_path, double best_cost, bool mode = 1, double epsilon = 0.0001);
+  void RefineMCTS(const Model &m, Params &params, Plane &bestplane, vector<Plane> &best_path, double best_cost, double epsilon = 0.0001);
+  void ComputeAxesAlignedClippingPlanes(const Model &m, const int mcts_nodes, vector<Plane> &planes, bool shuffle);
+  bool ComputeBestRvClippingPlane(const Model &m, Params &params, vector<Plane> &planes, Plane &bestplane, double &bestcost);
   double ComputeReward(Params &params, double meshCH_v, vector<double> &current_costs, vector<Part> &current_parts, int &worst_part_idx, double ori_mesh_area, double ori_mesh_volume);
   void free_tree(Node *root, int idx);
 }
\ No newline at end of file
@@ -84,18 +84,18 @@ namespace coacd
 
         random_engine.seed(params.seed);
 
-        Model pmesh = mesh, pCH;
+        MeshHandle pmesh(mesh);
+        Model pCH;
         Plane bestplane;
-        pmesh.ComputeAPX(pCH, params.apx_mode, true);
-        double h = ComputeHCost(pmesh, pCH, params.rv_k, params.resolution, params.seed, 0.0001, false);
+        pmesh->ComputeAPX(pCH, params.apx_mode, true);
+        double h = ComputeHCost(*pmesh, pCH, params.rv_k, params.resolution, params.seed, 0.0001, false);
 
         vector<Plane>  best_path;
         vector<pair<Plane,double>> planes;
 
         // MCTS for cutting plane
         Node *node = new Node(params);
-        State state(params, pmesh);
-        node->set_state(state);
+        node->set_state(State(params, pmesh));
         Node *best_next_node = MonteCarloTreeSearch(params, node, best_path);
 
         vector<pair<Node *,double>> best_nodes = best_children(node, false, 0.1, num_planes);
@@ -103,7 +103,7 @@ namespace coacd
         {
             Plane next_best_plane = best_nodes[i].first->state->current_value.first;
 
-            TernaryMCTS(pmesh, params, next_best_plane, best_path, best_nodes[i].first->quality_value); // using Rv to Ternary refine
+            TernaryMCTS(*pmesh, params, next_best_plane, best_path, best_nodes[i].first->quality_value); // using Rv to Ternary refine
             planes.push_back(make_pair(next_best_plane, best_nodes[i].first->quality_value));
         }
         free_tree(node, 0);
@@ -122,7 +122,7 @@ namespace coacd
         {
             Model ch;
             parts[i].ComputeAPX(ch, params.apx_mode, true);
-            avg_concavity += ComputeHCost(parts[i], ch, params.rv_k, params.resolution, params.seed, 0.0001, false);
+            avg_concavity += ComputeHCost(parts[i], ch, params);
         }
         avg_concavity /= parts.size();
         score.avg_concavity = avg_concavity;
@@ -1,7 +1,24 @@
 #include <stdint.h>
+#include <atomic>
+#include <charconv>
+#include <mutex>
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "model_obj.h"
 #include "process.h"
-#include "quickhull/QuickHull.hpp"
+#include "hull.h"
+#if WITH_3RD_PARTY_LIBS
+#include "sdf.h"
+#endif
 #include "btConvexHull/btConvexHullComputer.h"
 #include "nanoflann.hpp"
 
@@ -10,6 +27,55 @@ using namespace nanoflann;
 namespace coacd
 {
 
+    static std::atomic<size_t> model_copies{0};
+
+    CopyCounter::CopyCounter(const CopyCounter &)
+    {
+        model_copies.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    CopyCounter &CopyCounter::operator=(const CopyCounter &)
+    {
+        model_copies.fetch_add(1, std::memory_order_relaxed);
+        return *this;
+    }
+
+    size_t GetModelCopies()
+    {
+        return model_copies.load(std::memory_order_relaxed);
+    }
+
+    void ResetModelCopies()
+    {
+        model_copies.store(0, std::memory_order_relaxed);
+    }
+
+    struct ModelCache
+    {
+        std::recursive_mutex lock; // GetSamples goes through GetArea
+        // sizes of the model the values belong to, SIZE_MAX until the first value is stored
+        size_t n_points = SIZE_MAX, n_triangles = SIZE_MAX;
+
+        bool has_measures = false;
+        double area = 0, volume = 0;
+        array<double, 6> bounds;
+
+        std::unique_ptr<Model> hull;
+
+        bool has_cloud = false;
+        PointsSoA cloud;
+
+        bool has_edges = false;
+        HalfEdges edges;
+
+        bool has_samples = false;
+        size_t sample_resolution = 0;
+        double sample_base = 0;
+        SurfaceSamples samples;
+
+        std::shared_ptr<DistanceField> field;
+    };
+
     Model::Model()
     {
         barycenter[0] = 0.0;
@@ -17,6 +83,195 @@ namespace coacd
         barycenter[2] = 0.0;
     }
 
+    CacheSlot::CacheSlot() : cache(std::make_unique<ModelCache>()) {}
+
+    CacheSlot::CacheSlot(const CacheSlot &) : cache(std::make_unique<ModelCache>()) {}
+
+    CacheSlot::CacheSlot(CacheSlot &&other) noexcept : cache(std::move(other.cache))
+    {
+        other.cache = std::make_unique<ModelCache>();
+    }
+
+    CacheSlot &CacheSlot::operator=(const CacheSlot &)
+    {
+        cache = std::make_unique<ModelCache>();
+        return *this;
+    }
+
+    CacheSlot &CacheSlot::operator=(CacheSlot &&other) noexcept
+    {
+        cache = std::move(other.cache);
+        other.cache = std::make_unique<ModelCache>();
+        return *this;
+    }
+
+    CacheSlot::~CacheSlot() = default;
+
+    Model &MeshHandle::Mutable()
+    {
+        if (mesh.use_count() > 1)
+            mesh = std::make_shared<Model>(*mesh);
+        return *mesh;
+    }
+
+    Model MeshHandle::Release()
+    {
+        Model m = mesh.use_count() > 1 ? *mesh : std::move(*mesh);
+        mesh = std::make_shared<Model>();
+        return m;
+    }
+
+    // Caller holds c.lock
+    static void Stamp(ModelCache &c, size_t n_points, size_t n_triangles)
+    {
+        if (c.n_points == n_points && c.n_triangles == n_triangles)
+            return;
+        c.has_measures = false;
+        c.hull.reset();
+        c.has_cloud = false;
+        c.cloud = PointsSoA();
+        c.has_edges = false;
+        c.edges = HalfEdges();
+        c.has_samples = false;
+        c.samples = SurfaceSamples();
+        c.field.reset();
+        c.n_triangles = n_triangles;
+        c.n_points = n_points;
+    }
+
+    void Model::Invalidate()
+    {
+        ModelCache &c = Cache();
+        std::lock_guard<std::recursive_mutex> guard(c.lock);
+        Stamp(c, SIZE_MAX, SIZE_MAX);
+    }
+
+    // Area and volume in one pass over the triangles, bounds in one pass over the points
+    static void Measure(ModelCache &c, const vector<vec3d> &points, const vector<vec3i> &triangles)
+    {
+        Stamp(c, points.size(), triangles.size());
+        if (c.has_measures)
+            return;
+        double area = 0, volume = 0;
+        for (const vec3i &t : triangles)
+        {
+            const vec3d &p0 = points[t[0]], &p1 = points[t[1]], &p2 = points[t[2]];
+            area += Area(p0, p1, p2);
+            volume += Volume(p0, p1, p2);
+        }
+        array<double, 6> bounds = {INF, -INF, INF, -INF, INF, -INF};
+        for (const vec3d &p : points)
+            for (int k = 0; k < 3; k++)
+            {
+                bounds[2 * k] = min(bounds[2 * k], p[k]);
+                bounds[2 * k + 1] = max(bounds[2 * k + 1], p[k]);
+            }
+        c.area = area;
+        c.volume = volume;
+        c.bounds = bounds;
+        c.has_measures = true;
+    }
+
+    double Model::GetVolume() const
+    {
+        ModelCache &c = Cache();
+        std::lock_guard<std::recursive_mutex> guard(c.lock);
+        Measure(c, points, triangles);
+        return c.volume;
+    }
+
+    double Model::GetArea() const
+    {
+        ModelCache &c = Cache();
+        std::lock_guard<std::recursive_mutex> guard(c.lock);
+        Measure(c, points, triangles);
+        return c.area;
+    }
+
+    const array<double, 6> &Model::GetBounds() const
+    {
+        ModelCache &c = Cache();
+        std::lock_guard<std::recursive_mutex> guard(c.lock);
+        Measure(c, points, triangles);
+        return c.bounds;
+    }
+
+    const Model &Model::GetHull() const
+    {
+        ModelCache &c = Cache();
+        std::lock_guard<std::recursive_mutex> guard(c.lock);
+        Stamp(c, points.size(), triangles.size());
+        if (!c.hull)
+        {
+            c.hull = std::make_unique<Model>();
+            ComputeAPX(*c.hull);
+        }
+        return *c.hull;
+    }
+
+    double Model::GetHullVolume() const
+    {
+        ModelCache &c = Cache();
+        std::lock_guard<std::recursive_mutex> guard(c.lock);
+        GetHull();
+        return c.hull->GetVolume();
+    }
+
+    const PointsSoA &Model::GetPointCloud() const
+    {
+        ModelCache &c = Cache();
+        std::lock_guard<std::recursive_mutex> guard(c.lock);
+        Stamp(c, points.size(), triangles.size());
+        if (!c.has_cloud)
+        {
+            c.cloud.assign(points);
+            c.has_cloud = true;
+        }
+        return c.cloud;
+    }
+
+    const HalfEdges &Model::GetHalfEdges() const
+    {
+        ModelCache &c = Cache();
+        std::lock_guard<std::recursive_mutex> guard(c.lock);
+        Stamp(c, points.size(), triangles.size());
+        if (!c.has_edges)
+        {
+            c.edges.Build(triangles);
+            c.has_edges = true;
+        }
+        return c.edges;
+    }
+
+    const SurfaceSamples &Model::GetSamples(size_t resolution, double base) const
+    {
+        ModelCache &c = Cache();
+        std::lock_guard<std::recursive_mutex> guard(c.lock);
+        Stamp(c, points.size(), triangles.size());
+        if (!c.has_samples || c.sample_resolution != resolution || c.sample_base != base)
+        {
+            c.samples = SurfaceSamples();
+            ExtractPointSet(c.samples.points, c.samples.tri_ids, 1235, resolution, base);
+            c.samples.cloud.assign(c.samples.points);
+            c.sample_resolution = resolution;
+            c.sample_base = base;
+            c.has_samples = true;
+        }
+        return c.samples;
+    }
+
+#if WITH_3RD_PARTY_LIBS
+    const DistanceField &Model::GetDistanceField(double voxel_size, double band) const
+    {
+        ModelCache &c = Cache();
+        std::lock_guard<std::recursive_mutex> guard(c.lock);
+        Stamp(c, points.size(), triangles.size());
+        if (!c.field || c.field->voxel_size != voxel_size || c.field->band != band)
+            c.field = std::make_shared<DistanceField>(*this, voxel_size, band);
+        return *c.field;
+    }
+#endif
+
     bool Model::CheckThin()
     {
         int idx0 = 0;
@@ -101,21 +356,20 @@ namespace coacd
         }
     }
 
-    void Model::ComputeAPX(Model &convex, string apx_mode, bool if_vch)
+    void Model::ComputeAPX(Model &convex, string apx_mode, bool if_vch) const
     {
         // clean convex points and triangles
         convex.points.clear();
         convex.triangles.clear();
+        convex.Invalidate();
 
         if (apx_mode == "box")
             ComputeBOX(convex);
-        else if (apx_mode == "ch" and !if_vch)
-            ComputeCH(convex);
         else
-            ComputeVCH(convex);
+            ComputeCH(convex, if_vch); // the robust hull serves both the fast and the stable (if_vch) paths
     }
 
-    void Model::ComputeBOX(Model &convex)
+    void Model::ComputeBOX(Model &convex) const
     {
         // compute the box mesh according to the bounding box of the points
         convex.points.push_back({bbox[1], bbox[2], bbox[5]});
@@ -141,44 +395,39 @@ namespace coacd
         convex.triangles.push_back({3, 7, 4});
     }
 
-    void Model::ComputeCH(Model &convex, bool if_vch)
+    void Model::ComputeCH(Model &convex, bool if_vch) const
     {
-        /* fast convex hull algorithm */
-        bool flag = true;
-        quickhull::QuickHull<float> qh; // Could be double as well
-        vector<quickhull::Vector3<float>> pointCloud;
-        // Add points to point cloud
-        for (int i = 0; i < (int)points.size(); i++)
-        {
-            pointCloud.push_back(quickhull::Vector3<float>(points[i][0], points[i][1], points[i][2]));
-        }
+        ComputeCH(convex.points, convex.triangles, if_vch);
+        convex.Invalidate();
+    }
 
-        auto hull = qh.getConvexHull(pointCloud, true, false, flag);
-        if (!flag)
-        {
-            // backup convex hull algorithm, stable but slow
-            ComputeVCH(convex);
-            return;
-        }
-        const auto &indexBuffer = hull.getIndexBuffer();
-        const auto &vertexBuffer = hull.getVertexBuffer();
-        for (int i = 0; i < (int)vertexBuffer.size(); i++)
-        {
-            convex.points.push_back({vertexBuffer[i].x, vertexBuffer[i].y, vertexBuffer[i].z});
-        }
-        for (int i = 0; i < (int)indexBuffer.size(); i += 3)
+    void Model::ComputeCH(vector<vec3d> &hull_points, vector<vec3i> &hull_triangles, bool if_vch) const
+    {
+        /* fast convex hull algorithm, exact orientation tests in double precision */
+        // the fast path only feeds costs: it leaves out points within 1e-9 of the hull, which are mostly the
+        // near-coplanar vertices of cut caps and would otherwise double the hull size; the stable path is exact
+        if (!ComputeHull(points, hull_points, hull_triangles, -1, if_vch ? 0 : 1e-9))
         {
-            convex.triangles.push_back({(int)indexBuffer[i + 2], (int)indexBuffer[i + 1], (int)indexBuffer[i]});
+            // flat or degenerate point sets have no solid hull, let Bullet produce its flat one
+            ComputeVCH(hull_points, hull_triangles);
         }
     }
 
-    void Model::ComputeVCH(Model &convex)
+    void Model::ComputeVCH(Model &convex) const
+    {
+        ComputeVCH(convex.points, convex.triangles);
+        convex.Invalidate();
+    }
+
+    void Model::ComputeVCH(vector<vec3d> &hull_points, vector<vec3i> &hull_triangles) const
     {
+        hull_points.clear();
+        hull_triangles.clear();
         btConvexHullComputer ch;
         ch.compute(points, -1.0, -1.0);
         for (int32_t v = 0; v < ch.vertices.size(); v++)
         {
-            convex.points.push_back({ch.vertices[v].getX(), ch.vertices[v].getY(), ch.vertices[v].getZ()});
+            hull_points.push_back({ch.vertices[v].getX(), ch.vertices[v].getY(), ch.vertices[v].getZ()});
         }
         const int32_t nt = ch.faces.size();
         for (int32_t t = 0; t < nt; ++t)
@@ -190,7 +439,7 @@ namespace coacd
             int32_t c = edge->getTargetVertex();
             while (c != a)
             {
-                convex.triangles.push_back({(int)a, (int)b, (int)c});
+                hull_triangles.push_back({(int)a, (int)b, (int)c});
                 edge = edge->getNextEdgeOfFace();
                 b = c;
                 c = edge->getTargetVertex();
@@ -277,15 +526,7 @@ namespace coacd
         Diagonalize(covMat, m_rot, D);
     }
 
-    inline void addEdge(map<pair<int, int>, bool> &edge_map, int id1, int id2)
-    {
-        pair<int, int> edge1 = make_pair(id1, id2);
-        pair<int, int> edge2 = make_pair(id2, id1);
-        if (edge_map.find(edge1) == edge_map.end() && edge_map.find(edge2) == edge_map.end())
-            edge_map[edge1] = true;
-    }
-
-    bool ComputeOverlapFace(Model &convex1, Model &convex2, Plane &plane)
+    bool ComputeOverlapFace(const Model &convex1, const Model &convex2, Plane &plane)
     {
         bool flag;
         for (int i = 0; i < (int)convex1.triangles.size(); i++)
@@ -343,15 +584,11 @@ namespace coacd
         os.close();
     }
 
-    void Model::ExtractPointSet(vector<vec3d> &samples, vector<int> &sample_tri_ids, unsigned int seed, size_t resolution, double base, bool flag, Plane plane)
+    void Model::ExtractPointSet(vector<vec3d> &samples, vector<int> &sample_tri_ids, unsigned int seed, size_t resolution, double base, bool flag, Plane plane) const
     {
         if (resolution == 0)
             return;
-        double aObj = 0;
-        for (int i = 0; i < (int)triangles.size(); i++)
-        {
-            aObj += Area(points[triangles[i][0]], points[triangles[i][1]], points[triangles[i][2]]);
-        }
+        double aObj = GetArea();
 
         if (base != 0)
             resolution = size_t(max(1000, int(resolution * (aObj / base))));
@@ -402,52 +639,30 @@ namespace coacd
         }
     }
 
-    void ExtractPointSet(Model convex1, Model convex2, unsigned int seed, vector<vec3d> &samples, size_t resolution)
+    void ExtractPointSet(const Model &convex1, const Model &convex2, unsigned int seed, vector<vec3d> &samples, size_t resolution)
     {
-        vector<vec3d> XA, XB;
-        double a1 = 0, a2 = 0;
-        for (int i = 0; i < (int)convex1.triangles.size(); i++)
-            a1 += Area(convex1.points[convex1.triangles[i][0]], convex1.points[convex1.triangles[i][1]], convex1.points[convex1.triangles[i][2]]);
-        for (int i = 0; i < (int)convex2.triangles.size(); i++)
-            a2 += Area(convex2.points[convex2.triangles[i][0]], convex2.points[convex2.triangles[i][1]], convex2.points[convex2.triangles[i][2]]);
-
-        Plane overlap_plane;
-        bool flag = ComputeOverlapFace(convex1, convex2, overlap_plane);
-
-        vector<int> tmp1, tmp2;
-        convex1.ExtractPointSet(XA, tmp1, seed, size_t(a1 / (a1 + a2) * resolution), 1, flag, overlap_plane);
-        convex2.ExtractPointSet(XB, tmp2, seed, size_t(a2 / (a1 + a2) * resolution), 1, flag, overlap_plane);
-
-        samples.insert(samples.end(), XA.begin(), XA.end());
-        samples.insert(samples.end(), XB.begin(), XB.end());
+        vector<int> sample_tri_ids;
+        ExtractPointSet(convex1, convex2, samples, sample_tri_ids, seed, resolution);
     }
 
-    void ExtractPointSet(Model &convex1, Model &convex2, vector<vec3d> &samples, vector<int> &sample_tri_ids, unsigned int seed, size_t resolution)
+    // Both hulls sample straight into the output; the second one's triangle ids are shifted past the first's
+    void ExtractPointSet(const Model &convex1, const Model &convex2, vector<vec3d> &samples, vector<int> &sample_tri_ids, unsigned int seed, size_t resolution)
     {
-        vector<vec3d> samples1, samples2;
-        vector<int> sample_tri_ids1, sample_tri_ids2;
-        double a1 = 0, a2 = 0;
-        for (int i = 0; i < (int)convex1.triangles.size(); i++)
-            a1 += Area(convex1.points[convex1.triangles[i][0]], convex1.points[convex1.triangles[i][1]], convex1.points[convex1.triangles[i][2]]);
-        for (int i = 0; i < (int)convex2.triangles.size(); i++)
-            a2 += Area(convex2.points[convex2.triangles[i][0]], convex2.points[convex2.triangles[i][1]], convex2.points[convex2.triangles[i][2]]);
+        double a1 = convex1.GetArea(), a2 = convex2.GetArea();
 
         Plane overlap_plane;
         bool flag = ComputeOverlapFace(convex1, convex2, overlap_plane);
 
-        convex1.ExtractPointSet(samples1, sample_tri_ids1, seed, size_t(a1 / (a1 + a2) * resolution), 1, flag, overlap_plane);
-        convex2.ExtractPointSet(samples2, sample_tri_ids2, seed, size_t(a2 / (a1 + a2) * resolution), 1, flag, overlap_plane);
-
-        samples.insert(samples.end(), samples1.begin(), samples1.end());
-        samples.insert(samples.end(), samples2.begin(), samples2.end());
+        convex1.ExtractPointSet(samples, sample_tri_ids, seed, size_t(a1 / (a1 + a2) * resolution), 1, flag, overlap_plane);
+        size_t first = sample_tri_ids.size();
+        convex2.ExtractPointSet(samples, sample_tri_ids, seed, size_t(a2 / (a1 + a2) * resolution), 1, flag, overlap_plane);
 
-        sample_tri_ids.insert(sample_tri_ids.end(), sample_tri_ids1.begin(), sample_tri_ids1.end());
         int N = (int)convex1.triangles.size();
-        for (int i = 0; i < (int)sample_tri_ids2.size(); i++)
-            sample_tri_ids.push_back(sample_tri_ids2[i] + N);
+        for (size_t i = first; i < sample_tri_ids.size(); i++)
+            sample_tri_ids[i] += N;
     }
 
-    void MergeMesh(Model &mesh1, Model &mesh2, Model &merge)
+    void MergeMesh(const Model &mesh1, const Model &mesh2, Model &merge)
     {
         merge.points.insert(merge.points.end(), mesh1.points.begin(), mesh1.points.end());
         merge.points.insert(merge.points.end(), mesh2.points.begin(), mesh2.points.end());
@@ -455,101 +670,236 @@ namespace coacd
         int N = mesh1.points.size();
         for (int i = 0; i < (int)mesh2.triangles.size(); i++)
             merge.triangles.push_back({mesh2.triangles[i][0] + N, mesh2.triangles[i][1] + N, mesh2.triangles[i][2] + N});
+        merge.Invalidate();
     }
 
     /////////// IO /////////////
 
-    bool Model::LoadOBJ(const string &fileName)
+    // Read-only view of a whole file, memory-mapped where the platform allows and read into memory otherwise
+    class MappedFile
     {
-        const unsigned int BufferSize = 1024;
-        FILE *fid = fopen(fileName.c_str(), "r");
-
-        if (fid)
+    public:
+        explicit MappedFile(const string &fileName)
         {
-            char buffer[BufferSize];
-            int ip[4];
-            double x[3];
-            char *pch;
-            char *str;
-            double x_min = INF, x_max = -INF, y_min = INF, y_max = -INF, z_min = INF, z_max = -INF;
-            while (!feof(fid))
+#ifdef _WIN32
+            std::ifstream is(fileName, std::ios::binary | std::ios::ate);
+            if (!is)
+                return;
+            buffer.resize((size_t)is.tellg());
+            is.seekg(0);
+            if (!is.read(buffer.data(), buffer.size()))
+                return;
+            data = buffer.data();
+            size = buffer.size();
+            ok = true;
+#else
+            int fd = open(fileName.c_str(), O_RDONLY);
+            if (fd < 0)
+                return;
+            struct stat st;
+            if (fstat(fd, &st) == 0)
             {
-                if (!fgets(buffer, BufferSize, fid))
-                {
-                    break;
-                }
-                else if (buffer[0] == 'v')
+                size = (size_t)st.st_size;
+                if (size == 0)
+                    ok = true;
+                else
                 {
-                    if (buffer[1] == ' ')
+                    void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (p != MAP_FAILED)
                     {
-                        str = buffer + 2;
-                        for (int k = 0; k < 3; ++k)
-                        {
-                            pch = strtok(str, " ");
-                            if (pch)
-                                x[k] = (double)atof(pch);
-                            else
-                            {
-                                return false;
-                            }
-                            str = NULL;
-                        }
-                        points.push_back({x[0], x[1], x[2]});
-
-                        x_min = min(x_min, x[0]);
-                        x_max = max(x_max, x[0]);
-                        y_min = min(y_min, x[1]);
-                        y_max = max(y_max, x[1]);
-                        z_min = min(z_min, x[2]);
-                        z_max = max(z_max, x[2]);
+                        madvise(p, size, MADV_SEQUENTIAL);
+                        data = static_cast<const char *>(p);
+                        ok = true;
                     }
                 }
-                else if (buffer[0] == 'f')
-                {
+            }
+            close(fd);
+#endif
+        }
+        ~MappedFile()
+        {
+#ifndef _WIN32
+            if (data)
+                munmap(const_cast<char *>(data), size);
+#endif
+        }
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        const char *data = nullptr;
+        size_t size = 0;
+        bool ok = false;
+
+    private:
+#ifdef _WIN32
+        vector<char> buffer;
+#endif
+    };
+
+    // A run of whole lines of an OBJ file, with what it holds
+    struct ObjChunk
+    {
+        const char *begin, *end;
+        size_t n_points = 0, n_triangles = 0;
+        array<double, 6> bounds = {INF, -INF, INF, -INF, INF, -INF};
+        bool ok = true;
+    };
+
+    static inline bool ObjBlank(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
 
-                    pch = str = buffer + 2;
-                    int k = 0;
-                    while (pch)
+    // Counts the points and triangles of the chunk, or with points set, stores them from the given offsets. Faces
+    // are fanned into triangles; a negative index counts back from the last point read before the face.
+    static void ParseObjChunk(ObjChunk &chunk, vec3d *points, vec3i *triangles, size_t first_point, size_t total_points)
+    {
+        size_t n_points = 0, n_triangles = 0;
+        const char *p = chunk.begin, *end = chunk.end;
+        while (p < end && chunk.ok)
+        {
+            const char *eol = static_cast<const char *>(memchr(p, '\n', end - p));
+            if (!eol)
+                eol = end;
+            while (p < eol && ObjBlank(*p))
+                p++;
+            if (eol - p >= 2 && (p[0] == 'v' || p[0] == 'f') && ObjBlank(p[1]))
+            {
+                const bool vertex = p[0] == 'v';
+                p += 2;
+                if (vertex && !points)
+                    n_points++;
+                else if (vertex)
+                {
+                    vec3d &v = points[n_points++];
+                    for (int k = 0; k < 3 && chunk.ok; k++)
                     {
-                        pch = strtok(str, " ");
-                        if (pch && *pch != '\n')
-                        {
-                            if (atoi(pch) == 0)
-                                continue;
-                            ip[k++] = (unsigned int)atoi(pch) - 1;
-                        }
-                        else
-                        {
-                            break;
-                        }
-                        str = NULL;
+                        while (p < eol && ObjBlank(*p))
+                            p++;
+                        if (p < eol && *p == '+')
+                            p++;
+                        std::from_chars_result r = std::from_chars(p, eol, v[k]);
+                        chunk.ok = r.ec == std::errc();
+                        p = r.ptr;
                     }
-                    if (k == 3)
+                    for (int k = 0; k < 3 && chunk.ok; k++)
                     {
-                        triangles.push_back({ip[0], ip[1], ip[2]});
+                        chunk.bounds[2 * k] = min(chunk.bounds[2 * k], v[k]);
+                        chunk.bounds[2 * k + 1] = max(chunk.bounds[2 * k + 1], v[k]);
                     }
-                    else if (k == 4)
+                }
+                else
+                {
+                    // corners are "v", "v/vt", "v//vn" or "v/vt/vn"; only the vertex index is kept
+                    int corners = 0, first = 0, last = 0;
+                    while (chunk.ok)
                     {
-                        triangles.push_back({ip[0], ip[1], ip[2]});
-                        triangles.push_back({ip[0], ip[2], ip[3]});
+                        while (p < eol && ObjBlank(*p))
+                            p++;
+                        if (p == eol || *p == '#')
+                            break;
+                        if (points)
+                        {
+                            long long idx = 0;
+                            std::from_chars_result r = std::from_chars(p, eol, idx);
+                            if (idx < 0)
+                                idx += (long long)(first_point + n_points);
+                            else
+                                idx--;
+                            chunk.ok = r.ec == std::errc() && idx >= 0 && idx < (long long)total_points;
+                            if (corners == 0)
+                                first = (int)idx;
+                            else if (corners >= 2)
+                                triangles[n_triangles++] = {first, last, (int)idx};
+                            last = (int)idx;
+                        }
+                        corners++;
+                        while (p < eol && !ObjBlank(*p))
+                            p++;
                     }
+                    if (!points && corners >= 3)
+                        n_triangles += corners - 2;
                 }
             }
-
-            bbox[0] = x_min;
-            bbox[1] = x_max;
-            bbox[2] = y_min;
-            bbox[3] = y_max;
-            bbox[4] = z_min;
-            bbox[5] = z_max;
-
-            fclose(fid);
+            p = eol + 1;
         }
-        else
+        chunk.n_points = n_points;
+        chunk.n_triangles = n_triangles;
+    }
+
+    bool Model::LoadOBJ(const string &fileName)
+    {
+        MappedFile file(fileName);
+        if (!file.ok)
         {
             logger::error("Open File Error!");
             return false;
         }
+
+        // split at line ends into chunks parsed in parallel: count first, then fill the pre-sized arrays
+        int n_chunks = 1;
+#ifdef _OPENMP
+        if (file.size >= (1 << 20))
+            n_chunks = 8 * omp_get_max_threads();
+#endif
+        vector<ObjChunk> chunks(n_chunks);
+        const char *begin = file.data, *end = file.data + file.size;
+        for (int i = 0; i < n_chunks; i++)
+        {
+            const char *p = i == 0 ? begin : begin + file.size / n_chunks * i;
+            if (i > 0)
+            {
+                p = std::max(p, chunks[i - 1].begin);
+                const char *eol = static_cast<const char *>(memchr(p, '\n', end - p));
+                p = eol ? eol + 1 : end;
+            }
+            chunks[i].begin = p;
+            if (i > 0)
+                chunks[i - 1].end = p;
+        }
+        chunks.back().end = end;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) if (n_chunks > 1)
+#endif
+        for (int i = 0; i < n_chunks; i++)
+            ParseObjChunk(chunks[i], nullptr, nullptr, 0, 0);
+
+        vector<size_t> point_offsets(n_chunks + 1, 0), triangle_offsets(n_chunks + 1, 0);
+        for (int i = 0; i < n_chunks; i++)
+        {
+            point_offsets[i + 1] = point_offsets[i] + chunks[i].n_points;
+            triangle_offsets[i + 1] = triangle_offsets[i] + chunks[i].n_triangles;
+        }
+        points.resize(point_offsets[n_chunks]);
+        triangles.resize(triangle_offsets[n_chunks]);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) if (n_chunks > 1)
+#endif
+        for (int i = 0; i < n_chunks; i++)
+            ParseObjChunk(chunks[i], points.data() + point_offsets[i], triangles.data() + triangle_offsets[i], point_offsets[i], points.size());
+
+        array<double, 6> bounds = {INF, -INF, INF, -INF, INF, -INF};
+        for (const ObjChunk &chunk : chunks)
+        {
+            if (!chunk.ok)
+            {
+                logger::error("Invalid OBJ File!");
+                points.clear();
+                triangles.clear();
+                Invalidate();
+                return false;
+            }
+            for (int k = 0; k < 3; k++)
+            {
+                bounds[2 * k] = min(bounds[2 * k], chunk.bounds[2 * k]);
+                bounds[2 * k + 1] = max(bounds[2 * k + 1], chunk.bounds[2 * k + 1]);
+            }
+        }
+        for (int k = 0; k < 6; k++)
+            bbox[k] = bounds[k];
+        Invalidate();
         return true;
     }
 
@@ -579,6 +929,7 @@ namespace coacd
         {
             triangles.push_back({face_indices[i][0], face_indices[i][1], face_indices[i][2]});
         }
+        Invalidate();
 
         return true;
     }
@@ -610,6 +961,7 @@ namespace coacd
         bbox[3] = y_max;
         bbox[4] = z_min;
         bbox[5] = z_max;
+        Invalidate();
 
         return m_rot;
     }
@@ -639,6 +991,7 @@ namespace coacd
         bbox[3] = y_len / m_len;
         bbox[4] = -z_len / m_len;
         bbox[5] = z_len / m_len;
+        Invalidate();
 
         return vector<double> {x_min, x_max, y_min, y_max, z_min, z_max};
     }
@@ -660,6 +1013,7 @@ namespace coacd
                          points[i][2] / 2 * m_len + m_Zmid};
 
         std::copy(_bbox.begin(), _bbox.end(), bbox);
+        Invalidate();
     }
 
     void Model::RevertPCA(array<array<double, 3>, 3> rot)
@@ -673,12 +1027,14 @@ namespace coacd
             points[i][1] = rot[1][0] * x + rot[1][1] * y + rot[1][2] * z;
             points[i][2] = rot[2][0] * x + rot[2][1] * y + rot[2][2] * z;
         }
+        Invalidate();
     }
 
     void Model::Clear()
     {
         points.clear();
         triangles.clear();
+        Invalidate();
     }
 
     void Model::SaveOBJ(const string &filename)
@@ -695,26 +1051,14 @@ namespace coacd
         os.close();
     }
 
-    double MeshArea(Model &mesh)
+    double MeshArea(const Model &mesh)
     {
-        double area = 0;
-        for (int i = 0; i < (int)mesh.triangles.size(); i++)
-        {
-            int idx0 = mesh.triangles[i][0], idx1 = mesh.triangles[i][1], idx2 = mesh.triangles[i][2];
-            area += Area(mesh.points[idx0], mesh.points[idx1], mesh.points[idx2]);
-        }
-        return area;
+        return mesh.GetArea();
     }
 
-    double MeshVolume(Model &mesh)
+    double MeshVolume(const Model &mesh)
     {
-        double volume = 0;
-        for (int i = 0; i < (int)mesh.triangles.size(); i++)
-        {
-            int idx0 = mesh.triangles[i][0], idx1 = mesh.triangles[i][1], idx2 = mesh.triangles[i][2];
-            volume += Volume(mesh.points[idx0], mesh.points[idx1], mesh.points[idx2]);
-        }
-        return volume;
+        return mesh.GetVolume();
     }
 
     void RecoverParts(vector<Model> &meshes, vector<double> bbox, array<array<double, 3>, 3> rot, Params &params)
@@ -17,6 +17,7 @@
 #include <set>
 #include <map>
 #include <unordered_map>
+#include <memory>
 
 #include "shape.h"
 #include "sobol.h"
@@ -55,6 +56,44 @@ namespace coacd
         };
     };
 
+    struct ModelCache;
+    class DistanceField;
+
+    // Owns the derived properties of one Model. A copy starts empty, so a model never sees values computed for another;
+    // a move takes the values along with the data and leaves the source empty.
+    class CacheSlot
+    {
+    public:
+        CacheSlot();
+        CacheSlot(const CacheSlot &);
+        CacheSlot(CacheSlot &&other) noexcept;
+        CacheSlot &operator=(const CacheSlot &);
+        CacheSlot &operator=(CacheSlot &&other) noexcept;
+        ~CacheSlot();
+
+        ModelCache &operator*() const { return *cache; }
+
+    private:
+        std::unique_ptr<ModelCache> cache;
+    };
+
+    // Counts deep copies of a Model; moves are not counted
+    struct CopyCounter
+    {
+        CopyCounter() = default;
+        CopyCounter(const CopyCounter &);
+        CopyCounter(CopyCounter &&) = default;
+        CopyCounter &operator=(const CopyCounter &);
+        CopyCounter &operator=(CopyCounter &&) = default;
+    };
+
+    struct SurfaceSamples
+    {
+        vector<vec3d> points;
+        vector<int> tri_ids;
+        PointsSoA cloud; // points in single precision, for KD-trees
+    };
+
     class Model
     {
     public:
@@ -81,22 +120,67 @@ namespace coacd
         void GetEigenValues(array<array<double, 3>, 3> eigen_values);
         void AlignToPrincipalAxes();
         bool IsManifold();
-        void ExtractPointSet(vector<vec3d> &samples, vector<int> &sample_tri_ids, unsigned int seed = 1235, size_t resolution = 2000, double base = 0, bool flag = false, Plane plane = Plane(0, 0, 0, 0));
+        void ExtractPointSet(vector<vec3d> &samples, vector<int> &sample_tri_ids, unsigned int seed = 1235, size_t resolution = 2000, double base = 0, bool flag = false, Plane plane = Plane(0, 0, 0, 0)) const;
         vector<vec3d> GetPoints(size_t resolution);
         double *GetBBox() { return bbox; }
-        void ComputeAPX(Model &convex, string apx_mode = "ch", bool if_vch = false);
-        void ComputeBOX(Model &convex);
-        void ComputeCH(Model &convex, bool if_vch = false);
-        void ComputeVCH(Model &convex);
+        const double *GetBBox() const { return bbox; }
+        void ComputeAPX(Model &convex, string apx_mode = "ch", bool if_vch = false) const;
+        void ComputeBOX(Model &convex) const;
+        void ComputeCH(Model &convex, bool if_vch = false) const;
+        void ComputeCH(vector<vec3d> &hull_points, vector<vec3i> &hull_triangles, bool if_vch = false) const;
+        void ComputeVCH(Model &convex) const;
+        void ComputeVCH(vector<vec3d> &hull_points, vector<vec3i> &hull_triangles) const;
+
+        // Derived properties, computed once until Invalidate() (or a change in the number of points or triangles) and
+        // safe to query from several threads. Copies start without them; share a MeshHandle to share them. Call
+        // Invalidate() after moving points or rewriting triangles in place.
+        double GetVolume() const;
+        double GetArea() const;
+        const array<double, 6> &GetBounds() const; // x_min, x_max, y_min, y_max, z_min, z_max of the points
+        const Model &GetHull() const; // ComputeAPX(hull) in "ch" mode
+        double GetHullVolume() const;
+        const SurfaceSamples &GetSamples(size_t resolution, double base = 1) const; // ExtractPointSet without a cut plane
+        const PointsSoA &GetPointCloud() const; // points in single precision, for KD-trees
+        const HalfEdges &GetHalfEdges() const; // edge adjacency of the triangles
+#if WITH_3RD_PARTY_LIBS
+        const DistanceField &GetDistanceField(double voxel_size, double band) const; // narrow-band SDF of the surface
+#endif
+        void Invalidate();
+
+    private:
+        CacheSlot cache;
+        CopyCounter copies;
+        ModelCache &Cache() const { return *cache; }
     };
 
-    double MeshArea(Model &mesh);
-    double MeshVolume(Model &mesh);
+    // Shared, read-only mesh. Copying a handle shares the mesh; Mutable() makes a private copy first if another
+    // handle still holds it, so deep copies happen only where a mesh is changed.
+    class MeshHandle
+    {
+    public:
+        MeshHandle() : mesh(std::make_shared<Model>()) {}
+        MeshHandle(Model &&m) : mesh(std::make_shared<Model>(std::move(m))) {}
+        explicit MeshHandle(const Model &m) : mesh(std::make_shared<Model>(m)) {}
+
+        const Model &operator*() const { return *mesh; }
+        const Model *operator->() const { return mesh.get(); }
+        Model &Mutable();
+        Model Release(); // the mesh itself if this is the last handle to it, a copy otherwise
+
+    private:
+        std::shared_ptr<Model> mesh;
+    };
+
+    size_t GetModelCopies();
+    void ResetModelCopies();
+
+    double MeshArea(const Model &mesh);
+    double MeshVolume(const Model &mesh);
     void RecoverParts(vector<Model> &meshes, vector<double> bbox, array<array<double, 3>, 3> rot, Params &params);
-    bool ComputeOverlapFace(Model &convex1, Model &convex2, Plane &plane);
-    void ExtractPointSet(Model convex1, Model convex2, unsigned int seed, vector<vec3d> &samples, size_t resolution = 4000);
-    void ExtractPointSet(Model &convex1, Model &convex2, vector<vec3d> &samples, vector<int> &sample_tri_ids, unsigned int seed, size_t resolution);
+    bool ComputeOverlapFace(const Model &convex1, const Model &convex2, Plane &plane);
+    void ExtractPointSet(const Model &convex1, const Model &convex2, unsigned int seed, vector<vec3d> &samples, size_t resolution = 4000);
+    void ExtractPointSet(const Model &convex1, const Model &convex2, vector<vec3d> &samples, vector<int> &sample_tri_ids, unsigned int seed, size_t resolution);
     void WritePointSet(const string &fileName, vector<vec3d> &samples);
-    void MergeMesh(Model &mesh1, Model &mesh2, Model &merge);
+    void MergeMesh(const Model &mesh1, const Model &mesh2, Model &merge);
 
 }
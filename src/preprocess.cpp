@@ -62,4 +62,4 @@ namespace coacd
         SDFManifold(tmp, m, params.prep_resolution, params.dmc_thres);
     }
 
-}
\ No newline at end of file
+}
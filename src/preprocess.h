@@ -3,6 +3,7 @@
 #include <openvdb/openvdb.h>
 #include <openvdb/tools/MeshToVolume.h>
 #include <openvdb/tools/VolumeToMesh.h>
+#include <openvdb/tools/Interpolation.h>
 #include <openvdb/util/Util.h>
 #include <vector>
 #include <cstdio>
@@ -0,0 +1,47 @@
+#include <cmath>
+
+#include <openvdb/openvdb.h>
+#include <openvdb/tools/Interpolation.h>
+#include <openvdb/tools/MeshToVolume.h>
+
+#include "sdf.h"
+
+namespace coacd
+{
+    struct DistanceField::Grid
+    {
+        openvdb::DoubleGrid::Ptr sdf;
+    };
+
+    // Built in index space like SDFManifold, so a voxel is one unit
+    DistanceField::DistanceField(const Model &mesh, double _voxel_size, double _band)
+        : voxel_size(_voxel_size), band(_band), grid(std::make_unique<Grid>())
+    {
+        std::vector<openvdb::Vec3s> points;
+        std::vector<openvdb::Vec3I> tris;
+        std::vector<openvdb::Vec4I> quads;
+        double scale = 1.0 / voxel_size;
+
+        points.reserve(mesh.points.size());
+        tris.reserve(mesh.triangles.size());
+        for (unsigned int i = 0; i < mesh.points.size(); ++i)
+            points.push_back({(float)(mesh.points[i][0] * scale), (float)(mesh.points[i][1] * scale), (float)(mesh.points[i][2] * scale)});
+        for (unsigned int i = 0; i < mesh.triangles.size(); ++i)
+            tris.push_back({(unsigned int)mesh.triangles[i][0], (unsigned int)mesh.triangles[i][1], (unsigned int)mesh.triangles[i][2]});
+
+        // only the exterior band is wide: the hull samples looked up in it lie on or outside the mesh
+        float half_width = (float)(band * scale) + 1.0f;
+        openvdb::math::Transform::Ptr xform = openvdb::math::Transform::createLinearTransform();
+        grid->sdf = openvdb::tools::meshToSignedDistanceField<openvdb::DoubleGrid>(*xform, points, tris, quads, half_width, 1.0f);
+    }
+
+    DistanceField::~DistanceField() = default;
+
+    double DistanceField::Distance(const vec3d &p) const
+    {
+        // the sampler reads the tree without a cached accessor, so one field serves all threads
+        openvdb::tools::GridSampler<openvdb::DoubleGrid, openvdb::tools::BoxSampler> sampler(*grid->sdf);
+        double scale = 1.0 / voxel_size;
+        return fabs(sampler.isSample(openvdb::Vec3d(p[0] * scale, p[1] * scale, p[2] * scale))) * voxel_size;
+    }
+}
@@ -2,102 +2,256 @@
 #include "mcts.h"
 #include "config.h"
 #include "bvh.h"
+#include "hull.h"
+#include "gjk.h"
+#include "decimate.h"
+#include "arena.h"
 
 #include <iostream>
+#include <bit>
 #include <cmath>
+#include <queue>
 
 namespace coacd
 {
     thread_local std::mt19937 random_engine;
 
+    // Checks that the mesh is closed, consistently oriented and free of self-intersections, then orients it
+    // outwards. Unless exhaustive, it stops at the first failing stage and the first intersecting pair.
+    ManifoldReport CheckManifold(Model &input, bool exhaustive)
+    {
+        ManifoldReport report;
+        const int T = (int)input.triangles.size();
+
+        // every directed edge exactly once, and its twin present
+        const HalfEdges &he = input.GetHalfEdges();
+        const vector<uint64_t> &edges = he.keys;
+
+        auto decode = [](uint64_t key) -> pair<int, int>
+        { return {HalfEdges::From(key), HalfEdges::To(key)}; };
+        for (size_t i = 1; i < edges.size(); i++)
+            if (edges[i] == edges[i - 1] && (i == 1 || edges[i] != edges[i - 2]))
+                report.duplicate_edges.push_back(decode(edges[i]));
+        if (!report.duplicate_edges.empty() && !exhaustive)
+            return report;
+
+        for (size_t i = 0; i < edges.size(); i++)
+        {
+            if (i > 0 && edges[i] == edges[i - 1])
+                continue;
+            if (he.twin[he.order[i]] == -1 && he.Find(HalfEdges::To(edges[i]), HalfEdges::From(edges[i])) == -1)
+            {
+                report.open_edges.push_back(decode(edges[i]));
+                if (!exhaustive)
+                    return report;
+            }
+        }
+
+        BVH bvhTree(input);
+        bvhTree.SelfIntersections(report.intersections, !exhaustive);
+        if (!report.Manifold())
+            return report;
+
+        if (MeshVolume(input) < 0)
+        {
+            // Reverse all the triangles
+            for (int i = 0; i < T; i++)
+                std::swap(input.triangles[i][0], input.triangles[i][1]);
+            input.Invalidate();
+            report.reversed = true;
+        }
+        return report;
+    }
+
     bool IsManifold(Model &input)
     {
         logger::info(" - Manifold Check");
         clock_t start, end;
         start = clock();
-        // Check all edges are shared by exactly two triangles (watertight manifold)
-        vector<pair<int, int>> edges;
-        map<pair<int, int>, int> edge_num;
-        for (int i = 0; i < (int)input.triangles.size(); i++)
+        ManifoldReport report = CheckManifold(input);
+        end = clock();
+
+        if (!report.duplicate_edges.empty())
+            logger::info("\tWrong triangle orientation");
+        else if (!report.open_edges.empty())
+            logger::info("\tUnclosed mesh");
+        else
         {
-            int idx0 = input.triangles[i][0];
-            int idx1 = input.triangles[i][1];
-            int idx2 = input.triangles[i][2];
-            edges.push_back({idx0, idx1});
-            edges.push_back({idx1, idx2});
-            edges.push_back({idx2, idx0});
-
-            if (!edge_num.contains({idx0, idx1}))
-                edge_num[{idx0, idx1}] = 1;
+            logger::info("[1/3] Edge check finish");
+            if (!report.intersections.empty())
+                logger::info("\tTriangle self-intersection");
             else
             {
-                logger::info("\tWrong triangle orientation");
-                end = clock();
-                logger::info("Manifold Check Time: {}s", double(end - start) / CLOCKS_PER_SEC);
-                return false;
+                logger::info("[2/3] Self-intersection check finish");
+                logger::info("[3/3] Triangle orientation check finish. Reversed: {}", report.reversed);
             }
-            if (!edge_num.contains({idx1, idx2}))
-                edge_num[{idx1, idx2}] = 1;
-            else
+        }
+        logger::info("Manifold Check Time: {}s", double(end - start) / CLOCKS_PER_SEC);
+
+        return report.Manifold();
+    }
+
+    // Merges points closer than tolerance * the bounding box diagonal, then drops triangles left degenerate or
+    // duplicated (the same three points in any order) and the points no triangle uses. Indices keep their order.
+    WeldReport WeldVertices(Model &input, double tolerance)
+    {
+        WeldReport report;
+        const int N = (int)input.points.size(), T = (int)input.triangles.size();
+        if (N == 0)
+            return report;
+
+        const array<double, 6> &bounds = input.GetBounds();
+        double diagonal = sqrt(pow(bounds[1] - bounds[0], 2) + pow(bounds[3] - bounds[2], 2) + pow(bounds[5] - bounds[4], 2));
+        double eps = tolerance * diagonal, eps2 = eps * eps;
+
+        // grid cells at least eps wide, so a match is in the point's cell or a neighbouring one; 21 bits per axis
+        double extent = max(max(bounds[1] - bounds[0], bounds[3] - bounds[2]), bounds[5] - bounds[4]);
+        double cell = max(eps, extent / ((1 << 21) - 3));
+        if (cell <= 0)
+            cell = 1;
+        auto key = [](int64_t x, int64_t y, int64_t z)
+        { return (uint64_t)x << 42 | (uint64_t)y << 21 | (uint64_t)z; };
+        auto hash = [](uint64_t k)
+        {
+            k *= 0x9E3779B97F4A7C15ull;
+            return (size_t)(k ^ k >> 29);
+        };
+
+        // open-addressing table of cells, each the head of a list of the representatives in it
+        size_t slots = 1024;
+        while (slots < 2 * (size_t)N)
+            slots *= 2;
+        struct Cell
+        {
+            uint64_t key;
+            int head = -1;
+        };
+        vector<Cell> cells(slots);
+        vector<int> next(N, -1), remap(N);
+        auto find = [&](uint64_t k) -> Cell &
+        {
+            size_t h = hash(k) & (slots - 1);
+            while (cells[h].head != -1 && cells[h].key != k)
+                h = (h + 1) & (slots - 1);
+            return cells[h];
+        };
+
+        for (int i = 0; i < N; i++)
+        {
+            const vec3d &p = input.points[i];
+            int64_t c[3];
+            int lo[3], hi[3]; // neighbouring cells only on the sides p is within eps of
+            for (int k = 0; k < 3; k++)
             {
-                logger::info("\tWrong triangle orientation");
-                end = clock();
-                logger::info("Manifold Check Time: {}s", double(end - start) / CLOCKS_PER_SEC);
-                return false;
+                double x = (p[k] - bounds[2 * k]) / cell;
+                c[k] = (int64_t)x + 1;
+                lo[k] = (x - floor(x)) * cell <= eps ? -1 : 0;
+                hi[k] = (floor(x) + 1 - x) * cell <= eps ? 1 : 0;
             }
-            if (!edge_num.contains({idx2, idx0}))
-                edge_num[{idx2, idx0}] = 1;
-            else
+            int match = -1;
+            Cell &own = find(key(c[0], c[1], c[2]));
+            for (int dx = lo[0]; dx <= hi[0] && match == -1; dx++)
+                for (int dy = lo[1]; dy <= hi[1] && match == -1; dy++)
+                    for (int dz = lo[2]; dz <= hi[2] && match == -1; dz++)
+                    {
+                        Cell &probe = dx == 0 && dy == 0 && dz == 0 ? own : find(key(c[0] + dx, c[1] + dy, c[2] + dz));
+                        for (int j = probe.head; j != -1 && match == -1; j = next[j])
+                        {
+                            const vec3d &q = input.points[j];
+                            if (pow(p[0] - q[0], 2) + pow(p[1] - q[1], 2) + pow(p[2] - q[2], 2) <= eps2)
+                                match = j;
+                        }
+                    }
+            if (match != -1)
             {
-                logger::info("\tWrong triangle orientation");
-                end = clock();
-                logger::info("Manifold Check Time: {}s", double(end - start) / CLOCKS_PER_SEC);
-                return false;
+                remap[i] = match;
+                report.welded++;
+                continue;
             }
+            remap[i] = i;
+            own.key = key(c[0], c[1], c[2]);
+            next[i] = own.head;
+            own.head = i;
         }
 
-        for (int i = 0; i < (int)edges.size(); i++)
+        // triangles over the merged points, without degenerate ones and with each point set once. Triangles are
+        // bucketed by their smallest point, in order, so duplicates meet in a bucket and the first one is kept.
+        vector<int> offsets(N + 1, 0), bucket(T);
+        vector<bool> keep(T, false);
+        for (int i = 0; i < T; i++)
         {
-            pair<int, int> oppo_edge = {edges[i].second, edges[i].first};
-            if (!edge_num.contains(oppo_edge))
+            vec3i &t = input.triangles[i];
+            t = {remap[t[0]], remap[t[1]], remap[t[2]]};
+            if (t[0] == t[1] || t[1] == t[2] || t[2] == t[0])
+                report.degenerate++;
+            else
             {
-                logger::info("\tUnclosed mesh");
-                end = clock();
-                logger::info("Manifold Check Time: {}s", double(end - start) / CLOCKS_PER_SEC);
-                return false;
+                keep[i] = true;
+                offsets[min(min(t[0], t[1]), t[2]) + 1]++;
             }
         }
-        logger::info("[1/3] Edge check finish");
-
-        // Check self-intersection
-        BVH bvhTree(input);
-        for (int i = 0; i < (int)input.triangles.size(); i++)
+        for (int v = 0; v < N; v++)
+            offsets[v + 1] += offsets[v];
+        vector<int> fill(offsets.begin(), offsets.end() - 1);
+        for (int i = 0; i < T; i++)
+            if (keep[i])
+            {
+                const vec3i &t = input.triangles[i];
+                bucket[fill[min(min(t[0], t[1]), t[2])]++] = i;
+            }
+        auto others = [&](int i) // the two larger points of triangle i
         {
-            bool is_intersect = bvhTree.IntersectBVH(input.triangles[i], 0);
-            if (is_intersect)
+            const vec3i &t = input.triangles[i];
+            int lo = min(min(t[0], t[1]), t[2]), hi = max(max(t[0], t[1]), t[2]);
+            return (uint64_t)(t[0] + t[1] + t[2] - lo - hi) << 32 | (uint32_t)hi;
+        };
+        for (int v = 0; v < N; v++)
+            for (int a = offsets[v]; a < offsets[v + 1]; a++)
+                for (int b = offsets[v]; b < a; b++)
+                    if (keep[bucket[b]] && others(bucket[a]) == others(bucket[b]))
+                    {
+                        keep[bucket[a]] = false;
+                        report.duplicate++;
+                        break;
+                    }
+
+        vector<int> index(N, -1);
+        int kept_triangles = 0;
+        for (int i = 0; i < T; i++)
+            if (keep[i])
             {
-                logger::info("\tTriangle self-intersection");
-                end = clock();
-                logger::info("Manifold Check Time: {}s", double(end - start) / CLOCKS_PER_SEC);
-                return false;
+                input.triangles[kept_triangles++] = input.triangles[i];
+                for (int k = 0; k < 3; k++)
+                    index[input.triangles[i][k]] = 0;
             }
-        }
-        logger::info("[2/3] Self-intersection check finish");
+        input.triangles.resize(kept_triangles);
 
-        // Check triange orientation
-        double mesh_vol = MeshVolume(input);
-        if (mesh_vol < 0)
+        int kept_points = 0;
+        for (int i = 0; i < N; i++)
+            if (index[i] == 0)
+            {
+                index[i] = kept_points;
+                input.points[kept_points++] = input.points[i];
+            }
+            else if (remap[i] == i)
+                report.unused++;
+        input.points.resize(kept_points);
+        for (vec3i &t : input.triangles)
+            for (int k = 0; k < 3; k++)
+                t[k] = index[t[k]];
+        input.Invalidate();
+        if (report.Changed())
         {
-            // Reverse all the triangles
-            for (int i = 0; i < (int)input.triangles.size(); i++)
-                std::swap(input.triangles[i][0], input.triangles[i][1]);
+            // dropped points may have spanned the box, and the weld runs after Normalize() set it
+            const array<double, 6> &bounds = input.GetBounds();
+            for (int k = 0; k < 6; k++)
+                input.bbox[k] = bounds[k];
         }
-        end = clock();
 
-        logger::info("[3/3] Triangle orientation check finish. Reversed: {}", mesh_vol < 0);
-        logger::info("Manifold Check Time: {}s", double(end - start) / CLOCKS_PER_SEC);
-
-        return true;
+        if (report.Changed())
+            logger::info("Welded {} vertices, removed {} degenerate and {} duplicate triangles and {} unused vertices",
+                         report.welded, report.degenerate, report.duplicate, report.unused);
+        return report;
     }
 
     double pts_norm(vec3d pt, vec3d p)
@@ -110,83 +264,54 @@ namespace coacd
         if (tgt_pts >= (int)ch.points.size())
             return;
 
-        vector<vec3d> new_pts;
-        vector<int> rm_pt_idxs;
-        int n_pts = (int)ch.points.size();
-        int tgt_n = min(tgt_pts, (int)ch.points.size());
-
-        // compute edges
-        vector<pair<double, pair<int, int>>> edge_costs;
-        for (int i = 0; i < (int)ch.triangles.size(); i++)
-        {
-            for (int j = 0; j < 3; j++)
-                if (ch.triangles[i][j] > ch.triangles[i][(j + 1) % 3])
-                {
-                    double cost = pts_norm(ch.points[ch.triangles[i][j]], ch.points[ch.triangles[i][(j + 1) % 3]]);
-                    edge_costs.push_back({cost, {ch.triangles[i][j], ch.triangles[i][(j + 1) % 3]}});
-                }
-        }
-
-        while (n_pts > tgt_n)
-        {
-            // sort the points by the cost
-            sort(edge_costs.begin(), edge_costs.end());
-
-            // remove the edge with the smallest cost
-            pair<int, int> edge = edge_costs[0].second;
-            vec3d new_pt = {0.5 * (ch.points[edge.first][0] + ch.points[edge.second][0]),
-                            0.5 * (ch.points[edge.first][1] + ch.points[edge.second][1]),
-                            0.5 * (ch.points[edge.first][2] + ch.points[edge.second][2])};
-
-            rm_pt_idxs.push_back(edge.first);
-            rm_pt_idxs.push_back(edge.second);
-
-            ch.points.push_back(new_pt);
-            n_pts -= 1;
-            edge_costs[0].first = INF;
+        // collapse the cheapest edges in volume added, then rebuild the hull of what is left
+        Model new_ch;
+        CollapseHull(ch.points, ch.triangles, max(tgt_pts, 4), new_ch.points);
+        new_ch.ComputeAPX(ch, apx_mode, true);
+    }
 
-            // update the neighboring edge costs
-            int new_pt_idx = ch.points.size() - 1;
-            for (int i = 0; i < (int)edge_costs.size(); i++)
-            {
-                if (edge_costs[i].second.first == edge.first && edge_costs[i].second.second == edge.second)
-                    edge_costs[i].first = INF;
-                else if (edge_costs[i].second.first == edge.first || edge_costs[i].second.first == edge.second)
-                {
-                    edge_costs[i].first = pts_norm(new_pt, ch.points[edge_costs[i].second.second]);
-                    edge_costs[i].second.first = new_pt_idx;
-                }
-                else if (edge_costs[i].second.second == edge.first || edge_costs[i].second.second == edge.second)
-                {
-                    edge_costs[i].first = pts_norm(new_pt, ch.points[edge_costs[i].second.first]);
-                    edge_costs[i].second.second = edge_costs[i].second.first;
-                    edge_costs[i].second.first = new_pt_idx; // larger idx should be the first!
-                }
-            }
-        }
+    void BudgetCH(Model &ch, int tgt_pts, string apx_mode)
+    {
+        if (tgt_pts >= (int)ch.points.size())
+            return;
 
-        // remove the points and add new points
-        Model new_ch;
-        for (int i = 0; i < (int)ch.points.size(); i++)
+        // rebuild the hull farthest-point first within the vertex budget, enlarged to enclose the dropped points
+        Model budget_ch;
+        if (!ComputeHull(ch.points, budget_ch.points, budget_ch.triangles, max(tgt_pts, 4)))
         {
-            if (find(rm_pt_idxs.begin(), rm_pt_idxs.end(), i) == rm_pt_idxs.end())
-                new_ch.points.push_back(ch.points[i]);
+            DecimateCH(ch, tgt_pts, apx_mode);
+            return;
         }
-
-        new_ch.ComputeAPX(ch, apx_mode, true);
+        ch.points = budget_ch.points;
+        ch.triangles = budget_ch.triangles;
+        ch.Invalidate();
     }
 
     void DecimateConvexHulls(vector<Model> &cvxs, Params &params)
     {
         logger::info(" - Simplify Convex Hulls");
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) default(none) shared(cvxs, params)
+#endif
         for (int i = 0; i < (int)cvxs.size(); i++)
         {
-            DecimateCH(cvxs[i], params.max_ch_vertex, params.apx_mode);
+            if (params.decimate_mode == "hull")
+                BudgetCH(cvxs[i], params.max_ch_vertex, params.apx_mode);
+            else
+                DecimateCH(cvxs[i], params.max_ch_vertex, params.apx_mode);
         }
     }
 
-    void MergeCH(Model &ch1, Model &ch2, Model &ch, Params &params)
+    // Hull of the union of two hulls; returns its volume
+    double MergeCH(Model &ch1, Model &ch2, Model &ch, Params &params)
     {
+        double volume;
+        if (params.apx_mode == "ch" && UniteHulls(ch1.points, ch1.triangles, ch2.points, ch2.triangles, ch.points, ch.triangles, volume))
+        {
+            ch.Invalidate(); // written in place, and the new counts may match the ones its cache was stamped with
+            return volume;
+        }
+
         Model merge;
         merge.points.insert(merge.points.end(), ch1.points.begin(), ch1.points.end());
         merge.points.insert(merge.points.end(), ch2.points.begin(), ch2.points.end());
@@ -195,170 +320,263 @@ namespace coacd
             merge.triangles.push_back({int(ch2.triangles[i][0] + ch1.points.size()),
                                        int(ch2.triangles[i][1] + ch1.points.size()), int(ch2.triangles[i][2] + ch1.points.size())});
         merge.ComputeAPX(ch, params.apx_mode, true);
+        return MeshVolume(ch);
     }
 
-    double MergeConvexHulls(Model &m, vector<Model> &meshs, vector<Model> &cvxs, Params &params, double epsilon, double threshold)
+    struct MergeCandidate
     {
-        logger::info(" - Merge Convex Hulls");
-        size_t nConvexHulls = (size_t)cvxs.size();
+        double cost;
+        int p1, p2; // p1 > p2
+        int version1, version2;
+
+        // ties resolve to the lowest pair, as the old cost matrix scan did
+        bool operator>(const MergeCandidate &other) const
+        {
+            if (cost != other.cost)
+                return cost > other.cost;
+            if (p1 != other.p1)
+                return p1 > other.p1;
+            return p2 > other.p2;
+        }
+    };
+
+    static array<double, 6> HullBox(Model &ch)
+    {
+        const array<double, 6> &bounds = ch.GetBounds();
+        return {bounds[0], bounds[2], bounds[4], bounds[1], bounds[3], bounds[5]};
+    }
+
+    // Neither MeshDist (vertex to vertex) nor GJKDistance (true distance) is below the gap between the two boxes
+    static bool BoxesWithin(const array<double, 6> &b1, const array<double, 6> &b2, double dist)
+    {
+        for (int k = 0; k < 3; k++)
+            if (b1[k] - b2[k + 3] > dist || b2[k] - b1[k + 3] > dist)
+                return false;
+        return true;
+    }
+
+    // Merge cost of every pair, INF for pairs whose hulls are at least dist_limit apart (no distance test if dist_limit is INF).
+    // supports is empty unless distances go through GJK.
+    static void EvaluateMergePairs(vector<Model> &cvxs, vector<ConvexSupport> &supports, vector<pair<int, int>> &pairs, vector<double> &costs, Params &params, double dist_limit)
+    {
+        costs.resize(pairs.size());
+        ArenaSet *arenas = ArenaSet::Current();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) default(none) shared(cvxs, supports, pairs, costs, params, dist_limit, arenas)
+#endif
+        for (int idx = 0; idx < (int)pairs.size(); ++idx)
+        {
+            ArenaBinding scratch_arena(arenas);
+            int p1 = pairs[idx].first, p2 = pairs[idx].second;
+            double dist = 0;
+            if (dist_limit < INF)
+                dist = supports.empty() ? MeshDist(cvxs[p1], cvxs[p2]) : GJKDistance(supports[p1], supports[p2]);
+            if (dist < dist_limit)
+            {
+                Model combinedCH;
+                double volume = MergeCH(cvxs[p1], cvxs[p2], combinedCH, params);
+                costs[idx] = ComputeHCost(cvxs[p1], cvxs[p2], combinedCH, volume, params);
+            }
+            else
+                costs[idx] = INF;
+        }
+    }
+
+    // Candidate pairs come from the part graph if there is one (only parts sharing a cut face), otherwise from
+    // every pair of hulls within threshold
+    static double MergeHulls(vector<Model> &meshs, vector<Model> &cvxs, PartGraph *graph, Params &params, double threshold)
+    {
+        int nConvexHulls = (int)cvxs.size();
         double h = 0;
 
         if (nConvexHulls > 1)
         {
-            int bound = ((((nConvexHulls - 1) * nConvexHulls)) >> 1);
-            // Populate the cost matrix
-            vector<double> costMatrix, precostMatrix;
-            costMatrix.resize(bound);    // only keeps the top half of the matrix
-            precostMatrix.resize(bound); // only keeps the top half of the matrix
+            // Each hull keeps a version; a queued candidate is stale once either of its hulls changed
+            vector<int> version(nConvexHulls, 0);
+            vector<bool> alive(nConvexHulls, true);
+            vector<array<double, 6>> boxes(nConvexHulls);
+            vector<double> precost(nConvexHulls); // concavity already spent by each hull
+            vector<ConvexSupport> supports(params.dist_mode == "gjk" ? nConvexHulls : 0);
+            std::priority_queue<MergeCandidate, vector<MergeCandidate>, std::greater<MergeCandidate>> candidates;
+            vector<pair<int, int>> pairs;
+            vector<double> costs;
 
-            size_t p1, p2;
 #ifdef _OPENMP
-#pragma omp parallel for default(none) shared(costMatrix, precostMatrix, cvxs, params, bound, threshold, meshs) private(p1, p2)
+#pragma omp parallel for default(none) shared(cvxs, meshs, boxes, precost, supports, params, nConvexHulls)
 #endif
-            for (int idx = 0; idx < bound; ++idx)
+            for (int i = 0; i < nConvexHulls; ++i)
             {
-                p1 = (int)(sqrt(8 * idx + 1) - 1) >> 1; // compute nearest triangle number index
-                int sum = (p1 * (p1 + 1)) >> 1;         // compute nearest triangle number from index
-                p2 = idx - sum;                         // modular arithmetic from triangle number
-                p1++;
-                double dist = MeshDist(cvxs[p1], cvxs[p2]);
-                if (dist < threshold)
-                {
-                    Model combinedCH;
-                    MergeCH(cvxs[p1], cvxs[p2], combinedCH, params);
+                boxes[i] = HullBox(cvxs[i]);
+                if (!supports.empty())
+                    supports[i] = ConvexSupport(cvxs[i]);
+                precost[i] = ComputeHCost(meshs[i], cvxs[i], params.rv_k, 3000, params.seed);
+            }
 
-                    costMatrix[idx] = ComputeHCost(cvxs[p1], cvxs[p2], combinedCH, params.rv_k, params.resolution, params.seed);
-                    precostMatrix[idx] = max(ComputeHCost(meshs[p1], cvxs[p1], params.rv_k, 3000, params.seed),
-                                             ComputeHCost(meshs[p2], cvxs[p2], params.rv_k, 3000, params.seed));
+            // Parts sharing a cut face touch, so graph pairs skip the distance test
+            vector<vector<int>> neighbors;
+            double dist_limit = graph ? INF : threshold;
+            if (graph)
+            {
+                neighbors.resize(nConvexHulls);
+                for (const PartContact &contact : graph->contacts)
+                {
+                    neighbors[contact.part1].push_back(contact.part2);
+                    neighbors[contact.part2].push_back(contact.part1);
                 }
-                else
+                for (int i = 0; i < nConvexHulls; ++i)
                 {
-                    costMatrix[idx] = INF;
+                    std::sort(neighbors[i].begin(), neighbors[i].end());
+                    neighbors[i].erase(std::unique(neighbors[i].begin(), neighbors[i].end()), neighbors[i].end());
+                    for (int j : neighbors[i])
+                        if (j < i)
+                            pairs.push_back({i, j});
                 }
             }
+            else
+            {
+                // Sweep and prune along x: only pairs whose boxes come within the threshold get a MeshDist
+                vector<int> order(nConvexHulls);
+                for (int i = 0; i < nConvexHulls; ++i)
+                    order[i] = i;
+                std::sort(order.begin(), order.end(), [&](int a, int b)
+                          { return boxes[a][0] < boxes[b][0]; });
+                for (int i = 0; i < nConvexHulls; ++i)
+                    for (int j = i + 1; j < nConvexHulls && boxes[order[j]][0] - boxes[order[i]][3] <= threshold; ++j)
+                        if (BoxesWithin(boxes[order[i]], boxes[order[j]], threshold))
+                            pairs.push_back({max(order[i], order[j]), min(order[i], order[j])});
+            }
 
-            size_t costSize = (size_t)cvxs.size();
+            EvaluateMergePairs(cvxs, supports, pairs, costs, params, dist_limit);
+            for (int idx = 0; idx < (int)pairs.size(); ++idx)
+                if (costs[idx] < INF)
+                    candidates.push({costs[idx], pairs[idx].first, pairs[idx].second, 0, 0});
 
-            while (true)
+            int nAlive = nConvexHulls;
+            while (nAlive > 1)
             {
+                if (candidates.empty())
+                {
+                    // A hull budget may still force merges between hulls too far apart to have been queued
+                    if (params.max_convex_hull <= 0 || nAlive <= params.max_convex_hull)
+                        break;
+                    pairs.clear();
+                    for (int i = 0; i < nConvexHulls; ++i)
+                        for (int j = 0; j < i; ++j)
+                            if (alive[i] && alive[j])
+                                pairs.push_back({i, j});
+                    EvaluateMergePairs(cvxs, supports, pairs, costs, params, INF);
+                    for (int idx = 0; idx < (int)pairs.size(); ++idx)
+                        candidates.push({costs[idx], pairs[idx].first, pairs[idx].second, version[pairs[idx].first], version[pairs[idx].second]});
+                }
+
                 // Search for lowest cost
-                double bestCost = INF;
-                const size_t addr = FindMinimumElement(costMatrix, &bestCost, 0, (int32_t)costMatrix.size());
+                MergeCandidate best = candidates.top();
+                candidates.pop();
+                const int p1 = best.p1, p2 = best.p2;
+                if (!alive[p1] || !alive[p2] || best.version1 != version[p1] || best.version2 != version[p2])
+                    continue;
+                double bestCost = best.cost;
+                double pairPrecost = max(precost[p1], precost[p2]);
 
                 if (params.max_convex_hull <= 0)
                 {
                     // if dose not set max nConvexHull, stop the merging when bestCost is larger than the threshold
                     if (bestCost > params.threshold)
                         break;
-                    if (bestCost > max(params.threshold - precostMatrix[addr], 0.01)) // avoid merging two parts that have already used up the treshold
-                    {
-                        costMatrix[addr] = INF;
+                    if (bestCost > max(params.threshold - pairPrecost, 0.01)) // avoid merging two parts that have already used up the treshold
                         continue;
-                    }
                 }
                 else
                 {
                     // if set the max nConvexHull, ignore the threshold limitation and stio the merging untill # part reach the constraint
-                    if ((int)cvxs.size() <= params.max_convex_hull && bestCost > params.threshold)
+                    if (nAlive <= params.max_convex_hull && bestCost > params.threshold)
                     {
-                        if (bestCost > params.threshold + 0.005 && (int)cvxs.size() == params.max_convex_hull)
+                        if (bestCost > params.threshold + 0.005 && nAlive == params.max_convex_hull)
                             logger::warn("Max concavity {} exceeds the threshold {} due to {} convex hull limitation", bestCost, params.threshold, params.max_convex_hull);
                         break;
                     }
-                    if ((int)cvxs.size() <= params.max_convex_hull && bestCost > max(params.threshold - precostMatrix[addr], 0.01)) // avoid merging two parts that have already used up the treshold
-                    {
-                        costMatrix[addr] = INF;
+                    if (nAlive <= params.max_convex_hull && bestCost > max(params.threshold - pairPrecost, 0.01)) // avoid merging two parts that have already used up the treshold
                         continue;
-                    }
                 }
 
                 h = max(h, bestCost);
-                const size_t addrI = (static_cast<int32_t>(sqrt(1 + (8 * addr))) - 1) >> 1;
-                const size_t p1 = addrI + 1;
-                const size_t p2 = addr - ((addrI * (addrI + 1)) >> 1);
-                // printf("addr %ld, addrI %ld, p1 %ld, p2 %ld\n", addr, addrI, p1, p2);
-                assert(p1 >= 0);
-                assert(p2 >= 0);
-                assert(p1 < costSize);
-                assert(p2 < costSize);
-
-                // Make the lowest cost row and column into a new hull
+
+                // The merged hull takes the lower slot, the other one retires
                 Model cch;
                 MergeCH(cvxs[p1], cvxs[p2], cch, params);
-                cvxs[p2] = cch;
-
-                std::swap(cvxs[p1], cvxs[cvxs.size() - 1]);
-                cvxs.pop_back();
-
-                costSize = costSize - 1;
-
-                // Calculate costs versus the new hull
-                size_t rowIdx = ((p2 - 1) * p2) >> 1;
-                for (size_t i = 0; (i < p2); ++i)
+                cvxs[p2] = std::move(cch);
+                cvxs[p1] = Model();
+                alive[p1] = false;
+                nAlive--;
+                version[p2]++;
+                boxes[p2] = HullBox(cvxs[p2]);
+                if (!supports.empty())
                 {
-                    double dist = MeshDist(cvxs[p2], cvxs[i]);
-                    if (dist < threshold)
-                    {
-                        Model combinedCH;
-                        MergeCH(cvxs[p2], cvxs[i], combinedCH, params);
-                        costMatrix[rowIdx] = ComputeHCost(cvxs[p2], cvxs[i], combinedCH, params.rv_k, params.resolution, params.seed);
-                        precostMatrix[rowIdx++] = max(precostMatrix[p2] + bestCost, precostMatrix[i]);
-                    }
-                    else
-                        costMatrix[rowIdx++] = INF;
+                    supports[p2] = ConvexSupport(cvxs[p2]);
+                    supports[p1] = ConvexSupport();
                 }
+                precost[p2] = pairPrecost + bestCost;
 
-                rowIdx += p2;
-                for (size_t i = p2 + 1; (i < costSize); ++i)
+                // Calculate costs versus the new hull
+                pairs.clear();
+                if (graph)
                 {
-                    double dist = MeshDist(cvxs[p2], cvxs[i]);
-                    if (dist < threshold)
+                    // p2 takes over the neighbors of p1
+                    for (int q : neighbors[p1])
                     {
-                        Model combinedCH;
-                        MergeCH(cvxs[p2], cvxs[i], combinedCH, params);
-                        costMatrix[rowIdx] = ComputeHCost(cvxs[p2], cvxs[i], combinedCH, params.rv_k, params.resolution, params.seed);
-                        precostMatrix[rowIdx] = max(precostMatrix[p2] + bestCost, precostMatrix[i]);
+                        if (q == p2)
+                            continue;
+                        neighbors[p2].push_back(q);
+                        for (int &r : neighbors[q])
+                            if (r == p1)
+                                r = p2;
+                        std::sort(neighbors[q].begin(), neighbors[q].end());
+                        neighbors[q].erase(std::unique(neighbors[q].begin(), neighbors[q].end()), neighbors[q].end());
                     }
-                    else
-                        costMatrix[rowIdx] = INF;
-                    rowIdx += i;
-                    assert(rowIdx >= 0);
+                    neighbors[p1].clear();
+                    vector<int> &adj = neighbors[p2];
+                    adj.erase(std::remove_if(adj.begin(), adj.end(), [&](int q)
+                                             { return q == p1 || q == p2; }),
+                              adj.end());
+                    std::sort(adj.begin(), adj.end());
+                    adj.erase(std::unique(adj.begin(), adj.end()), adj.end());
+                    for (int q : adj)
+                        pairs.push_back({max(q, p2), min(q, p2)});
                 }
-
-                // Move the top column in to replace its space
-                const size_t erase_idx = ((costSize - 1) * costSize) >> 1;
-                if (p1 < costSize)
+                else
                 {
-                    rowIdx = (addrI * p1) >> 1;
-                    size_t top_row = erase_idx;
-                    for (size_t i = 0; i < p1; ++i)
-                    {
-                        if (i != p2)
-                        {
-                            costMatrix[rowIdx] = costMatrix[top_row];
-                            precostMatrix[rowIdx] = precostMatrix[top_row];
-                        }
-                        ++rowIdx;
-                        ++top_row;
-                    }
-
-                    ++top_row;
-                    rowIdx += p1;
-                    for (size_t i = p1 + 1; i < costSize; ++i)
-                    {
-                        costMatrix[rowIdx] = costMatrix[top_row];
-                        precostMatrix[rowIdx] = precostMatrix[top_row++];
-                        rowIdx += i;
-                    }
+                    for (int i = 0; i < nConvexHulls; ++i)
+                        if (alive[i] && i != p2 && BoxesWithin(boxes[p2], boxes[i], threshold))
+                            pairs.push_back({max(i, p2), min(i, p2)});
                 }
-                costMatrix.resize(erase_idx);
-                precostMatrix.resize(erase_idx);
+                EvaluateMergePairs(cvxs, supports, pairs, costs, params, dist_limit);
+                for (int idx = 0; idx < (int)pairs.size(); ++idx)
+                    if (costs[idx] < INF)
+                        candidates.push({costs[idx], pairs[idx].first, pairs[idx].second, version[pairs[idx].first], version[pairs[idx].second]});
             }
+
+            vector<Model> merged;
+            for (int i = 0; i < nConvexHulls; ++i)
+                if (alive[i])
+                    merged.push_back(cvxs[i]);
+            cvxs = merged;
         }
 
         return h;
     }
 
+    double MergeConvexHulls(Model &m, vector<Model> &meshs, vector<Model> &cvxs, Params &params, double epsilon, double threshold)
+    {
+        logger::info(" - Merge Convex Hulls");
+        return MergeHulls(meshs, cvxs, NULL, params, threshold);
+    }
+
+    double MergeConvexHulls(Model &m, vector<Model> &meshs, vector<Model> &cvxs, PartGraph &graph, Params &params, double epsilon, double threshold)
+    {
+        logger::info(" - Merge Convex Hulls (part graph, {} contacts)", graph.contacts.size());
+        return MergeHulls(meshs, cvxs, &graph, params, threshold);
+    }
+
     void ExtrudeCH(Model &ch, Plane overlap_plane, Params &params, double margin)
     {
         vec3d normal = {overlap_plane.a, overlap_plane.b, overlap_plane.c};
@@ -385,36 +603,144 @@ namespace coacd
         ch = tmp;
     }
 
+    static bool SamePlane(const Plane &p, const Plane &q)
+    {
+        double dot = p.a * q.a + p.b * q.b + p.c * q.c;
+        return fabs(dot) > 1 - 1e-6 && fabs(p.d - (dot > 0 ? q.d : -q.d)) < 1e-6;
+    }
+
     void ExtrudeConvexHulls(vector<Model> &cvxs, Params &params, double eps)
     {
         logger::info(" - Extrude Convex Hulls");
-        for (int i = 0; i < (int)cvxs.size(); i++)
+        const int n = (int)cvxs.size();
+
+        // Broad phase: hulls whose vertices come within eps have boxes within eps
+        vector<array<double, 6>> boxes(n);
+        for (int i = 0; i < n; i++)
+            boxes[i] = HullBox(cvxs[i]);
+        vector<int> order(n);
+        for (int i = 0; i < n; i++)
+            order[i] = i;
+        std::sort(order.begin(), order.end(), [&](int a, int b)
+                  { return boxes[a][0] < boxes[b][0]; });
+        vector<pair<int, int>> pairs;
+        for (int i = 0; i < n; i++)
+            for (int j = i + 1; j < n && boxes[order[j]][0] - boxes[order[i]][3] <= eps; j++)
+                if (BoxesWithin(boxes[order[i]], boxes[order[j]], eps))
+                    pairs.push_back({min(order[i], order[j]), max(order[i], order[j])});
+        std::sort(pairs.begin(), pairs.end());
+
+        // Narrow phase on the hulls as they are: touching pairs and the face plane between them
+        vector<char> touching(pairs.size(), 0);
+        vector<Plane> planes(pairs.size());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) default(none) shared(cvxs, pairs, touching, planes, eps)
+#endif
+        for (int idx = 0; idx < (int)pairs.size(); idx++)
+        {
+            Model &convex1 = cvxs[pairs[idx].first], &convex2 = cvxs[pairs[idx].second];
+            if (MeshDist(convex1, convex2) >= eps)
+                continue;
+            // only extrude the convex hulls along the normal of overlap plane
+            touching[idx] = ComputeOverlapFace(convex1, convex2, planes[idx]) || ComputeOverlapFace(convex2, convex1, planes[idx]);
+        }
+
+        // Every hull is extruded once per distinct contact plane, independently of the others
+        vector<vector<Plane>> extrusions(n);
+        for (int idx = 0; idx < (int)pairs.size(); idx++)
         {
-            Model cvx = cvxs[i];
-            for (int j = 0; j < (int)cvxs.size(); j++)
+            if (!touching[idx])
+                continue;
+            for (int h : {pairs[idx].first, pairs[idx].second})
             {
-                Model convex1 = cvxs[i], convex2 = cvxs[j];
-                Plane overlap_plane;
+                bool seen = false;
+                for (const Plane &p : extrusions[h])
+                    seen = seen || SamePlane(p, planes[idx]);
+                if (!seen)
+                    extrusions[h].push_back(planes[idx]);
+            }
+        }
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) default(none) shared(cvxs, extrusions, params, n)
+#endif
+        for (int i = 0; i < n; i++)
+            for (const Plane &p : extrusions[i])
+                ExtrudeCH(cvxs[i], p, params, params.extrude_margin);
+    }
 
-                double dist = MeshDist(convex1, convex2);
-                bool flag = ComputeOverlapFace(convex1, convex2, overlap_plane);
+    // A part's share of an earlier cut: the cut, which half the part descends from, and the box of its faces on that plane
+    struct CutFace
+    {
+        int cut;
+        bool pos;
+        Plane plane;
+        array<double, 6> box;
+    };
+
+    // Ids of the triangles of part lying on each plane. Every vertex is tested once per plane and marked in a
+    // bit set, so a triangle lies on the planes all three of its vertices are marked for.
+    static vector<vector<int>> FacesOnPlanes(const Model &part, vector<Plane> &planes)
+    {
+        int nPoints = (int)part.points.size(), words = ((int)planes.size() + 63) / 64;
+        vector<uint64_t> on((size_t)nPoints * words, 0);
+        for (int k = 0; k < (int)planes.size(); k++)
+            for (int v = 0; v < nPoints; v++)
+                if (planes[k].Side(part.points[v]) == 0)
+                    on[(size_t)v * words + k / 64] |= uint64_t(1) << (k % 64);
+
+        vector<vector<int>> faces(planes.size());
+        for (int i = 0; i < (int)part.triangles.size(); i++)
+        {
+            const vec3i &tri = part.triangles[i];
+            for (int w = 0; w < words; w++)
+                for (uint64_t m = on[(size_t)tri[0] * words + w] & on[(size_t)tri[1] * words + w] & on[(size_t)tri[2] * words + w]; m; m &= m - 1)
+                    faces[w * 64 + std::countr_zero(m)].push_back(i);
+        }
+        return faces;
+    }
 
-                // only extrude the convex hulls along the normal of overlap plane
-                if (dist < eps && flag)
+    // Box of the vertices of part's triangles in faces, laid out as HullBox
+    static array<double, 6> FacesBox(const Model &part, const vector<int> &faces)
+    {
+        array<double, 6> box = {INF, INF, INF, -INF, -INF, -INF};
+        for (int i : faces)
+            for (int j = 0; j < 3; j++)
+            {
+                const vec3d &p = part.points[part.triangles[i][j]];
+                for (int k = 0; k < 3; k++)
                 {
-                    ExtrudeCH(convex1, overlap_plane, params, params.extrude_margin);
-                    cvxs[i] = convex1;
-                    ExtrudeCH(convex2, overlap_plane, params, params.extrude_margin);
-                    cvxs[j] = convex2;
+                    box[k] = min(box[k], p[k]);
+                    box[k + 3] = max(box[k + 3], p[k]);
                 }
             }
-        }
+        return box;
+    }
+
+    // The cut faces of a clipped part that one of its halves still touches, found in one pass together with the
+    // half's cap on the new plane; cap gets the ids of the cap triangles
+    static void InheritCutFaces(Model &half, vector<CutFace> &parent_faces, Plane plane, vector<CutFace> &half_faces, vector<int> &cap)
+    {
+        vector<Plane> planes;
+        for (const CutFace &face : parent_faces)
+            planes.push_back(face.plane);
+        planes.push_back(plane);
+        vector<vector<int>> faces = FacesOnPlanes(half, planes);
+        for (int k = 0; k < (int)parent_faces.size(); k++)
+            if ((int)faces[k].size() > 0)
+                half_faces.push_back({parent_faces[k].cut, parent_faces[k].pos, parent_faces[k].plane, FacesBox(half, faces[k])});
+        cap = std::move(faces.back());
     }
 
     vector<Model> Compute(Model &mesh, Params &params)
     {
-        vector<Model> InputParts = {mesh};
+        vector<MeshHandle> InputParts = {MeshHandle(mesh)};
         vector<Model> parts, pmeshs;
+        // Every cut, and for every pending / final part the cut faces it still touches
+        PartGraph graph;
+        vector<vector<CutFace>> InputFaces(1), leafFaces;
+        // Scratch memory of this call only, freed when it returns
+        ArenaSet arenas;
+        ArenaBinding scratch_arena(&arenas);
 #ifdef _OPENMP
         omp_lock_t writelock;
         omp_init_lock(&writelock);
@@ -428,26 +754,32 @@ namespace coacd
         logger::info("# Points: {}", mesh.points.size());
         logger::info("# Triangles: {}", mesh.triangles.size());
         logger::info(" - Decomposition (MCTS)");
+        ResetCapStats();
+        ResetModelCopies();
 
         size_t iter = 0;
         double cut_area;
         while ((int)InputParts.size() > 0)
         {
-            vector<Model> tmp;
+            vector<MeshHandle> tmp;
+            vector<vector<CutFace>> tmpFaces;
             logger::info("iter {} ---- waiting pool: {}", iter, InputParts.size());
+            // a lone part leaves the threads to the data-parallel clips and hulls it runs
 #ifdef _OPENMP
-#pragma omp parallel for default(none) shared(InputParts, params, mesh, writelock, parts, pmeshs, tmp) private(cut_area)
+#pragma omp parallel for default(none) shared(InputParts, InputFaces, params, mesh, writelock, parts, pmeshs, leafFaces, graph, tmp, tmpFaces, arenas) private(cut_area) if (InputParts.size() > 1)
 #endif
             for (int p = 0; p < (int)InputParts.size(); p++)
             {
                 random_engine.seed(params.seed);
+                ArenaBinding part_arena(&arenas);
                 if (p % ((int)InputParts.size() / 10 + 1) == 0)
                     logger::info("Processing [{:.1f}%]", p * 100.0 / (int)InputParts.size());
 
-                Model pmesh = InputParts[p], pCH;
+                const Model &pmesh = *InputParts[p];
+                Model pCH;
                 Plane bestplane;
                 pmesh.ComputeAPX(pCH, params.apx_mode, true);
-                double h = ComputeHCost(pmesh, pCH, params.rv_k, params.resolution, params.seed, 0.0001, false);
+                double h = ComputeHCost(pmesh, pCH, params);
 
                 if (h > params.threshold)
                 {
@@ -455,17 +787,17 @@ namespace coacd
 
                     // MCTS for cutting plane
                     Node *node = new Node(params);
-                    State state(params, pmesh);
-                    node->set_state(state);
+                    node->set_state(State(params, InputParts[p]));
                     Node *best_next_node = MonteCarloTreeSearch(params, node, best_path);
                     if (best_next_node == NULL)
                     {
+                        free_tree(node, 0); // drops the search's handles, so the part can move out of InputParts
 #ifdef _OPENMP
                         omp_set_lock(&writelock);
 #endif
-                        parts.push_back(pCH);
-                        pmeshs.push_back(pmesh);
-                        free_tree(node, 0);
+                        parts.push_back(std::move(pCH));
+                        pmeshs.push_back(InputParts[p].Release());
+                        leafFaces.push_back(InputFaces[p]);
 #ifdef _OPENMP
                         omp_unset_lock(&writelock);
 #endif
@@ -484,13 +816,30 @@ namespace coacd
                             logger::error("Wrong clip proposal!");
                             exit(0);
                         }
+                        vector<CutFace> posFaces, negFaces;
+                        vector<int> posCap, negCap;
+                        InheritCutFaces(pos, InputFaces[p], bestplane, posFaces, posCap);
+                        InheritCutFaces(neg, InputFaces[p], bestplane, negFaces, negCap);
+                        array<double, 6> posBox = FacesBox(pos, posCap), negBox = FacesBox(neg, negCap);
 #ifdef _OPENMP
                         omp_set_lock(&writelock);
 #endif
+                        int cut = (int)graph.cuts.size();
+                        if ((int)posCap.size() > 0)
+                            posFaces.push_back({cut, true, bestplane, posBox});
+                        if ((int)negCap.size() > 0)
+                            negFaces.push_back({cut, false, bestplane, negBox});
+                        graph.cuts.push_back({bestplane, std::move(posCap), std::move(negCap)});
                         if ((int)pos.triangles.size() > 0)
-                            tmp.push_back(pos);
+                        {
+                            tmp.push_back(std::move(pos));
+                            tmpFaces.push_back(posFaces);
+                        }
                         if ((int)neg.triangles.size() > 0)
-                            tmp.push_back(neg);
+                        {
+                            tmp.push_back(std::move(neg));
+                            tmpFaces.push_back(negFaces);
+                        }
 #ifdef _OPENMP
                         omp_unset_lock(&writelock);
 #endif
@@ -501,27 +850,62 @@ namespace coacd
 #ifdef _OPENMP
                     omp_set_lock(&writelock);
 #endif
-                    parts.push_back(pCH);
-                    pmeshs.push_back(pmesh);
+                    parts.push_back(std::move(pCH));
+                    pmeshs.push_back(InputParts[p].Release());
+                    leafFaces.push_back(InputFaces[p]);
 #ifdef _OPENMP
                     omp_unset_lock(&writelock);
 #endif
                 }
             }
             logger::info("Processing [100.0%]");
-            InputParts.clear();
-            InputParts = tmp;
+            InputParts = std::move(tmp);
+            InputFaces = tmpFaces;
             tmp.clear();
             iter++;
         }
+
+        // Final parts on opposite sides of a cut still share part of its cap where their faces on the plane overlap.
+        // Sweep and prune along x per cut: only faces whose x ranges come within the tolerance get a box test.
+        vector<vector<pair<int, int>>> onCut(graph.cuts.size());
+        for (int i = 0; i < (int)leafFaces.size(); i++)
+            for (int k = 0; k < (int)leafFaces[i].size(); k++)
+                onCut[leafFaces[i][k].cut].push_back({i, k});
+        for (int c = 0; c < (int)onCut.size(); c++)
+        {
+            vector<pair<int, int>> &faces = onCut[c];
+            auto face = [&](int idx) -> const CutFace &
+            { return leafFaces[faces[idx].first][faces[idx].second]; };
+            std::sort(faces.begin(), faces.end(), [&](const pair<int, int> &a, const pair<int, int> &b)
+                      { return leafFaces[a.first][a.second].box[0] < leafFaces[b.first][b.second].box[0]; });
+            for (int a = 0; a < (int)faces.size(); a++)
+                for (int b = a + 1; b < (int)faces.size() && face(b).box[0] - face(a).box[3] <= 1e-6; b++)
+                    if (face(a).pos != face(b).pos && BoxesWithin(face(a).box, face(b).box, 1e-6))
+                    {
+                        int pos = face(a).pos ? a : b, neg = face(a).pos ? b : a;
+                        graph.contacts.push_back({faces[pos].first, faces[neg].first, c});
+                    }
+        }
+        logger::info("# Cuts: {}, # Part Contacts: {}", graph.cuts.size(), graph.contacts.size());
+        CapStats caps = GetCapStats();
+        logger::info("# Cut Caps: {} fan, {} ear clipping, {} CDT", caps.fan, caps.ear, caps.cdt);
+
         if (params.merge)
-            MergeConvexHulls(mesh, pmeshs, parts, params);
+        {
+            if (params.merge_mode == "graph")
+                MergeConvexHulls(mesh, pmeshs, parts, graph, params);
+            else
+                MergeConvexHulls(mesh, pmeshs, parts, params);
+        }
 
         if (params.decimate)
             DecimateConvexHulls(parts, params);
 
         if (params.extrude)
             ExtrudeConvexHulls(parts, params);
+        logger::info("# Mesh Copies: {}", GetModelCopies());
+        ArenaStats scratch = arenas.Stats();
+        logger::info("# Scratch Allocations: {} in {} chunks, peak {} KB per thread", scratch.allocations, scratch.chunks, scratch.peak_bytes >> 10);
 
 #ifdef _OPENMP
         end = omp_get_wtime();
@@ -25,24 +25,61 @@ namespace coacd
 {
   extern thread_local std::mt19937 random_engine;
 
+  // A cut made during Compute: its plane and the ids of the cap triangles it left on the pos / neg half as clipped
+  struct PartCut
+  {
+    Plane plane;
+    vector<int> pos_faces, neg_faces;
+  };
+
+  // Two final parts that still share part of a cut's cap; part1/part2 index Compute's part list
+  struct PartContact
+  {
+    int part1, part2;
+    int cut;
+  };
+
+  // Sparse adjacency of the decomposition, linear in the number of contacts
+  struct PartGraph
+  {
+    vector<PartCut> cuts;
+    vector<PartContact> contacts;
+  };
+
+  // What CheckManifold found wrong with a mesh; edges are directed (from, to) vertex pairs
+  struct ManifoldReport
+  {
+    vector<pair<int, int>> duplicate_edges; // used by more than one triangle, so orientation is inconsistent
+    vector<pair<int, int>> open_edges;      // no triangle runs along the edge the other way
+    vector<pair<int, int>> intersections;   // triangle pairs (i < j) that cross without sharing a vertex
+    bool reversed = false;                  // all triangles were flipped to give a positive volume
+
+    bool Manifold() const { return duplicate_edges.empty() && open_edges.empty() && intersections.empty(); }
+  };
+
+  // What WeldVertices merged and removed
+  struct WeldReport
+  {
+    int welded = 0;     // points merged into an earlier point
+    int degenerate = 0; // triangles left with a repeated point
+    int duplicate = 0;  // triangles over the same three points as an earlier one
+    int unused = 0;     // points no triangle referenced
+
+    bool Changed() const { return welded || degenerate || duplicate || unused; }
+  };
+
   void DecimateCH(Model &ch, int tgt_pts, string apx_mode);
+  void BudgetCH(Model &ch, int tgt_pts, string apx_mode);
   void DecimateConvexHulls(vector<Model> &cvxs, Params &params);
-  void MergeCH(Model &ch1, Model &ch2, Model &ch, Params &params);
+  double MergeCH(Model &ch1, Model &ch2, Model &ch, Params &params);
   double MergeConvexHulls(Model &m, vector<Model> &meshs, vector<Model> &cvxs, Params &params, double epsilon = 0.02, double threshold = 0.01);
+  double MergeConvexHulls(Model &m, vector<Model> &meshs, vector<Model> &cvxs, PartGraph &graph, Params &params, double epsilon = 0.02, double threshold = 0.01);
   void ExtrudeCH(Model &ch, Plane overlap_plane, Params &params, double margin = 0.01);
   void ExtrudeConvexHulls(vector<Model> &cvxs, Params &params, double eps = 1e-4);
       vector<Model> Compute(Model &mesh, Params &params);
   bool IsManifold(Model &input);
-
-  inline void addNeighbor(map<pair<int, int>, pair<int, int>> &edge_map, pair<int, int> &edge, vector<int> &neighbors, int idx)
-  {
-    int first = edge_map[edge].first;
-    int second = edge_map[edge].second;
-    if (first != idx && first != -1)
-      neighbors.push_back(first);
-    if (second != idx && second != -1)
-      neighbors.push_back(second);
-  }
+  ManifoldReport CheckManifold(Model &input, bool exhaustive = false);
+  WeldReport WeldVertices(Model &input, double tolerance = 1e-6);
 
   inline int32_t FindMinimumElement(const vector<double> d, double *const m, const int32_t begin, const int32_t end)
   {
@@ -0,0 +1,26 @@
+#pragma once
+#include <memory>
+
+#include "model_obj.h"
+
+namespace coacd
+{
+    // Narrow-band signed distance field of a mesh, built with OpenVDB (WITH_3RD_PARTY_LIBS only). Distances farther
+    // than the band from the surface come back clamped to just beyond it.
+    class DistanceField
+    {
+    public:
+        DistanceField(const Model &mesh, double voxel_size, double band);
+        ~DistanceField();
+        DistanceField(const DistanceField &) = delete;
+        DistanceField &operator=(const DistanceField &) = delete;
+
+        double Distance(const vec3d &p) const; // unsigned, trilinear, error <= sqrt(3)/2 * voxel_size
+
+        const double voxel_size, band;
+
+    private:
+        struct Grid;
+        std::unique_ptr<Grid> grid;
+    };
+}
@@ -156,4 +156,77 @@ namespace coacd
             q[3] /= mq;
         }
     }
+
+    void PointsSoA::assign(const vector<vec3d> &points)
+    {
+        const size_t n = points.size();
+        x.resize(n);
+        y.resize(n);
+        z.resize(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            x[i] = (float)points[i][0];
+            y[i] = (float)points[i][1];
+            z[i] = (float)points[i][2];
+        }
+    }
+
+    void HalfEdges::Build(const vector<vec3i> &triangles)
+    {
+        const int H = 3 * (int)triangles.size();
+        auto from = [&](int h) { return triangles[h / 3][h % 3]; };
+        auto to = [&](int h) { return triangles[h / 3][(h + 1) % 3]; };
+        int V = 0;
+        for (const vec3i &t : triangles)
+            V = max(V, max(t[0], max(t[1], t[2])) + 1);
+
+        // counting sort by the source vertex, then the few edges of each vertex by their target
+        offsets.assign(V + 1, 0);
+        for (int h = 0; h < H; h++)
+            offsets[from(h) + 1]++;
+        for (int v = 0; v < V; v++)
+            offsets[v + 1] += offsets[v];
+        vector<int> fill(offsets.begin(), offsets.end() - 1);
+        order.resize(H);
+        for (int h = 0; h < H; h++)
+            order[fill[from(h)]++] = h;
+        keys.resize(H);
+        for (int v = 0; v < V; v++)
+        {
+            if (offsets[v + 1] - offsets[v] > 16)
+                std::sort(order.begin() + offsets[v], order.begin() + offsets[v + 1], [&](int a, int b)
+                          { return to(a) != to(b) ? to(a) < to(b) : a < b; });
+            else
+                for (int i = offsets[v] + 1; i < offsets[v + 1]; i++)
+                    for (int j = i; j > offsets[v] && to(order[j]) < to(order[j - 1]); j--)
+                        std::swap(order[j], order[j - 1]);
+            for (int i = offsets[v]; i < offsets[v + 1]; i++)
+                keys[i] = Key(v, to(order[i]));
+        }
+
+        // pair every directed edge used once with its reverse, if that is used once too
+        twin.assign(H, -1);
+        for (int i = 0; i < H; i++)
+        {
+            if ((i > 0 && keys[i] == keys[i - 1]) || (i + 1 < H && keys[i] == keys[i + 1]))
+                continue;
+            const int v = To(keys[i]), w = From(keys[i]);
+            int match = -1;
+            for (int j = offsets[v]; j < offsets[v + 1] && To(keys[j]) <= w; j++)
+                if (To(keys[j]) == w)
+                    match = match == -1 ? j : -2;
+            if (match >= 0)
+                twin[order[i]] = order[match];
+        }
+    }
+
+    int HalfEdges::Find(int from, int to) const
+    {
+        if (from < 0 || from + 1 >= (int)offsets.size())
+            return -1;
+        for (int i = offsets[from]; i < offsets[from + 1] && To(keys[i]) <= to; i++)
+            if (To(keys[i]) == to)
+                return order[i];
+        return -1;
+    }
 }
\ No newline at end of file
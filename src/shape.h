@@ -20,6 +20,8 @@
 #include <unordered_set>
 #include <utility>
 #include <array>
+#include <cstdint>
+#include <memory_resource>
 #include <limits>
 
 using std::vector;
@@ -40,10 +42,25 @@ namespace coacd
     using vec3s = std::array<short, 3>;
     constexpr double INF = std::numeric_limits<double>::max();
 
-    struct HalfEdge
+    // Edge adjacency of a triangle mesh in flat arrays. Half-edge 3 * t + k runs from corner k of triangle t to
+    // corner k + 1. The directed edges are bucketed by their source vertex in linear time, so finding an edge scans
+    // only the few edges leaving one vertex.
+    struct HalfEdges
     {
-        int head;
-        std::list<HalfEdge>::iterator opposite;
+        vector<uint64_t> keys; // directed edge keys, sorted
+        vector<int> order;     // half-edge of each key
+        vector<int> offsets;   // first key of each source vertex
+        vector<int> twin;      // opposite half-edge; -1 on open edges and on edges used more than once per direction
+
+        HalfEdges() = default;
+        explicit HalfEdges(const vector<vec3i> &triangles) { Build(triangles); }
+        void Build(const vector<vec3i> &triangles);
+        int Find(int from, int to) const; // the first half-edge running from -> to, or -1
+
+        static uint64_t Key(int from, int to) { return ((uint64_t)(uint32_t)from << 32) | (uint32_t)to; }
+        static int From(uint64_t key) { return (int)(uint32_t)(key >> 32); }
+        static int To(uint64_t key) { return (int)(uint32_t)key; }
+        static int Face(int h) { return h / 3; }
     };
 
     class Edge
@@ -149,48 +166,23 @@ namespace coacd
         return false;
     }
 
-    template <typename T>
-    struct PointCloud
+    // Single-precision copy of a point set in structure-of-arrays layout, for KD-trees and bulk distance scans that
+    // do not need double precision: half the bytes of vec3d, and each coordinate is a contiguous float stream.
+    // Temporary copies can live in a scratch arena by passing its resource.
+    struct PointsSoA
     {
-        struct Point
-        {
-            T x, y, z;
-        };
-
-        std::vector<Point> pts;
-
-        // Must return the number of data points
-        inline size_t kdtree_get_point_count() const { return pts.size(); }
+        std::pmr::vector<float> x, y, z;
 
-        // Returns the dim'th component of the idx'th point in the class:
-        // Since this is inlined and the "dim" argument is typically an immediate value, the
-        //  "if/else's" are actually solved at compile time.
-        inline T kdtree_get_pt(const size_t idx, const size_t dim) const
-        {
-            if (dim == 0)
-                return pts[idx].x;
-            else if (dim == 1)
-                return pts[idx].y;
-            else
-                return pts[idx].z;
-        }
+        PointsSoA() = default;
+        explicit PointsSoA(const vector<vec3d> &points, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+            : x(resource), y(resource), z(resource) { assign(points); }
+        void assign(const vector<vec3d> &points);
+        size_t size() const { return x.size(); }
 
-        // Optional bounding-box computation: return false to default to a standard bbox computation loop.
-        //   Return true if the BBOX was already computed by the class and returned in "bb" so it can be avoided to redo it again.
-        //   Look at bb.size() to find out the expected dimensionality (e.g. 2 or 3 for point clouds)
+        // nanoflann dataset interface
+        inline size_t kdtree_get_point_count() const { return x.size(); }
+        inline float kdtree_get_pt(const size_t idx, const size_t dim) const { return dim == 0 ? x[idx] : dim == 1 ? y[idx] : z[idx]; }
         template <class BBOX>
         bool kdtree_get_bbox(BBOX & /* bb */) const { return false; }
     };
-
-    template <typename T>
-    void vec2PointCloud(PointCloud<T> &point, vector<vec3d> V)
-    {
-        point.pts.resize(V.size());
-        for (size_t i = 0; i < V.size(); i++)
-        {
-            point.pts[i].x = V[i][0];
-            point.pts[i].y = V[i][1];
-            point.pts[i].z = V[i][2];
-        }
-    }
 }
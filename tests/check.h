@@ -0,0 +1,41 @@
+#pragma once
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+// Assertions of the tests: a failed check is printed and counted, and main returns TestResult()
+static int test_failures = 0;
+
+#define CHECK(cond)                                                                     \
+    do                                                                                  \
+    {                                                                                   \
+        if (!(cond))                                                                    \
+        {                                                                               \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);             \
+            test_failures++;                                                            \
+        }                                                                               \
+    } while (0)
+
+#define CHECK_NEAR(a, b, tol)                                                           \
+    do                                                                                  \
+    {                                                                                   \
+        double check_a = (a), check_b = (b);                                            \
+        if (!(std::fabs(check_a - check_b) <= (tol)))                                   \
+        {                                                                               \
+            printf("%s:%d: CHECK_NEAR(%s, %s) failed: %.17g vs %.17g\n", __FILE__, __LINE__, #a, #b, check_a, check_b); \
+            test_failures++;                                                            \
+        }                                                                               \
+    } while (0)
+
+// Path of a fixture, given the data directory passed as the first argument
+inline std::string Fixture(int argc, char **argv, const std::string &name)
+{
+    return std::string(argc > 1 ? argv[1] : "data") + "/" + name;
+}
+
+inline int TestResult()
+{
+    if (test_failures)
+        printf("%d check(s) failed\n", test_failures);
+    return test_failures ? 1 : 0;
+}
@@ -0,0 +1,118 @@
+// Cut caps of Clip on a convex part, a part with a hole and a box whose border has collinear runs: both parts stay
+// closed 2-manifolds, the cap triangles add up to cut_area and the expected triangulation tier is used
+#include "check.h"
+#include "clip.h"
+#include "process.h"
+
+using namespace coacd;
+
+// Octahedron |x| + |y| + |z| <= 1, counter-clockwise seen from outside
+static Model Octahedron()
+{
+    Model m;
+    m.points = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+    for (int sx = 0; sx < 2; sx++)
+        for (int sy = 0; sy < 2; sy++)
+            for (int sz = 0; sz < 2; sz++)
+            {
+                if ((sx + sy + sz) % 2 == 0)
+                    m.triangles.push_back({sx, 2 + sy, 4 + sz});
+                else
+                    m.triangles.push_back({sx, 4 + sz, 2 + sy});
+            }
+    return m;
+}
+
+// Square frame between |x|, |y| <= 1 and |x|, |y| <= 2 for |z| <= 1: a box with a square hole along z
+static Model Frame()
+{
+    Model m;
+    const double corners[4][2] = {{1, 1}, {-1, 1}, {-1, -1}, {1, -1}}; // counter-clockwise seen from +z
+    for (double scale : {2.0, 1.0})
+        for (double z : {-1.0, 1.0})
+            for (const auto &c : corners)
+                m.points.push_back({scale * c[0], scale * c[1], z});
+    auto quad = [&](int a, int b, int c, int d)
+    {
+        m.triangles.push_back({a, b, c});
+        m.triangles.push_back({a, c, d});
+    };
+    for (int i = 0; i < 4; i++)
+    {
+        const int j = (i + 1) % 4;
+        const int outer_bottom = 0, outer_top = 4, inner_bottom = 8, inner_top = 12;
+        quad(outer_bottom + i, outer_bottom + j, outer_top + j, outer_top + i);
+        quad(inner_bottom + j, inner_bottom + i, inner_top + i, inner_top + j);
+        quad(outer_top + i, outer_top + j, inner_top + j, inner_top + i);
+        quad(outer_bottom + j, outer_bottom + i, inner_bottom + i, inner_bottom + j);
+    }
+    return m;
+}
+
+// Area of the triangles of part lying in the plane, and the smallest of them
+static double CapArea(const Model &part, const Plane &plane, double &smallest)
+{
+    auto on = [&](const vec3d &p) { return fabs(plane.a * p[0] + plane.b * p[1] + plane.c * p[2] + plane.d) < 1e-12; };
+    double area = 0;
+    smallest = INF;
+    for (const vec3i &t : part.triangles)
+        if (on(part.points[t[0]]) && on(part.points[t[1]]) && on(part.points[t[2]]))
+        {
+            double a = Area(part.points[t[0]], part.points[t[1]], part.points[t[2]]);
+            area += a;
+            smallest = min(smallest, a);
+        }
+    return area;
+}
+
+// Clips mesh and checks both parts; returns the area of the smallest cap triangle
+static double CheckCut(const Model &mesh, Plane plane, double expected_area, CapStats expected)
+{
+    Model input = mesh;
+    CHECK(IsManifold(input));
+
+    ResetCapStats();
+    Model pos, neg;
+    double cut_area = 0;
+    CHECK(Clip(mesh, pos, neg, plane, cut_area));
+    CapStats stats = GetCapStats();
+    CHECK(stats.fan == expected.fan && stats.ear == expected.ear && stats.cdt == expected.cdt);
+
+    CHECK(CheckManifold(pos, true).Manifold());
+    CHECK(CheckManifold(neg, true).Manifold());
+    CHECK_NEAR(cut_area, expected_area, 1e-12);
+    double smallest, neg_smallest;
+    CHECK_NEAR(CapArea(pos, plane, smallest), cut_area, 1e-12);
+    CHECK_NEAR(CapArea(neg, plane, neg_smallest), cut_area, 1e-12);
+    CHECK_NEAR(MeshVolume(pos) + MeshVolume(neg), MeshVolume(mesh), 1e-12);
+    return min(smallest, neg_smallest);
+}
+
+static void TestConvex()
+{
+    // The section at z = 0.2 is the square |x| + |y| <= 0.8, one strictly convex loop: a fan from a corner
+    CheckCut(Octahedron(), Plane(0, 0, 1, -0.2), 2 * 0.8 * 0.8, {1, 0, 0});
+}
+
+static void TestHole()
+{
+    // The section at z = 0.25 is a square annulus, an outer loop with one hole: ear clipping after a bridge
+    CheckCut(Frame(), Plane(0, 0, 1, -0.25), 16 - 4, {0, 1, 0});
+}
+
+static void TestCollinear(const string &path)
+{
+    // Every side face diagonal of the box crosses x = 0.3, so each side of the square section has a point in its
+    // middle; a corner fan would leave zero-area triangles along those runs, the fan from the centre does not
+    Model box;
+    CHECK(box.LoadOBJ(path));
+    CHECK(CheckCut(box, Plane(1, 0, 0, -0.3), 4, {1, 0, 0}) > 0.1);
+}
+
+int main(int argc, char **argv)
+{
+    TestConvex();
+    TestHole();
+    TestCollinear(Fixture(argc, argv, "box.obj"));
+    return TestResult();
+}
@@ -0,0 +1,210 @@
+// Orient3D exactness and ComputeHull on fixtures and generated clouds: every point on or below every face, a closed
+// counter-clockwise 2-manifold, and the expected counts and volume
+#include <map>
+#include <random>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "check.h"
+#include "hull.h"
+#include "model_obj.h"
+
+using namespace coacd;
+
+// Six times the signed volume: positive for a closed surface counter-clockwise seen from outside
+static double SignedVolume6(const vector<vec3d> &points, const vector<vec3i> &triangles)
+{
+    double volume = 0;
+    for (const vec3i &t : triangles)
+    {
+        const vec3d &a = points[t[0]], &b = points[t[1]], &c = points[t[2]];
+        volume += a[0] * (b[1] * c[2] - b[2] * c[1]) - a[1] * (b[0] * c[2] - b[2] * c[0]) + a[2] * (b[0] * c[1] - b[1] * c[0]);
+    }
+    return volume;
+}
+
+// Each directed edge once and its reverse once, every vertex used, V - E + F = 2, no point above a face
+static void CheckHull(const vector<vec3d> &input, const vector<vec3d> &points, const vector<vec3i> &triangles)
+{
+    std::map<std::pair<int, int>, int> edges;
+    vector<bool> used(points.size(), false);
+    for (const vec3i &t : triangles)
+        for (int k = 0; k < 3; k++)
+        {
+            edges[{t[k], t[(k + 1) % 3]}]++;
+            used[t[k]] = true;
+        }
+    bool closed = true;
+    for (const auto &[edge, count] : edges)
+        closed = closed && count == 1 && edges.count({edge.second, edge.first}) && edges.at({edge.second, edge.first}) == 1;
+    CHECK(closed);
+    CHECK(std::find(used.begin(), used.end(), false) == used.end());
+    CHECK((long)points.size() - (long)edges.size() / 2 + (long)triangles.size() == 2);
+    CHECK(SignedVolume6(points, triangles) > 0);
+
+    int above = 0;
+    for (const vec3i &t : triangles)
+        for (const vec3d &p : input)
+            above += Orient3D(points[t[0]], points[t[1]], points[t[2]], p) > 0;
+    CHECK(above == 0);
+}
+
+static void TestOrient3D()
+{
+    // Points of the plane z = x + y at magnitudes where the rounded determinant has no correct sign
+    // (all coordinates are exact binary fractions, so the four points are exactly coplanar)
+    const double x = 12345.5, y = 6789.25, e = 1.0 / 1024;
+    vec3d a = {x, y, x + y}, b = {x + e, y + 3 * e, x + y + 4 * e}, c = {x + 7 * e, y - 5 * e, x + y + 2 * e};
+    vec3d d = {x + 0.125, y + 0.375, x + y + 0.5};
+    CHECK(Orient3D(a, b, c, d) == 0);
+
+    double far_side = Orient3D(a, b, c, {d[0], d[1], d[2] + 1});
+    CHECK(far_side != 0);
+    vec3d up = {d[0], d[1], std::nextafter(d[2], 1e300)}, down = {d[0], d[1], std::nextafter(d[2], -1e300)};
+    CHECK(Orient3D(a, b, c, up) * far_side > 0);
+    CHECK(Orient3D(a, b, c, down) * far_side < 0);
+    // Swapping two vertices flips the sign exactly
+    CHECK(Orient3D(b, a, c, up) * far_side < 0);
+}
+
+static void TestBox(const string &path)
+{
+    Model box;
+    CHECK(box.LoadOBJ(path));
+    CHECK(box.points.size() == 8 && box.triangles.size() == 12);
+
+    // The corners with interior points and points on the faces, edges and corners again
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> unit(-1, 1);
+    vector<vec3d> input = box.points;
+    for (int i = 0; i < 200; i++)
+        input.push_back({unit(rng), unit(rng), unit(rng)});
+    for (int i = 0; i < 200; i++)
+    {
+        vec3d p = {unit(rng), unit(rng), unit(rng)};
+        p[i % 3] = i % 2 ? 1 : -1;
+        input.push_back(p);
+    }
+    input.insert(input.end(), box.points.begin(), box.points.end());
+
+    vector<vec3d> points;
+    vector<vec3i> triangles;
+    CHECK(ComputeHull(input, points, triangles));
+    CHECK(points.size() == 8);
+    CHECK(triangles.size() == 12);
+    CHECK_NEAR(SignedVolume6(points, triangles) / 6, 8.0, 1e-12);
+    CheckHull(input, points, triangles);
+}
+
+static void TestSliver()
+{
+    // 1e-9 thick: the float paths it replaced left points outside
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> unit(-1, 1);
+    vector<vec3d> input;
+    for (int i = 0; i < 500; i++)
+        input.push_back({unit(rng), unit(rng), 1e-9 * unit(rng)});
+
+    vector<vec3d> points;
+    vector<vec3i> triangles;
+    CHECK(ComputeHull(input, points, triangles));
+    CheckHull(input, points, triangles);
+}
+
+static void TestTolerance()
+{
+    // Box corners with points on the faces, each a few ulps outside like the vertices of a cut cap
+    std::mt19937 rng(17);
+    std::uniform_real_distribution<double> unit(-1, 1);
+    vector<vec3d> input;
+    for (int i = 0; i < 8; i++)
+        input.push_back({i & 1 ? 1.0 : -1.0, i & 2 ? 1.0 : -1.0, i & 4 ? 1.0 : -1.0});
+    for (int i = 0; i < 300; i++)
+    {
+        vec3d p = {0.9 * unit(rng), 0.9 * unit(rng), 0.9 * unit(rng)};
+        p[i % 3] = i % 2 ? 1 + 4e-16 * (i % 5) : -1 - 4e-16 * (i % 5);
+        input.push_back(p);
+    }
+
+    vector<vec3d> points;
+    vector<vec3i> triangles;
+    CHECK(ComputeHull(input, points, triangles));
+    CheckHull(input, points, triangles);
+    const size_t exact = points.size();
+
+    // With a tolerance most are left out (the extremes the initial simplex starts from stay), and all of them stay
+    // within it of the hull's planes
+    CHECK(ComputeHull(input, points, triangles, -1, 1e-9));
+    CHECK(points.size() < exact / 4);
+    CHECK_NEAR(SignedVolume6(points, triangles) / 6, 8.0, 1e-12);
+    double outside = 0;
+    for (const vec3i &t : triangles)
+    {
+        const vec3d &a = points[t[0]], &b = points[t[1]], &c = points[t[2]];
+        vec3d n = CrossProduct({b[0] - a[0], b[1] - a[1], b[2] - a[2]}, {c[0] - a[0], c[1] - a[1], c[2] - a[2]});
+        double len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        for (const vec3d &p : input)
+            outside = std::max(outside, (n[0] * (p[0] - a[0]) + n[1] * (p[1] - a[1]) + n[2] * (p[2] - a[2])) / len);
+    }
+    CHECK(outside > 0 && outside <= 1e-9);
+}
+
+static void TestLarge()
+{
+    // Above the parallel cutoff of the point classification, with threads even on one core
+#ifdef _OPENMP
+    omp_set_num_threads(4);
+#endif
+    std::mt19937 rng(13);
+    std::uniform_real_distribution<double> unit(-1, 1);
+    vector<vec3d> input;
+    for (int i = 0; i < 60000; i++)
+        input.push_back({unit(rng), unit(rng), unit(rng)});
+    for (int i = 0; i < 8; i++)
+        input.push_back({i & 1 ? 1.0 : -1.0, i & 2 ? 1.0 : -1.0, i & 4 ? 1.0 : -1.0});
+
+    vector<vec3d> points;
+    vector<vec3i> triangles;
+    CHECK(ComputeHull(input, points, triangles));
+    CHECK(points.size() == 8 && triangles.size() == 12);
+    CHECK_NEAR(SignedVolume6(points, triangles) / 6, 8.0, 1e-12);
+
+    // Points on a sphere: nearly all of them end up on the hull, and the result must not depend on the threads
+    input.clear();
+    std::normal_distribution<double> gauss;
+    for (int i = 0; i < 30000; i++)
+    {
+        double x = gauss(rng), y = gauss(rng), z = gauss(rng), len = sqrt(x * x + y * y + z * z);
+        input.push_back({x / len, y / len, z / len});
+    }
+    CHECK(ComputeHull(input, points, triangles));
+    CheckHull(input, points, triangles);
+#ifdef _OPENMP
+    omp_set_num_threads(1);
+    vector<vec3d> serial_points;
+    vector<vec3i> serial_triangles;
+    CHECK(ComputeHull(input, serial_points, serial_triangles));
+    CHECK(serial_points == points && serial_triangles == triangles);
+#endif
+}
+
+static void TestFlat()
+{
+    vector<vec3d> input = {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {1, 1, 0}, {0.5, 0.25, 0}};
+    vector<vec3d> points;
+    vector<vec3i> triangles;
+    CHECK(!ComputeHull(input, points, triangles));
+    CHECK(!ComputeHull({{0, 0, 0}, {1, 0, 0}, {0, 1, 0}}, points, triangles));
+}
+
+int main(int argc, char **argv)
+{
+    TestOrient3D();
+    TestBox(Fixture(argc, argv, "box.obj"));
+    TestSliver();
+    TestTolerance();
+    TestLarge();
+    TestFlat();
+    return TestResult();
+}
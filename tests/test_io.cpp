@@ -0,0 +1,134 @@
+// Mesh readers on fixtures and generated files: point and triangle counts, indices and volume
+#include <filesystem>
+#include <fstream>
+#include <random>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "check.h"
+#include "io.h"
+
+using namespace coacd;
+
+static void TestObjForms(int argc, char **argv)
+{
+    // Quads with every corner form and negative indices; faces are fanned from their first corner
+    Model cube;
+    CHECK(cube.LoadOBJ(Fixture(argc, argv, "cube_quads.obj")));
+    CHECK(cube.points.size() == 8 && cube.triangles.size() == 12);
+    CHECK(cube.triangles[0] == vec3i({0, 3, 2}) && cube.triangles[1] == vec3i({0, 2, 1}));
+    CHECK(cube.triangles[4] == vec3i({0, 1, 5}));
+    CHECK(cube.triangles[8] == vec3i({2, 3, 7}));
+    CHECK_NEAR(MeshVolume(cube), 8.0, 1e-12);
+    CHECK(cube.bbox[0] == -1 && cube.bbox[1] == 1 && cube.bbox[4] == -1 && cube.bbox[5] == 1);
+
+    // Hexagon caps
+    Model prism;
+    CHECK(prism.LoadOBJ(Fixture(argc, argv, "hexprism.obj")));
+    CHECK(prism.points.size() == 12 && prism.triangles.size() == 20);
+    CHECK_NEAR(MeshVolume(prism), 1.5 * sqrt(3.0), 1e-12);
+
+    Model bad;
+    CHECK(!bad.LoadOBJ(Fixture(argc, argv, "bad_index.obj")));
+    CHECK(bad.points.empty() && bad.triangles.empty());
+    CHECK(!bad.LoadOBJ(Fixture(argc, argv, "missing.obj")));
+}
+
+static void TestObjChunks()
+{
+    // Above the size at which the file is split into chunks parsed by several threads; the second half of the
+    // faces uses negative indices, which must count back from the points of all earlier chunks
+#ifdef _OPENMP
+    omp_set_num_threads(4);
+#endif
+    const int n = 300, m = 150;
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "coacd_test_io_chunks.obj";
+    {
+        std::ofstream os(path);
+        for (int i = 0; i < n; i++)
+            for (int j = 0; j < m; j++)
+                os << "v " << i << " " << j << " " << (i * 7 + j * 3) % 11 << "\n";
+        for (int i = 0; i < n * m; i++)
+            if (i < n * m / 2)
+                os << "f " << i + 1 << " " << (i + 1) % (n * m) + 1 << " " << (i + 2) % (n * m) + 1 << "\n";
+            else
+                os << "f " << i - n * m << " " << (i + 1) % (n * m) - n * m << " " << (i + 2) % (n * m) - n * m << "\n";
+    }
+    CHECK(std::filesystem::file_size(path) >= (1 << 20));
+
+    Model mesh;
+    CHECK(mesh.LoadOBJ(path.string()));
+    CHECK((int)mesh.points.size() == n * m && (int)mesh.triangles.size() == n * m);
+    bool points_ok = true, triangles_ok = true;
+    for (int i = 0; i < n * m && i < (int)mesh.points.size(); i++)
+    {
+        points_ok = points_ok && mesh.points[i] == vec3d({double(i / m), double(i % m), double((i / m * 7 + i % m * 3) % 11)});
+        triangles_ok = triangles_ok && i < (int)mesh.triangles.size() && mesh.triangles[i] == vec3i({i, (i + 1) % (n * m), (i + 2) % (n * m)});
+    }
+    CHECK(points_ok);
+    CHECK(triangles_ok);
+    CHECK(mesh.bbox[1] == n - 1 && mesh.bbox[3] == m - 1 && mesh.bbox[5] == 10);
+    std::filesystem::remove(path);
+#ifdef _OPENMP
+    omp_set_num_threads(1);
+#endif
+}
+
+// Closed 2 x 2 x 2 cube with its eight corners shared by all twelve triangles
+static void CheckCube(const Model &cube)
+{
+    CHECK(cube.points.size() == 8 && cube.triangles.size() == 12);
+    CHECK_NEAR(MeshVolume(cube), 8.0, 1e-12);
+    CHECK(cube.bbox[0] == -1 && cube.bbox[1] == 1 && cube.bbox[2] == -1 && cube.bbox[3] == 1 && cube.bbox[4] == -1 && cube.bbox[5] == 1);
+}
+
+static void TestStl(int argc, char **argv)
+{
+    // The binary header starts with "solid": the file size, not the keyword, tells the two apart
+    for (const char *name : {"cube_binary.stl", "cube_ascii.stl"})
+    {
+        Model cube;
+        CHECK(LoadMesh(Fixture(argc, argv, name), cube));
+        CheckCube(cube);
+    }
+}
+
+static void TestPly(int argc, char **argv)
+{
+    // Quads with an extra colour property: ASCII, float/int little endian and double/uint big endian
+    for (const char *name : {"cube_ascii.ply", "cube_le.ply", "cube_be.ply"})
+    {
+        Model cube;
+        CHECK(LoadMesh(Fixture(argc, argv, name), cube));
+        CheckCube(cube);
+        CHECK(cube.triangles[0] == vec3i({0, 3, 2}) && cube.triangles[11] == vec3i({3, 4, 7}));
+    }
+
+    // The element order is free: faces may index vertices that come after them
+    Model face_first;
+    CHECK(LoadMesh(Fixture(argc, argv, "cube_face_first.ply"), face_first));
+    CheckCube(face_first);
+    CHECK(face_first.triangles[0] == vec3i({0, 3, 2}) && face_first.triangles[11] == vec3i({3, 4, 7}));
+
+    // A vertex count the file cannot hold is rejected before it is allocated
+    Model mesh;
+    CHECK(!LoadPLY(Fixture(argc, argv, "huge_count.ply"), mesh));
+    CHECK(mesh.points.empty() && mesh.points.capacity() == 0);
+
+    // Counts that fit, but a body cut short
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "coacd_test_io_cut.ply";
+    std::filesystem::copy_file(Fixture(argc, argv, "cube_le.ply"), path, std::filesystem::copy_options::overwrite_existing);
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 10);
+    CHECK(!LoadPLY(path.string(), mesh));
+    std::filesystem::remove(path);
+}
+
+int main(int argc, char **argv)
+{
+    TestObjForms(argc, argv);
+    TestObjChunks();
+    TestStl(argc, argv);
+    TestPly(argc, argv);
+    return TestResult();
+}
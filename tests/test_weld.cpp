@@ -0,0 +1,84 @@
+// WeldVertices on a triangle-soup fixture: shared points, dropped faces, the relative tolerance and a manifold result
+#include "check.h"
+#include "process.h"
+
+using namespace coacd;
+
+static void TestSoup(const string &path)
+{
+    Model cube;
+    CHECK(cube.LoadOBJ(path));
+    CHECK(cube.points.size() == 36 && cube.triangles.size() == 12);
+    CHECK(!IsManifold(cube));
+
+    WeldReport report = WeldVertices(cube);
+    CHECK(report.welded == 28 && report.degenerate == 0 && report.duplicate == 0 && report.unused == 0);
+    CHECK(cube.points.size() == 8 && cube.triangles.size() == 12);
+    CHECK_NEAR(MeshVolume(cube), 8.0, 1e-12);
+    CHECK(IsManifold(cube));
+
+    // The points keep the order of their first use
+    CHECK(cube.points[0] == vec3d({-1, -1, -1}) && cube.points[1] == vec3d({-1, 1, -1}) && cube.points[2] == vec3d({1, 1, -1}));
+    CHECK(!WeldVertices(cube).Changed());
+}
+
+static void TestDropped(const string &path)
+{
+    // A repeat of the first triangle in another order, one that collapses to a segment and a point nothing uses
+    Model cube;
+    CHECK(cube.LoadOBJ(path));
+    cube.points.push_back({0.5, 0.5, 0.5});
+    cube.triangles.push_back({cube.triangles[0][1], cube.triangles[0][2], cube.triangles[0][0]});
+    cube.triangles.push_back({0, 3, 3});
+    cube.Invalidate();
+
+    WeldReport report = WeldVertices(cube);
+    CHECK(report.degenerate == 1 && report.duplicate == 1 && report.unused == 1);
+    CHECK(cube.points.size() == 8 && cube.triangles.size() == 12);
+    CHECK_NEAR(MeshVolume(cube), 8.0, 1e-12);
+}
+
+static void TestTolerance(const string &path)
+{
+    // The tolerance is relative to the bounding box diagonal, 2 * sqrt(3) here: copies of a corner moved apart by
+    // less than 1e-6 of it weld, copies 1e-5 of it apart or more do not
+    Model near, far;
+    CHECK(near.LoadOBJ(path) && far.LoadOBJ(path));
+    const double diagonal = 2 * sqrt(3.0);
+    for (int i = 0; i < (int)near.points.size(); i++)
+    {
+        near.points[i][i % 3] += (i % 2 ? 1 : -1) * 4e-7 * diagonal;
+        far.points[i][i % 3] += (i + 1) * 1e-5 * diagonal;
+    }
+    near.Invalidate();
+    far.Invalidate();
+    CHECK(WeldVertices(near).welded == 28 && near.points.size() == 8);
+    CHECK(WeldVertices(far).welded == 0 && far.points.size() == 36);
+}
+
+static void TestBBox(const string &path)
+{
+    // main welds after Normalize(): an unused point at x = 3 widens the normalized box, and dropping it shrinks it
+    Model cube;
+    CHECK(cube.LoadOBJ(path));
+    cube.points.push_back({3, 0, 0});
+    cube.Invalidate();
+    for (int k = 0; k < 6; k++)
+        cube.bbox[k] = cube.GetBounds()[k];
+    cube.Normalize();
+    CHECK(cube.GetBBox()[1] == 1);
+
+    CHECK(WeldVertices(cube).unused == 1);
+    const double expected[6] = {-1, 0, -0.5, 0.5, -0.5, 0.5};
+    for (int k = 0; k < 6; k++)
+        CHECK(cube.GetBBox()[k] == expected[k]);
+}
+
+int main(int argc, char **argv)
+{
+    TestSoup(Fixture(argc, argv, "cube_soup.obj"));
+    TestDropped(Fixture(argc, argv, "cube_soup.obj"));
+    TestTolerance(Fixture(argc, argv, "cube_soup.obj"));
+    TestBBox(Fixture(argc, argv, "cube_soup.obj"));
+    return TestResult();
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "model_obj.h"
+
+// Shared helpers of the benchmarks: timing and generated inputs
+namespace coacd_bench
+{
+    using namespace coacd;
+
+    // Best wall time of `repeat` runs of f, in milliseconds
+    template <class F>
+    double BestOf(int repeat, F &&f)
+    {
+        double best = 1e300;
+        for (int r = 0; r < repeat; r++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            f();
+            best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+
+    // Closed torus of n x m quads, each split into two triangles
+    inline Model Torus(int n, int m, double R = 1.0, double r = 0.35)
+    {
+        Model mesh;
+        for (int i = 0; i < n; i++)
+            for (int j = 0; j < m; j++)
+            {
+                double u = 2 * M_PI * i / n, v = 2 * M_PI * j / m;
+                mesh.points.push_back({(R + r * cos(v)) * cos(u), (R + r * cos(v)) * sin(u), r * sin(v)});
+            }
+        for (int i = 0; i < n; i++)
+            for (int j = 0; j < m; j++)
+            {
+                int a = i * m + j, b = ((i + 1) % n) * m + j, c = ((i + 1) % n) * m + (j + 1) % m, d = i * m + (j + 1) % m;
+                mesh.triangles.push_back({a, b, c});
+                mesh.triangles.push_back({a, c, d});
+            }
+        return mesh;
+    }
+
+    // Points on the surface of an ellipsoid with the given radii
+    inline std::vector<vec3d> Ellipsoid(std::mt19937 &rng, int n, double rx, double ry, double rz)
+    {
+        std::normal_distribution<double> gauss;
+        std::vector<vec3d> points;
+        for (int i = 0; i < n; i++)
+        {
+            double x = gauss(rng), y = gauss(rng), z = gauss(rng), len = sqrt(x * x + y * y + z * z);
+            points.push_back({rx * x / len, ry * y / len, rz * z / len});
+        }
+        return points;
+    }
+
+    // Largest distance of a point outside the triangles' planes (all inside: <= 0)
+    inline double MaxOutside(const std::vector<vec3d> &points, const std::vector<vec3d> &hull_points, const std::vector<vec3i> &hull_triangles)
+    {
+        double worst = -1e300;
+        for (const vec3i &t : hull_triangles)
+        {
+            const vec3d &a = hull_points[t[0]], &b = hull_points[t[1]], &c = hull_points[t[2]];
+            vec3d n = CrossProduct({b[0] - a[0], b[1] - a[1], b[2] - a[2]}, {c[0] - a[0], c[1] - a[1], c[2] - a[2]});
+            double len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            if (len == 0)
+                continue;
+            for (const vec3d &p : points)
+                worst = std::max(worst, (n[0] * (p[0] - a[0]) + n[1] * (p[1] - a[1]) + n[2] * (p[2] - a[2])) / len);
+        }
+        return worst;
+    }
+}
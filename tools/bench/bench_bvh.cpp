@@ -0,0 +1,171 @@
+// Self-intersection check of the manifold test: the binned-SAH BVH with 32-byte nodes (bvh.cpp) against the
+// midpoint-split BVH over a mesh copy it replaced, kept below as LegacyBVH. Both visit every triangle of generated
+// tori and of the meshes given on the command line. Prints build and query ms, the node memory, how many triangles
+// the old check found hitting another one and how many intersecting pairs the new one reports.
+//     bench_bvh [examples/*.obj]
+#include <stdexcept>
+
+#include "bench.h"
+#include "bvh.h"
+#include "io.h"
+
+using namespace coacd_bench;
+
+// BVH before the binned-SAH builder: midpoint splits over a reordered copy of the model, 64-byte double nodes
+struct LegacyBVH
+{
+    struct Node
+    {
+        vec3d aabbMin, aabbMax;
+        int left, right, firstTri, numTri;
+    };
+    Model model;
+    vector<Node> nodes;
+    vector<vec3d> centroids;
+    int nodesUsed = 1;
+
+    LegacyBVH(const Model &_model) : model(_model)
+    {
+        int n = (int)model.triangles.size();
+        nodes.resize(2 * n - 1);
+        centroids.resize(n);
+        for (int i = 0; i < n; i++)
+            for (int j = 0; j < 3; j++)
+                centroids[i][j] = (model.points[model.triangles[i][0]][j] + model.points[model.triangles[i][1]][j] + model.points[model.triangles[i][2]][j]) / 3.0;
+        nodes[0] = {{}, {}, 0, 0, 0, n};
+        Bounds(0);
+        Subdivide(0);
+    }
+
+    void Bounds(int idx)
+    {
+        Node &node = nodes[idx];
+        node.aabbMin = {1e10, 1e10, 1e10};
+        node.aabbMax = {-1e10, -1e10, -1e10};
+        for (int i = node.firstTri; i < node.firstTri + node.numTri; i++)
+            for (int v : model.triangles[i])
+                for (int k = 0; k < 3; k++)
+                {
+                    node.aabbMin[k] = std::min(node.aabbMin[k], model.points[v][k]);
+                    node.aabbMax[k] = std::max(node.aabbMax[k], model.points[v][k]);
+                }
+    }
+
+    void Subdivide(int idx)
+    {
+        Node &node = nodes[idx];
+        if (node.numTri <= 2)
+            return;
+        // widest axis first, falling back to the others when a split leaves one side empty
+        int axes[3] = {0, 1, 2};
+        std::sort(axes, axes + 3, [&](int a, int b)
+                  { return node.aabbMax[a] - node.aabbMin[a] > node.aabbMax[b] - node.aabbMin[b]; });
+        for (int axis : axes)
+        {
+            double split = 0.5 * (node.aabbMin[axis] + node.aabbMax[axis]);
+            int i = node.firstTri, j = i + node.numTri - 1;
+            while (i <= j)
+                if (centroids[i][axis] < split)
+                    i++;
+                else
+                {
+                    std::swap(model.triangles[i], model.triangles[j]);
+                    std::swap(centroids[i], centroids[j--]);
+                }
+            int leftCount = i - node.firstTri;
+            if (leftCount == 0 || leftCount == node.numTri)
+                continue;
+            int left = nodesUsed++, right = nodesUsed++;
+            nodes[left] = {{}, {}, 0, 0, node.firstTri, leftCount};
+            nodes[right] = {{}, {}, 0, 0, i, node.numTri - leftCount};
+            node.left = left, node.right = right, node.numTri = 0;
+            Bounds(left);
+            Bounds(right);
+            Subdivide(left);
+            Subdivide(right);
+            return;
+        }
+    }
+
+    bool Intersect(const vec3i &t0, int idx) const
+    {
+        const Node &node = nodes[idx];
+        for (int k = 0; k < 3; k++)
+        {
+            double lo = std::min({model.points[t0[0]][k], model.points[t0[1]][k], model.points[t0[2]][k]});
+            double hi = std::max({model.points[t0[0]][k], model.points[t0[1]][k], model.points[t0[2]][k]});
+            if (lo > node.aabbMax[k] || hi < node.aabbMin[k])
+                return false;
+        }
+        if (node.numTri == 0)
+            return Intersect(t0, node.left) || Intersect(t0, node.right);
+        for (int i = node.firstTri; i < node.firstTri + node.numTri; i++)
+        {
+            const vec3i &t1 = model.triangles[i];
+            bool shared = false;
+            for (int a : t0)
+                for (int b : t1)
+                    shared |= a == b || SamePointDetect(model.points[a], model.points[b]);
+            if (shared)
+                continue;
+            IntersectVector3 v[6];
+            for (int j = 0; j < 3; j++)
+            {
+                v[j] = {float(model.points[t0[j]][0]), float(model.points[t0[j]][1]), float(model.points[t0[j]][2])};
+                v[j + 3] = {float(model.points[t1[j]][0]), float(model.points[t1[j]][1]), float(model.points[t1[j]][2])};
+            }
+            if (threeyd::moeller::TriangleIntersects<IntersectVector3>::triangle(v[0], v[1], v[2], v[3], v[4], v[5]))
+                return true;
+        }
+        return false;
+    }
+};
+
+static void Run(const char *name, const Model &mesh)
+{
+    int hits_old = 0;
+    bool threw = false;
+    size_t nodes_old = 0, nodes_new = 0;
+    vector<pair<int, int>> pairs;
+    double build_old = BestOf(3, [&]
+                              { LegacyBVH bvh(mesh); nodes_old = bvh.nodesUsed; });
+    LegacyBVH legacy(mesh);
+    double query_old = BestOf(3, [&]
+                              {
+                                  hits_old = 0;
+                                  try
+                                  {
+                                      for (const vec3i &tri : legacy.model.triangles)
+                                          hits_old += legacy.Intersect(tri, 0);
+                                  }
+                                  catch (const std::logic_error &)
+                                  {
+                                      threw = true; // two degenerate triangles met in the Moeller test
+                                  }
+                              });
+    double build_new = BestOf(3, [&]
+                              { BVH bvh(mesh); nodes_new = bvh.bvhNode.size(); });
+    BVH bvh(mesh);
+    double query_new = BestOf(3, [&]
+                              { pairs.clear(); bvh.SelfIntersections(pairs); });
+    printf("%-22s %8zu %9.1f %9.1f %9.1f %9.1f %8.2f %8.2f %6s %6zu\n", name, mesh.triangles.size(), build_old, query_old, build_new, query_new,
+           nodes_old * sizeof(LegacyBVH::Node) / 1048576.0, nodes_new * sizeof(BVHNode) / 1048576.0, threw ? "throws" : std::to_string(hits_old).c_str(), pairs.size());
+}
+
+int main(int argc, char **argv)
+{
+    printf("%-22s %8s %9s %9s %9s %9s %8s %8s %6s %6s\n", "mesh", "tris", "old build", "old query", "new build", "new query", "old MB", "new MB", "hits", "pairs");
+    for (int n : {64, 256, 512})
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "torus %dx%d", n, n / 2);
+        Run(name, Torus(n, n / 2));
+    }
+    for (int i = 1; i < argc; i++)
+    {
+        Model mesh;
+        if (LoadMesh(argv[i], mesh))
+            Run(argv[i], mesh);
+    }
+    return 0;
+}
@@ -0,0 +1,104 @@
+// Hull simplification to max_ch_vertex 16-256: the edge collapse of DecimateCH (decimate.cpp) and the
+// vertex-budgeted hull of BudgetCH against the sort-every-step midpoint collapse they replaced, kept below as
+// LegacyDecimateCH. Prints ms per hull, volume relative to the input hull, and how far the input hull's vertices
+// end up outside the result, relative to its extent (<= 0: the result encloses the input).
+#include "bench.h"
+#include "hull.h"
+#include "process.h"
+
+using namespace coacd_bench;
+
+static double Dist(const vec3d &p, const vec3d &q)
+{
+    return sqrt(pow(p[0] - q[0], 2) + pow(p[1] - q[1], 2) + pow(p[2] - q[2], 2));
+}
+
+// DecimateCH before the heap-driven collapse: re-sorts every edge per collapse and merges at the edge midpoint
+static void LegacyDecimateCH(Model &ch, int tgt_pts, string apx_mode)
+{
+    if (tgt_pts >= (int)ch.points.size())
+        return;
+
+    vector<int> rm_pt_idxs;
+    int n_pts = (int)ch.points.size();
+    vector<pair<double, pair<int, int>>> edge_costs;
+    for (const vec3i &tri : ch.triangles)
+        for (int j = 0; j < 3; j++)
+            if (tri[j] > tri[(j + 1) % 3])
+                edge_costs.push_back({Dist(ch.points[tri[j]], ch.points[tri[(j + 1) % 3]]), {tri[j], tri[(j + 1) % 3]}});
+
+    while (n_pts > tgt_pts)
+    {
+        sort(edge_costs.begin(), edge_costs.end());
+        pair<int, int> edge = edge_costs[0].second;
+        vec3d new_pt = {0.5 * (ch.points[edge.first][0] + ch.points[edge.second][0]),
+                        0.5 * (ch.points[edge.first][1] + ch.points[edge.second][1]),
+                        0.5 * (ch.points[edge.first][2] + ch.points[edge.second][2])};
+        rm_pt_idxs.push_back(edge.first);
+        rm_pt_idxs.push_back(edge.second);
+        ch.points.push_back(new_pt);
+        n_pts -= 1;
+        edge_costs[0].first = INF;
+
+        int new_pt_idx = ch.points.size() - 1;
+        for (auto &e : edge_costs)
+        {
+            if (e.second.first == edge.first && e.second.second == edge.second)
+                e.first = INF;
+            else if (e.second.first == edge.first || e.second.first == edge.second)
+            {
+                e.first = Dist(new_pt, ch.points[e.second.second]);
+                e.second.first = new_pt_idx;
+            }
+            else if (e.second.second == edge.first || e.second.second == edge.second)
+            {
+                e.first = Dist(new_pt, ch.points[e.second.first]);
+                e.second.second = e.second.first;
+                e.second.first = new_pt_idx;
+            }
+        }
+    }
+
+    Model new_ch;
+    for (int i = 0; i < (int)ch.points.size(); i++)
+        if (find(rm_pt_idxs.begin(), rm_pt_idxs.end(), i) == rm_pt_idxs.end())
+            new_ch.points.push_back(ch.points[i]);
+    new_ch.ComputeAPX(ch, apx_mode, true);
+}
+
+int main()
+{
+    const int hulls = 6;
+    void (*engines[])(Model &, int, string) = {LegacyDecimateCH, DecimateCH, BudgetCH};
+    printf("%6s %4s   %-24s %-24s %-24s\n", "verts", "K", "legacy ms/vol/outside", "collapse ms/vol/outside", "hull ms/vol/outside");
+    for (int n : {200, 800, 2000})
+    {
+        std::mt19937 rng(n);
+        std::uniform_real_distribution<double> radius(0.2, 1.0);
+        std::vector<Model> inputs(hulls);
+        for (Model &ch : inputs)
+            ComputeHull(Ellipsoid(rng, n, radius(rng), radius(rng), radius(rng)), ch.points, ch.triangles);
+
+        for (int k : {16, 64, 256})
+        {
+            printf("%6d %4d", n, k);
+            for (auto engine : engines)
+            {
+                double ms = 0, vol = 0, outside = -INF;
+                for (const Model &input : inputs)
+                {
+                    Model ch = input;
+                    ms += BestOf(1, [&]
+                                 { engine(ch, k, "ch"); });
+                    vol += MeshVolume(ch) / MeshVolume(input) / hulls;
+                    const array<double, 6> &b = input.GetBounds();
+                    double extent = std::max({b[1] - b[0], b[3] - b[2], b[5] - b[4]});
+                    outside = std::max(outside, MaxOutside(input.points, ch.points, ch.triangles) / extent);
+                }
+                printf("   %7.1f %6.3f %9.1e", ms / hulls, vol, outside);
+            }
+            printf("\n");
+        }
+    }
+    return 0;
+}
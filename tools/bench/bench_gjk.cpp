@@ -0,0 +1,63 @@
+// Hull-to-hull distance for merge candidates: the vertex-to-vertex KD-tree MeshDist against GJKDistance on
+// hill-climbing supports. Every pair of a set of random ellipsoid hulls is queried, as EvaluateMergePairs does for
+// pairs that pass the box test. Prints the total time per hull size, and how GJK and MeshDist disagree.
+#include "bench.h"
+#include "cost.h"
+#include "gjk.h"
+#include "hull.h"
+
+using namespace coacd_bench;
+
+int main()
+{
+    const int hulls = 60;
+    printf("%8s %8s %12s %12s %12s   %s\n", "points", "pairs", "meshdist ms", "support ms", "gjk ms", "gjk > meshdist, max meshdist - gjk");
+    for (int n : {16, 64, 256, 1024})
+    {
+        std::mt19937 rng(n);
+        std::uniform_real_distribution<double> center(-2, 2), radius(0.2, 0.8);
+        std::vector<Model> chs(hulls);
+        for (Model &ch : chs)
+        {
+            std::vector<vec3d> points = Ellipsoid(rng, n, radius(rng), radius(rng), radius(rng));
+            vec3d c = {center(rng), center(rng), center(rng)};
+            for (vec3d &p : points)
+                p = {p[0] + c[0], p[1] + c[1], p[2] + c[2]};
+            ComputeHull(points, ch.points, ch.triangles);
+            ch.GetPointCloud(); // cached, as in the merge loop
+        }
+
+        std::vector<double> dist_mesh, dist_gjk;
+        double t_mesh = BestOf(3, [&]
+                               {
+                                   dist_mesh.clear();
+                                   for (int i = 0; i < hulls; i++)
+                                       for (int j = i + 1; j < hulls; j++)
+                                           dist_mesh.push_back(MeshDist(chs[i], chs[j]));
+                               });
+        std::vector<ConvexSupport> supports(hulls);
+        double t_support = BestOf(3, [&]
+                                  {
+                                      for (int i = 0; i < hulls; i++)
+                                          supports[i] = ConvexSupport(chs[i]);
+                                  });
+        double t_gjk = BestOf(3, [&]
+                              {
+                                  dist_gjk.clear();
+                                  for (int i = 0; i < hulls; i++)
+                                      for (int j = i + 1; j < hulls; j++)
+                                          dist_gjk.push_back(GJKDistance(supports[i], supports[j]));
+                              });
+
+        // GJK is the true distance, so it should never exceed the vertex-to-vertex one
+        int above = 0;
+        double gap = 0;
+        for (size_t k = 0; k < dist_gjk.size(); k++)
+        {
+            above += dist_gjk[k] > dist_mesh[k] + 1e-9;
+            gap = std::max(gap, dist_mesh[k] - dist_gjk[k]);
+        }
+        printf("%8d %8zu %12.1f %12.1f %12.1f   %d, %.3f\n", n, dist_gjk.size(), t_mesh, t_support, t_gjk, above, gap);
+    }
+    return 0;
+}
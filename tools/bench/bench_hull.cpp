@@ -0,0 +1,119 @@
+// Convex hull engines on point clouds of 8-2000 points: the robust double hull (hull.cpp), exact and with the 1e-9
+// tolerance of ComputeCH's fast path, against the float QuickHull and Bullet paths it replaced. Prints the total time
+// per set, the mean hull vertex count and how far input points end up outside each engine's hull, relative to the
+// cloud's extent.
+#include "bench.h"
+#include "hull.h"
+#include "quickhull/QuickHull.hpp"
+
+using namespace coacd_bench;
+
+static std::vector<vec3d> Cloud(std::mt19937 &rng, int set, int n)
+{
+    std::uniform_real_distribution<double> unit(-1, 1);
+    std::vector<vec3d> points;
+    switch (set)
+    {
+    case 0: // uniform cube
+        for (int i = 0; i < n; i++)
+            points.push_back({unit(rng), unit(rng), unit(rng)});
+        break;
+    case 1: // half of the points on a spherical cap
+        points = Ellipsoid(rng, n / 2, 1, 1, 1);
+        for (vec3d &p : points)
+            p[2] = fabs(p[2]);
+        for (int i = n / 2; i < n; i++)
+            points.push_back({0.5 * unit(rng), 0.5 * unit(rng), 0.5 * unit(rng)});
+        break;
+    case 2: // sliver 1e-9 thick
+        for (int i = 0; i < n; i++)
+            points.push_back({unit(rng), unit(rng), 1e-9 * unit(rng)});
+        break;
+    case 3: // coarse grid, many coplanar and duplicate points
+        for (int i = 0; i < n; i++)
+            points.push_back({double(rng() % 5), double(rng() % 5), double(rng() % 5)});
+        break;
+    default: // sphere
+        points = Ellipsoid(rng, n, 1, 1, 1);
+    }
+    return points;
+}
+
+static double Extent(const std::vector<vec3d> &points)
+{
+    double lo = 1e300, hi = -1e300;
+    for (const vec3d &p : points)
+        for (double x : p)
+            lo = std::min(lo, x), hi = std::max(hi, x);
+    return hi - lo;
+}
+
+int main()
+{
+    const char *names[] = {"uniform cube", "half on cap", "1e-9 sliver", "coarse grid", "sphere"};
+    const int clouds = 500;
+    printf("%-14s %9s %9s %9s %9s   %-23s   max outside / extent (exact, fast, qh-float, bullet)\n", "set", "exact ms", "fast ms", "qh ms",
+           "bullet ms", "mean vertices");
+    for (int set = 0; set < 5; set++)
+    {
+        std::mt19937 rng(set + 1);
+        std::vector<std::vector<vec3d>> inputs;
+        for (int i = 0; i < clouds; i++)
+            inputs.push_back(Cloud(rng, set, 8 + rng() % 1993));
+
+        double t_new = 0, t_fast = 0, t_qh = 0, t_bt = 0, out_new = 0, out_fast = 0, out_qh = 0, out_bt = 0;
+        size_t v_new = 0, v_fast = 0, v_qh = 0, v_bt = 0;
+        for (const std::vector<vec3d> &points : inputs)
+        {
+            double extent = Extent(points);
+            std::vector<vec3d> hp;
+            std::vector<vec3i> ht;
+            t_new += BestOf(1, [&]
+                            { hp.clear(); ht.clear(); ComputeHull(points, hp, ht); });
+            if (!ht.empty())
+                out_new = std::max(out_new, MaxOutside(points, hp, ht) / extent);
+            v_new += hp.size();
+
+            std::vector<vec3d> fp;
+            std::vector<vec3i> ft;
+            t_fast += BestOf(1, [&]
+                             { fp.clear(); ft.clear(); ComputeHull(points, fp, ft, -1, 1e-9); });
+            if (!ft.empty())
+                out_fast = std::max(out_fast, MaxOutside(points, fp, ft) / extent);
+            v_fast += fp.size();
+
+            std::vector<vec3d> qp;
+            std::vector<vec3i> qt;
+            t_qh += BestOf(1, [&]
+                           {
+                               quickhull::QuickHull<float> qh;
+                               std::vector<quickhull::Vector3<float>> cloud;
+                               for (const vec3d &p : points)
+                                   cloud.push_back(quickhull::Vector3<float>(p[0], p[1], p[2]));
+                               bool flag = true;
+                               auto hull = qh.getConvexHull(cloud, true, false, flag);
+                               qp.clear();
+                               qt.clear();
+                               for (const auto &v : hull.getVertexBuffer())
+                                   qp.push_back({v.x, v.y, v.z});
+                               const auto &index = hull.getIndexBuffer();
+                               for (size_t i = 0; i + 2 < index.size(); i += 3)
+                                   qt.push_back({(int)index[i + 2], (int)index[i + 1], (int)index[i]});
+                           });
+            if (!qt.empty())
+                out_qh = std::max(out_qh, MaxOutside(points, qp, qt) / extent);
+            v_qh += qp.size();
+
+            Model cloud, bt;
+            cloud.points = points;
+            t_bt += BestOf(1, [&]
+                           { bt = Model(); cloud.ComputeVCH(bt); });
+            if (!bt.triangles.empty())
+                out_bt = std::max(out_bt, MaxOutside(points, bt.points, bt.triangles) / extent);
+            v_bt += bt.points.size();
+        }
+        printf("%-14s %9.1f %9.1f %9.1f %9.1f   %5zu %5zu %5zu %5zu   %.1e %.1e %.1e %.1e\n", names[set], t_new, t_fast, t_qh, t_bt, v_new / clouds,
+               v_fast / clouds, v_qh / clouds, v_bt / clouds, out_new, out_fast, out_qh, out_bt);
+    }
+    return 0;
+}
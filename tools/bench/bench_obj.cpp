@@ -0,0 +1,116 @@
+// OBJ input: the memory-mapped, chunked from_chars parser of Model::LoadOBJ against the fgets/strtok reader it
+// replaced, kept below as LegacyLoadOBJ. Generated tori are written as triangles and as quads, then both readers
+// load them and the meshes given on the command line. Prints ms and MB/s, and the triangles each reader returns:
+// the old one keeps only faces of three or four corners.
+//     bench_obj [examples/*.obj]
+#include <filesystem>
+
+#include "bench.h"
+#include "io.h"
+
+using namespace coacd_bench;
+
+// LoadOBJ before the mapped parser: 1024-byte fgets lines tokenized with strtok, triangles and quads only (stops at
+// the fifth corner, where the original wrote past ip)
+static bool LegacyLoadOBJ(const string &fileName, Model &mesh)
+{
+    const unsigned int BufferSize = 1024;
+    FILE *fid = fopen(fileName.c_str(), "r");
+    if (!fid)
+        return false;
+    char buffer[BufferSize];
+    int ip[4];
+    double x[3];
+    char *pch;
+    char *str;
+    while (!feof(fid))
+    {
+        if (!fgets(buffer, BufferSize, fid))
+            break;
+        else if (buffer[0] == 'v')
+        {
+            if (buffer[1] == ' ')
+            {
+                str = buffer + 2;
+                for (int k = 0; k < 3; ++k)
+                {
+                    pch = strtok(str, " ");
+                    if (!pch)
+                    {
+                        fclose(fid);
+                        return false;
+                    }
+                    x[k] = (double)atof(pch);
+                    str = NULL;
+                }
+                mesh.points.push_back({x[0], x[1], x[2]});
+            }
+        }
+        else if (buffer[0] == 'f')
+        {
+            pch = str = buffer + 2;
+            int k = 0;
+            while (pch && k < 4)
+            {
+                pch = strtok(str, " ");
+                if (!pch || *pch == '\n')
+                    break;
+                ip[k++] = (unsigned int)atoi(pch) - 1;
+                str = NULL;
+            }
+            if (k == 3)
+                mesh.triangles.push_back({ip[0], ip[1], ip[2]});
+            else if (k == 4)
+            {
+                mesh.triangles.push_back({ip[0], ip[1], ip[2]});
+                mesh.triangles.push_back({ip[0], ip[2], ip[3]});
+            }
+        }
+    }
+    fclose(fid);
+    return true;
+}
+
+// Torus with each quad written as a polygon of four corners instead of two triangles
+static void SaveQuads(const string &fileName, int n, int m)
+{
+    Model mesh = Torus(n, m);
+    std::ofstream os(fileName);
+    for (const vec3d &p : mesh.points)
+        os << "v " << p[0] << " " << p[1] << " " << p[2] << "\n";
+    for (size_t i = 0; i < mesh.triangles.size(); i += 2)
+        os << "f " << mesh.triangles[i][0] + 1 << " " << mesh.triangles[i][1] + 1 << " " << mesh.triangles[i][2] + 1 << " " << mesh.triangles[i + 1][2] + 1 << "\n";
+}
+
+static void Run(const char *name, const string &fileName)
+{
+    double mb = std::filesystem::file_size(fileName) / 1048576.0;
+    size_t tris_old = 0, tris_new = 0;
+    double ms_old = BestOf(3, [&]
+                           { Model mesh; LegacyLoadOBJ(fileName, mesh); tris_old = mesh.triangles.size(); });
+    double ms_new = BestOf(3, [&]
+                           { Model mesh; mesh.LoadOBJ(fileName); tris_new = mesh.triangles.size(); });
+    printf("%-24s %8.1f %9.1f %8.1f %9.1f %8.1f %9zu %9zu\n", name, mb, ms_old, mb / ms_old * 1000, ms_new, mb / ms_new * 1000, tris_old, tris_new);
+}
+
+int main(int argc, char **argv)
+{
+    printf("%-24s %8s %9s %8s %9s %8s %9s %9s\n", "mesh", "MB", "old ms", "old MB/s", "new ms", "new MB/s", "old tris", "new tris");
+    std::filesystem::path dir = std::filesystem::temp_directory_path();
+    for (int n : {256, 1024, 2048})
+    {
+        char name[48];
+        string path = (dir / "coacd_bench_obj.obj").string();
+        Model torus = Torus(n, n / 2);
+        SaveMesh(path, torus);
+        snprintf(name, sizeof(name), "torus %dx%d", n, n / 2);
+        Run(name, path);
+        SaveQuads(path, n, n / 2);
+        snprintf(name, sizeof(name), "torus %dx%d quads", n, n / 2);
+        Run(name, path);
+        std::filesystem::remove(path);
+    }
+    for (int i = 1; i < argc; i++)
+        Run(argv[i], argv[i]);
+    return 0;
+}
@@ -0,0 +1,72 @@
+// Hb of a part and its convex hull, the per-part check of Compute: the KD-tree face_hausdorff_distance backend
+// against the narrow-band SDF backend (hb_mode "sdf", WITH_3RD_PARTY_LIBS only). Both run from cold caches on the same
+// parts: generated tori, pieces clipped off them and the meshes given on the command line. Prints ms per backend, the
+// field build alone, both Hb values and their difference against the sqrt(3)/2 * voxel bound of the field. Values
+// beyond the field's band (2 * threshold) are clamped there, so the difference is taken after clamping both.
+//     bench_sdf [examples/*.obj]
+#include "bench.h"
+#include "clip.h"
+#include "cost.h"
+#include "io.h"
+
+using namespace coacd_bench;
+
+static void Run(const char *name, const Model &part, Params &params)
+{
+    const Model &hull = part.GetHull();
+    double voxel = params.threshold * params.sdf_voxel_ratio, band = 2 * params.threshold;
+    double hb_kdtree = 0, hb_sdf = 0;
+
+    // fresh copies, so samples, KD-tree clouds and the field are rebuilt on every run as for a new part
+    double t_kdtree = BestOf(3, [&]
+                             { Model p = part, h = hull; hb_kdtree = ComputeHb(p, h, params.resolution, params.seed); });
+    double t_field = BestOf(3, [&]
+                            { Model p = part; p.GetDistanceField(voxel, band); });
+    double t_sdf = BestOf(3, [&]
+                          { Model p = part, h = hull; hb_sdf = ComputeHbSDF(p, h, params); });
+
+    double error = fabs(std::min(hb_sdf, band) - std::min(hb_kdtree, band)), bound = sqrt(3.0) / 2 * voxel;
+    printf("%-26s %8zu %10.1f %10.1f %10.1f %9.4f %9.4f %9.5f %9.5f %s\n", name, part.triangles.size(), t_kdtree, t_field, t_sdf, hb_kdtree, hb_sdf,
+           error, bound, error > bound ? "over" : "");
+}
+
+// The part itself and the two pieces of a cut at x = offset
+static void RunCuts(const char *name, const Model &part, Params &params)
+{
+    Run(name, part, params);
+    for (double offset : {0.2, 0.8})
+    {
+        Model pos, neg;
+        double cut_area;
+        Plane plane(1, 0, 0, -offset);
+        if (!Clip(part, pos, neg, plane, cut_area))
+            continue;
+        char piece[96];
+        snprintf(piece, sizeof(piece), "%.16s x>%.1f", name, offset);
+        Run(piece, pos, params);
+        snprintf(piece, sizeof(piece), "%.16s x<%.1f", name, offset);
+        Run(piece, neg, params);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Params params;
+    printf("threshold %.3f, voxel %.4f, band %.3f\n", params.threshold, params.threshold * params.sdf_voxel_ratio, 2 * params.threshold);
+    printf("%-26s %8s %10s %10s %10s %9s %9s %9s %9s\n", "part", "tris", "kdtree ms", "field ms", "sdf ms", "hb kdtree", "hb sdf", "error", "bound");
+    for (int n : {32, 64, 128})
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "torus %dx%d", n, n / 2);
+        RunCuts(name, Torus(n, n / 2), params);
+    }
+    for (int i = 1; i < argc; i++)
+    {
+        Model mesh;
+        if (!LoadMesh(argv[i], mesh))
+            continue;
+        mesh.Normalize();
+        RunCuts(argv[i], mesh, params);
+    }
+    return 0;
+}
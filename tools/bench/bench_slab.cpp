@@ -0,0 +1,81 @@
+// One mesh clipped by a family of parallel planes: a Clip call per plane against one ClipSlabs sweep. The families are
+// the ones the search clips: the two ternary probes of TernaryMCTS, the 0.01-spaced candidates of RefineMCTS around
+// the middle, and mcts_nodes planes over the whole extent as ComputeAxesAlignedClippingPlanes places them. Prints ms
+// for each, and whether every part and cut area came out identical.
+//     bench_slab [examples/*.obj]
+#include "bench.h"
+#include "clip.h"
+#include "io.h"
+
+using namespace coacd_bench;
+
+static bool Same(const Model &x, const Model &y)
+{
+    return x.points == y.points && x.triangles == y.triangles;
+}
+
+static void Run(const char *name, const Model &mesh)
+{
+    const array<double, 6> &bbox = mesh.GetBounds();
+    const double extent = bbox[1] - bbox[0], middle = (bbox[0] + bbox[1]) / 2, interval = extent / 21;
+    struct Family
+    {
+        const char *name;
+        vector<Plane> planes;
+    } families[3] = {{"ternary"}, {"refine"}, {"sweep"}};
+    families[0].planes = {Plane(1, 0, 0, -(bbox[0] + extent / 3)), Plane(1, 0, 0, -(bbox[0] + 2 * extent / 3))};
+    for (double x = middle - interval; x <= middle + interval; x += 0.01)
+        families[1].planes.push_back(Plane(1, 0, 0, -x));
+    for (double x = bbox[0] + interval; x <= bbox[1] - interval + 1e-6; x += interval)
+        families[2].planes.push_back(Plane(1, 0, 0, -x));
+
+    for (Family &family : families)
+    {
+        const int K = (int)family.planes.size();
+        vector<Model> pos(K), neg(K), slab_pos(K), slab_neg(K);
+        vector<double> area(K), slab_area(K);
+        double t_clip = BestOf(3, [&]
+                               {
+                                   for (int k = 0; k < K; k++)
+                                   {
+                                       pos[k] = Model();
+                                       neg[k] = Model();
+                                       Clip(mesh, pos[k], neg[k], family.planes[k], area[k]);
+                                   }
+                               });
+        double t_slab = BestOf(3, [&]
+                               {
+                                   ClipSlabs(mesh, family.planes, [&](int k, Model &p, Model &n, double cut_area, bool flag)
+                                             {
+                                                 slab_pos[k] = std::move(p);
+                                                 slab_neg[k] = std::move(n);
+                                                 slab_area[k] = cut_area;
+                                             });
+                               });
+        bool same = true;
+        for (int k = 0; k < K; k++)
+            same = same && Same(pos[k], slab_pos[k]) && Same(neg[k], slab_neg[k]) && area[k] == slab_area[k];
+        printf("%-22s %8zu %-8s %4d %10.2f %10.2f %7.2fx %5s\n", name, mesh.triangles.size(), family.name, K, t_clip, t_slab, t_clip / t_slab,
+               same ? "yes" : "NO");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    printf("%-22s %8s %-8s %4s %10s %10s %8s %5s\n", "mesh", "tris", "planes", "K", "clip ms", "slab ms", "speedup", "same");
+    for (int n : {64, 128, 256})
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "torus %dx%d", n, n / 2);
+        Run(name, Torus(n, n / 2));
+    }
+    for (int i = 1; i < argc; i++)
+    {
+        Model mesh;
+        if (!LoadMesh(argv[i], mesh))
+            continue;
+        mesh.Normalize();
+        Run(argv[i], mesh);
+    }
+    return 0;
+}